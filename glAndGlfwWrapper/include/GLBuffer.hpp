@@ -13,7 +13,9 @@ class GLBuffer
             Array,
             Element,
             ShaderStorage,
-            Uniform
+            Uniform,
+            PixelUnpack,
+            DrawIndirect
         };
 
         GLBuffer(e_Type type = e_Type::Array);
@@ -44,21 +46,43 @@ class GLBuffer
                 return false;
             }
 
-            bind();
-            glBufferData(sToGLenum(m_type), data.size() * sizeof(T), data.data(), usage);
+            glBufferData(bindForUpload(), data.size() * sizeof(T), data.data(), usage);
             m_count = static_cast<GLsizei>(data.size());
             return true;
         }
 
+        /**
+         * @param data pointer to the first element to write
+         * @param offset the index of the first element in the buffer to overwrite
+         * @param count the amount of elements to write
+         * @brief overwrites a range of the buffer with glBufferSubData, the storage is kept so attached vaos stay valid
+         * @return true when the range is written, false if the range falls outside the data given to setData
+         * @attention T needs to be the same type as the one the buffer was filled with through setData
+         */
+        template<typename T>
+        bool setSubData(const T* data, std::size_t offset, std::size_t count)
+        {
+            if (!data || 0 == count || offset + count > static_cast<std::size_t>(m_count))
+            {
+                std::cerr << "setSubData: range " << offset << " + " << count << " is outside the buffer of " << m_count << " elements" << std::endl;
+                return false;
+            }
+
+            glBufferSubData(bindForUpload(), offset * sizeof(T), count * sizeof(T), data);
+            return true;
+        }
+
         GLuint getId() const;
         GLsizei getCount() const;
         e_Type getType() const;
+
+        static GLenum sToGLenum(e_Type type);
     private:
         GLuint m_id;
         e_Type m_type;
         GLsizei m_count;
 
-        static GLenum sToGLenum(e_Type type);
+        GLenum bindForUpload() const;
 };
 
 #endif
\ No newline at end of file
@@ -2,12 +2,43 @@
 # define GLDEBUG_HPP
 
 # include <glad/glad.h>
+# include <cstddef>
+# include <ostream>
+# include <string>
+# include <vector>
 
 class GLDebug
 {
     public:
-        static void sEnable();
+        struct s_Message
+        {
+            GLenum source;
+            GLenum type;
+            GLuint id;
+            GLenum severity;
+            std::string text;
+        };
+
+        static bool sEnable(GLenum minSeverity = GL_DEBUG_SEVERITY_LOW, std::size_t capacity = 64);
+        static void sIgnore(const std::vector<GLuint>& ids);
+        static bool sIsEnabled();
+        static void sCheckErrors(const char* where);
+        static std::vector<s_Message> sGetMessages();
+        static std::size_t sGetDropped();
+        static void sDump(std::ostream& out);
         static void sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+    private:
+        struct s_Log
+        {
+            bool enabled = false;
+            std::vector<s_Message> messages;
+            std::size_t capacity = 0;
+            std::size_t head = 0; // next slot to write once the buffer is full
+            std::size_t dropped = 0;
+        };
+
+        static s_Log& sLog();
+        static void sPrint(std::ostream& out, const s_Message& message);
 };
 
 #endif
\ No newline at end of file
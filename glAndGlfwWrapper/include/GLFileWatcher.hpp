@@ -0,0 +1,40 @@
+#ifndef GLFILEWATCHER_HPP
+# define GLFILEWATCHER_HPP
+
+# include <atomic>
+# include <mutex>
+# include <string>
+# include <thread>
+# include <unordered_map>
+# include <unordered_set>
+# include <vector>
+
+class GLFileWatcher
+{
+    public:
+        GLFileWatcher();
+        GLFileWatcher(const GLFileWatcher& other) = delete;
+        ~GLFileWatcher();
+
+        GLFileWatcher& operator=(const GLFileWatcher& other) = delete;
+
+        bool setup();
+        bool watch(const std::string& filePath);
+        std::vector<std::string> poll();
+
+        static std::string sNormalize(const std::string& filePath);
+    private:
+        int m_inotifyFd;
+        int m_wakeFds[2];
+        std::thread m_thread;
+        std::atomic<bool> m_running;
+        std::mutex m_mutex;
+        std::unordered_map<int, std::string> m_directories;
+        std::unordered_set<std::string> m_files;
+        std::unordered_set<std::string> m_changed;
+
+        void run();
+        void stop();
+};
+
+#endif
\ No newline at end of file
@@ -13,6 +13,7 @@ struct s_VertexAttribute
     GLboolean normalized;
     GLsizei stride; // in bytes
     std::size_t offset; // in bytes
+    GLuint divisor = 0; // 0 advances per vertex, n advances once every n instances
 };
 
 class GLMesh
@@ -30,6 +31,8 @@ class GLMesh
         bool attachVertexBuffer(const GLBuffer& buffer, const std::vector<s_VertexAttribute>& attributes);
         bool attachElementBuffer(const GLBuffer& buffer);
         void draw(GLenum mode = GL_TRIANGLES, GLsizei count = 0, GLenum indexType = GL_UNSIGNED_INT) const;
+        void drawInstanced(GLsizei instanceCount, GLenum mode = GL_TRIANGLES, GLsizei count = 0, GLenum indexType = GL_UNSIGNED_INT) const;
+        void drawRange(GLuint firstIndex, GLsizei count, GLenum mode = GL_TRIANGLES, GLenum indexType = GL_UNSIGNED_INT) const;
         void bind() const;
         void unbind() const;
 
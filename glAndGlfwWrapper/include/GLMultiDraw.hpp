@@ -0,0 +1,53 @@
+#ifndef GLMULTIDRAW_HPP
+# define GLMULTIDRAW_HPP
+
+# include <glad/glad.h>
+# include <vector>
+# include "GLBuffer.hpp"
+# include "GLMesh.hpp"
+
+/**
+ * a list of indexed draws into one shared vertex and element buffer, submitted with a single multi draw call.
+ * With ARB_multi_draw_indirect the commands live in a GL_DRAW_INDIRECT_BUFFER, otherwise they are passed as arrays
+ */
+class GLMultiDraw
+{
+    public:
+        // same layout as DrawElementsIndirectCommand
+        struct s_Command
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        GLMultiDraw();
+        GLMultiDraw(const GLMultiDraw& other) = delete;
+        ~GLMultiDraw() = default;
+
+        GLMultiDraw& operator=(const GLMultiDraw& other) = delete;
+
+        bool setup();
+        bool setCommands(const std::vector<s_Command>& commands, GLenum indexType = GL_UNSIGNED_INT);
+        void draw(const GLMesh& mesh, GLenum mode = GL_TRIANGLES) const;
+
+        GLsizei getCommandCount() const;
+        bool isIndirect() const;
+
+        static bool sHasIndirect();
+    private:
+        GLBuffer m_commandBuffer;
+        std::vector<s_Command> m_commands;
+        std::vector<GLsizei> m_counts;
+        std::vector<const void*> m_offsets;
+        std::vector<GLint> m_baseVertices;
+        GLenum m_indexType;
+        bool m_indirect;
+        bool m_instanced;
+
+        static std::size_t sIndexSize(GLenum indexType);
+};
+
+#endif
\ No newline at end of file
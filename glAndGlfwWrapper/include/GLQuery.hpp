@@ -0,0 +1,52 @@
+#ifndef GLQUERY_HPP
+# define GLQUERY_HPP
+
+# include <glad/glad.h>
+# include <cstddef>
+# include <vector>
+
+/**
+ * a pool of query objects of one target. Results are only read once gl reports them available, so polling never stalls
+ * the cpu, and occlusion queries can drive conditional rendering without the cpu ever seeing their result
+ */
+class GLQuery
+{
+    public:
+        GLQuery();
+        GLQuery(const GLQuery& other) = delete;
+        GLQuery(GLQuery&& other);
+        ~GLQuery();
+
+        GLQuery& operator=(const GLQuery& other) = delete;
+        GLQuery& operator=(GLQuery&& other);
+
+        bool setup(std::size_t count, GLenum target);
+        void begin(std::size_t index);
+        void end();
+        bool poll(std::size_t index, GLuint& result);
+        bool isPending(std::size_t index) const;
+        bool wasIssued(std::size_t index) const;
+        void beginConditionalRender(std::size_t index, GLenum mode = GL_QUERY_NO_WAIT) const;
+        void endConditionalRender() const;
+
+        std::size_t size() const;
+        GLenum getTarget() const;
+
+        static GLenum sOcclusionTarget();
+    private:
+        enum e_State : unsigned char
+        {
+            Unused, // never begun, gl has no object behind the name yet
+            Pending, // ended, the result hasn't been read
+            Ready // the last result was read
+        };
+
+        std::vector<GLuint> m_ids;
+        std::vector<e_State> m_states;
+        GLenum m_target;
+        std::size_t m_active;
+
+        void cleanup();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef GLSAMPLER_HPP
+# define GLSAMPLER_HPP
+
+# include <glad/glad.h>
+
+class GLSampler
+{
+    public:
+        GLSampler();
+        GLSampler(const GLSampler& other) = delete;
+        GLSampler(GLSampler&& other);
+        ~GLSampler();
+
+        GLSampler& operator=(const GLSampler& other) = delete;
+        GLSampler& operator=(GLSampler&& other);
+
+        bool setup(GLint minFilter = GL_LINEAR_MIPMAP_LINEAR, GLint magFilter = GL_LINEAR, GLint wrap = GL_REPEAT);
+        void bind(GLuint unit) const;
+        void unbind(GLuint unit) const;
+
+        GLuint getId() const;
+    private:
+        GLuint m_id;
+};
+
+#endif
\ No newline at end of file
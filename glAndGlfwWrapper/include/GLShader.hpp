@@ -2,15 +2,17 @@
 # define GLSHADER_HPP
 
 # include <string>
+# include <cstdint>
 # include <glad/glad.h>
 # include <type_traits>
 # include <unordered_map>
 # include <vector>
+# include <iostream>
 
 struct s_vec2 { float x, y; };
 struct s_vec3 { float x, y, z; };
 struct s_vec4 { float x, y, z, w; };
-struct s_mat4 { float m[4][4]; };
+struct alignas(16) s_mat4 { float m[4][4]; }; // aligned so its rows load straight into 4 wide registers
 struct s_quat { float w, x, y, z; };
 
 template<typename T> struct is_vec2 : std::false_type {};
@@ -27,18 +29,55 @@ template<> struct is_quat<s_quat> : std::true_type {};
 
 template<class> struct always_false : std::false_type {};
 
+template<typename T> struct is_uniform_type : std::bool_constant<
+    std::is_same_v<T, int> || std::is_same_v<T, float> ||
+    is_vec2<T>::value || is_vec3<T>::value || is_vec4<T>::value ||
+    is_mat4<T>::value || is_quat<T>::value> {};
+
+struct s_UniformInfo
+{
+    GLint location; // -1 when the uniform is not active
+    GLenum type; // GL_FLOAT_MAT4, GL_SAMPLER_2D, etc.
+    GLint size; // array size, 1 for non arrays
+};
+
+/**
+ * typed handle to a uniform location, resolved once with GLShader::getUniform so setting it is a plain integer upload
+ */
+template<typename T>
+class GLUniform
+{
+    static_assert(is_uniform_type<T>::value, "Unsupported uniform type");
+
+    public:
+        GLUniform(): m_location(-1) {}
+        explicit GLUniform(GLint location): m_location(location) {}
+
+        GLint getLocation() const { return m_location; }
+        bool isValid() const { return -1 != m_location; }
+    private:
+        GLint m_location;
+};
+
 class GLShader
 {
     public:
         GLShader();
+        GLShader(const GLShader& other) = delete;
         ~GLShader();
 
+        GLShader& operator=(const GLShader& other) = delete;
+
         bool setup(const std::string& vertexFilePath, const std::string& fragmentFilePath);
+        bool setupFromSource(const std::string& vertexSource, const std::string& fragmentSource);
+        void setBinaryCacheDir(const std::string& directory);
         void bind() const;
         void unbind() const;
         GLuint getProgramId() const;
         GLuint compileShader(GLenum type, const std::string& source);
         bool linkProgram();
+        bool hasUniform(const std::string& name) const;
+        bool setUniformBlockBinding(const std::string& blockName, GLuint bindingPoint) const;
         void attachShader(GLuint shader);
         
         static std::string sShaderTypeToString(GLenum type);
@@ -52,8 +91,90 @@ class GLShader
         template<typename T>
         void setUniform(const std::string& name, const T& value)
         {
-            GLint location = getUniformLocation(name);
+            sUpload(getUniformLocation(name), value);
+        }
+
+        /**
+         * @param uniform the handle returned by getUniform
+         * @param value the value the uniform will get
+         * @brief uploads the value to the location of the handle without any lookup
+         * @warning the value has to match the type of the handle, a GLUniform<s_mat4> can't be set with a s_vec4
+         */
+        template<typename T>
+        void setUniform(GLUniform<T> uniform, const std::type_identity_t<T>& value) const
+        {
+            sUpload(uniform.getLocation(), value);
+        }
+
+        /**
+         * @param name the name of the uniform
+         * @brief resolves the uniform once and checks the GLSL type of the uniform against T
+         * @return a handle to the uniform, or an invalid handle (location -1, uploads are ignored) if the uniform doesn't exist or has another type
+         */
+        template<typename T>
+        GLUniform<T> getUniform(const std::string& name)
+        {
+            const s_UniformInfo& info = getUniformInfo(name);
+            if (-1 == info.location)
+                return GLUniform<T>();
+
+            if (!sTypeMatches<T>(info.type))
+            {
+                std::cerr << "Warning: uniform '" << name << "' has type 0x" << std::hex << info.type << std::dec << " which doesn't match the handle type" << std::endl;
+                return GLUniform<T>();
+            }
+            return GLUniform<T>(info.location);
+        }
+    private:
+        GLuint m_program;
+        std::unordered_map<std::string, s_UniformInfo> m_uniformCache;
+        std::vector<GLuint> m_shaders;
+        std::string m_cacheDir;
+
+        GLint getUniformLocation(const std::string& name);
+        const s_UniformInfo& getUniformInfo(const std::string& name);
+        void reflectUniforms();
+        bool checkCompileErrors(GLuint object, GLenum type, bool isProgram);
+        bool loadProgramBinary(const std::string& path, std::uint64_t key);
+        void saveProgramBinary(const std::string& path, std::uint64_t key) const;
+        static bool sIsSamplerType(GLenum type);
+        static bool sBinaryCacheSupported();
+        static std::uint64_t sBinaryCacheKey(const std::string& vertexSource, const std::string& fragmentSource);
+        static std::string sBinaryCachePath(const std::string& directory, std::uint64_t key);
+
+        /**
+         * @param type the GLSL type reported by glGetActiveUniform
+         * @brief checks if values of T can be uploaded to a uniform of the given type
+         * @return true if the types are compatible, else false
+         */
+        template<typename T>
+        static bool sTypeMatches(GLenum type)
+        {
+            if constexpr (std::is_same_v<T, int>)
+                return GL_INT == type || GL_BOOL == type || sIsSamplerType(type);
+            else if constexpr (std::is_same_v<T, float>)
+                return GL_FLOAT == type;
+            else if constexpr (is_vec2<T>::value)
+                return GL_FLOAT_VEC2 == type;
+            else if constexpr (is_vec3<T>::value)
+                return GL_FLOAT_VEC3 == type;
+            else if constexpr (is_vec4<T>::value || is_quat<T>::value)
+                return GL_FLOAT_VEC4 == type;
+            else if constexpr (is_mat4<T>::value)
+                return GL_FLOAT_MAT4 == type;
+            else
+                static_assert(always_false<T>::value, "Unsupported uniform type");
+        }
 
+        /**
+         * @param location the location of the uniform in the bound program
+         * @param value the value the uniform will get
+         * @brief calls the glUniform function that belongs to the type of value
+         * @warning static_assert will check if passed values are support
+         */
+        template<typename T>
+        static void sUpload(GLint location, const T& value)
+        {
             if constexpr (std::is_same_v<T, int>)
                 glUniform1i(location, value);
             else if constexpr (std::is_same_v<T , float>)
@@ -71,13 +192,6 @@ class GLShader
             else
                 static_assert(always_false<T>::value, "Unsupported uniform type");
         }
-    private:
-        GLuint m_program;
-        std::unordered_map<std::string, GLint> m_uniformCache;
-        std::vector<GLuint> m_shaders;
-
-        GLint getUniformLocation(const std::string& name);
-        bool checkCompileErrors(GLuint object, GLenum type, bool isProgram);
 };
 
 #endif
\ No newline at end of file
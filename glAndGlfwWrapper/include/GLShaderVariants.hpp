@@ -0,0 +1,59 @@
+#ifndef GLSHADERVARIANTS_HPP
+# define GLSHADERVARIANTS_HPP
+
+# include <cstdint>
+# include <memory>
+# include <string>
+# include <unordered_map>
+# include <utility>
+# include <vector>
+# include "GLShader.hpp"
+
+struct s_ShaderSources
+{
+    std::string vertex;
+    std::string fragment;
+    std::vector<std::string> files; // every file that was read, includes too
+};
+
+class GLShaderVariants
+{
+    public:
+        GLShaderVariants();
+        GLShaderVariants(const GLShaderVariants& other) = delete;
+        ~GLShaderVariants() = default;
+
+        GLShaderVariants& operator=(const GLShaderVariants& other) = delete;
+
+        bool setup(const std::string& vertexFilePath, const std::string& fragmentFilePath, const std::vector<std::string>& features);
+        void setBinaryCacheDir(const std::string& directory);
+        void addUniformBlock(const std::string& blockName, GLuint bindingPoint);
+        void addSampler(const std::string& name, int unit);
+        bool prebuild(const std::vector<std::uint32_t>& masks);
+        GLShader* get(std::uint32_t mask);
+        bool reload(const s_ShaderSources& sources);
+
+        const std::string& getVertexPath() const;
+        const std::string& getFragmentPath() const;
+        const std::vector<std::string>& getSourceFiles() const;
+        unsigned int getGeneration() const;
+
+        static bool sLoadSources(const std::string& vertexFilePath, const std::string& fragmentFilePath, s_ShaderSources& out);
+        static bool sResolveIncludes(const std::string& filePath, std::string& out);
+        static std::string sInjectDefines(const std::string& source, const std::vector<std::string>& defines);
+    private:
+        std::string m_vertexPath;
+        std::string m_fragmentPath;
+        s_ShaderSources m_sources;
+        unsigned int m_generation;
+        std::vector<std::string> m_features;
+        std::vector<std::pair<std::string, GLuint>> m_uniformBlocks;
+        std::vector<std::pair<std::string, int>> m_samplers;
+        std::unordered_map<std::uint32_t, std::unique_ptr<GLShader>> m_programs;
+        std::string m_cacheDir;
+
+        std::unique_ptr<GLShader> build(const s_ShaderSources& sources, std::uint32_t mask) const;
+        static bool sResolveIncludes(const std::string& filePath, std::string& out, std::vector<std::string>& stack, std::vector<std::string>* files);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef GLSTATE_HPP
+# define GLSTATE_HPP
+
+# include <glad/glad.h>
+# include <cstdint>
+# include <unordered_map>
+
+/**
+ * shadows the gl binding and capability state of the current context, the wrapper classes bind through it so calls
+ * that wouldn't change anything are skipped. Objects have to be forgotten when they are deleted since gl reuses names
+ */
+class GLState
+{
+    public:
+        struct s_CallStats
+        {
+            unsigned int requested; // calls the wrapper asked for
+            unsigned int issued; // calls that reached gl
+        };
+
+        static void sUseProgram(GLuint program);
+        static void sBindVertexArray(GLuint vertexArray);
+        static void sBindBuffer(GLenum target, GLuint buffer);
+        static void sBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+        static void sActiveTexture(GLuint unit);
+        static void sBindTexture(GLenum target, GLuint texture);
+        static void sBindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+        static void sBindSampler(GLuint unit, GLuint sampler);
+        static void sEnable(GLenum capability);
+        static void sDisable(GLenum capability);
+        static void sDepthFunc(GLenum func);
+        static void sFrontFace(GLenum mode);
+        static void sColorMask(bool write);
+        static void sDepthMask(bool write);
+
+        static void sForgetProgram(GLuint program);
+        static void sForgetVertexArray(GLuint vertexArray);
+        static void sForgetBuffer(GLuint buffer);
+        static void sForgetTexture(GLuint texture);
+        static void sForgetSampler(GLuint sampler);
+        static void sInvalidate();
+
+        static void sCount(unsigned int calls = 1);
+        static s_CallStats sEndFrame();
+    private:
+        struct s_State
+        {
+            GLuint program;
+            GLuint vertexArray;
+            GLuint activeUnit;
+            GLenum depthFunc;
+            GLenum frontFace;
+            GLuint colorMask;
+            GLuint depthMask;
+            std::unordered_map<GLenum, GLuint> buffers;
+            std::unordered_map<std::uint64_t, GLuint> textures;
+            std::unordered_map<GLuint, GLuint> samplers;
+            std::unordered_map<GLenum, bool> capabilities;
+            s_CallStats frame;
+        };
+
+        static s_State& sState();
+        static bool sChanged(GLuint& shadow, GLuint value);
+};
+
+#endif
\ No newline at end of file
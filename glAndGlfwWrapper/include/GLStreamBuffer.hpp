@@ -0,0 +1,64 @@
+#ifndef GLSTREAMBUFFER_HPP
+# define GLSTREAMBUFFER_HPP
+
+# include <glad/glad.h>
+# include <vector>
+# include <iostream>
+# include "GLBuffer.hpp"
+
+class GLStreamBuffer
+{
+    public:
+        GLStreamBuffer(GLBuffer::e_Type type = GLBuffer::e_Type::Array, unsigned int regionCount = 3);
+        GLStreamBuffer(const GLStreamBuffer& other) = delete;
+        GLStreamBuffer(GLStreamBuffer&& other);
+        ~GLStreamBuffer();
+
+        GLStreamBuffer& operator=(const GLStreamBuffer& other) = delete;
+        GLStreamBuffer& operator=(GLStreamBuffer&& other);
+
+        bool setup(GLsizeiptr regionSize);
+
+        void* beginWrite();
+        void endWrite();
+        void finishRegion();
+        bool write(const void* data, GLsizeiptr size);
+
+        /**
+         * @param data a vector with the data for the current region
+         * @brief copies the data into the current region of the ring
+         * @return true if the data is written, false if data is empty or bigger then a region
+         */
+        template<typename T>
+        bool write(const std::vector<T>& data)
+        {
+            if (data.empty())
+            {
+                std::cerr << "write: data vector cannot be empty" << std::endl;
+                return false;
+            }
+            return write(data.data(), static_cast<GLsizeiptr>(data.size() * sizeof(T)));
+        }
+
+        void bind() const;
+        void bindRange(GLuint index) const;
+
+        GLuint getId() const;
+        GLintptr getOffset() const;
+        GLsizeiptr getRegionSize() const;
+        bool isPersistent() const;
+    private:
+        GLBuffer m_buffer;
+        GLsizeiptr m_regionSize;
+        unsigned int m_regionCount;
+        unsigned int m_region;
+        unsigned char* m_mapped;
+        bool m_persistent;
+        std::vector<GLsync> m_fences;
+
+        GLsizeiptr getOffsetAlignment() const;
+        void waitForRegion(unsigned int region);
+        void deleteFences();
+};
+
+#endif
\ No newline at end of file
@@ -4,11 +4,22 @@
 #include <string>
 #include <glad/glad.h>
 #include <vector>
+#include <future>
+#include <memory>
 #include "GLShader.hpp"
+#include "GLBuffer.hpp"
 
 class GLTexture
 {
     public:
+        struct s_Image
+        {
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            std::vector<unsigned char> pixels;
+        };
+
         GLTexture();
         GLTexture(GLTexture&& other);
         ~GLTexture();
@@ -16,19 +27,39 @@ class GLTexture
         GLTexture& operator=(GLTexture&& other);
 
         bool setup(const std::string& path);
+        bool setupAsync(const std::string& path);
+        bool setupAsync(std::unique_ptr<s_Image> image);
         bool loadFromFile(const std::string& path);
+        bool loadFromImage(const s_Image& image);
+        bool loadFromContainer(const std::string& path);
+        bool update();
+        bool isLoading() const;
         void bind(unsigned int slot = 0) const;
         void unbind() const;
-        void generateTexCoordPerFace(const std::vector<unsigned int>& indices, std::vector<s_vec2>& out);
-        void generateTexCoordGlobal(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& indices, std::vector<s_vec2>& out);
 		GLuint getTextureId();
+
+        static bool sDecode(const std::string& path, s_Image& image);
+        static void sGenerateTexCoordPerFace(const std::vector<unsigned int>& indices, std::vector<s_vec2>& out);
+        static void sGenerateTexCoordGlobal(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& indices, std::vector<s_vec2>& out);
     private:
         GLuint m_textureId;
         int m_width;
         int m_height;
         int m_channels;
+        std::future<std::unique_ptr<s_Image>> m_decode;
+        GLBuffer m_unpackBuffer;
+        std::unique_ptr<s_Image> m_pending;
+        GLuint m_pendingId;
+        GLsync m_pendingFence;
 
         void freeTexture();
+        void freePending();
+        bool createPlaceholder();
+        bool uploadPending(std::unique_ptr<s_Image> image);
+        static void sFormats(int channels, GLenum& internalFormat, GLenum& format);
+        static GLsizei sLevelCount(int width, int height);
+        static void sAllocateStorage(GLsizei levels, int channels, int width, int height);
+        static void sUploadBaseLevel(int channels, int width, int height, const void* pixels);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef GLTEXTURECONTAINER_HPP
+# define GLTEXTURECONTAINER_HPP
+
+# include <glad/glad.h>
+# include <cstddef>
+# include <cstdint>
+# include <string>
+# include <vector>
+
+/**
+ * .stex texture container: a header, one level entry per mip and the level data, each level already in its final gl internal format
+ */
+class GLTextureContainer
+{
+    public:
+        struct s_Header
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t internalFormat;
+            std::uint32_t format; // pixel format of uncompressed levels, 0 when compressed
+            std::uint32_t width;
+            std::uint32_t height;
+            std::uint32_t levelCount;
+            std::uint32_t compressed;
+        };
+
+        struct s_Level
+        {
+            std::uint32_t width;
+            std::uint32_t height;
+            std::uint64_t offset; // from the start of the file
+            std::uint64_t size;
+        };
+
+        GLTextureContainer();
+        GLTextureContainer(const GLTextureContainer& other) = delete;
+        GLTextureContainer(GLTextureContainer&& other);
+        ~GLTextureContainer();
+
+        GLTextureContainer& operator=(const GLTextureContainer& other) = delete;
+        GLTextureContainer& operator=(GLTextureContainer&& other);
+
+        bool open(const std::string& path);
+        void close();
+
+        const s_Header& getHeader() const;
+        const s_Level& getLevel(std::uint32_t level) const;
+        const unsigned char* getLevelData(std::uint32_t level) const;
+        std::size_t getDataSize() const;
+
+        static bool sBake(const unsigned char* pixels, int width, int height, int channels, bool compress, std::vector<unsigned char>& out);
+    private:
+        const unsigned char* m_data;
+        std::size_t m_size;
+        bool m_mapped;
+        std::vector<unsigned char> m_buffer;
+        s_Header m_header;
+        std::vector<s_Level> m_levels;
+
+        bool validate(const std::string& path);
+        static std::uint64_t sLevelSize(const s_Header& header, std::uint32_t width, std::uint32_t height);
+        static std::vector<unsigned char> sDownsample(const std::vector<unsigned char>& rgba, std::uint32_t width, std::uint32_t height);
+        static std::vector<unsigned char> sCompressBC1(const std::vector<unsigned char>& rgba, std::uint32_t width, std::uint32_t height);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef GLTEXTUREMANAGER_HPP
+# define GLTEXTUREMANAGER_HPP
+
+# include <glad/glad.h>
+# include <cstdint>
+# include <future>
+# include <memory>
+# include <string>
+# include <unordered_map>
+# include <vector>
+# include "GLBuffer.hpp"
+# include "GLTexture.hpp"
+
+/**
+ * owns one GL_TEXTURE_2D_ARRAY that all material textures are packed into, so switching material only changes
+ * the uv rect and layer given to the shader and never the bound texture
+ */
+class GLTextureManager
+{
+    public:
+        GLTextureManager();
+        GLTextureManager(const GLTextureManager& other) = delete;
+        ~GLTextureManager();
+
+        GLTextureManager& operator=(const GLTextureManager& other) = delete;
+
+        bool setup(GLsizei layerSize = 1024, GLsizei layerCount = 4, std::size_t budget = 0);
+        int load(const std::string& path);
+        void update();
+        bool getRegion(int id, s_vec4& rect, float& layer);
+        bool isResident(int id) const;
+        void bind(unsigned int slot = 0) const;
+
+        std::size_t getResidentBytes() const;
+        std::size_t getBudget() const;
+
+        static bool sLoadImage(const std::string& path, std::vector<GLTexture::s_Image>& levels);
+    private:
+        struct s_Decoded
+        {
+            GLsizei width; // without the padding
+            GLsizei height;
+            std::uint64_t hash;
+            std::vector<unsigned char> levels; // every level of the array padded, one after the other
+        };
+
+        struct s_Slot
+        {
+            std::uint64_t hash;
+            GLint layer;
+            GLsizei x;
+            GLsizei y;
+            GLsizei width; // without the padding
+            GLsizei height;
+            std::size_t bytes;
+            std::uint64_t lastUsed;
+            bool used;
+        };
+
+        struct s_Entry
+        {
+            std::string path;
+            int slot = -1;
+            bool failed = false;
+            std::future<std::unique_ptr<s_Decoded>> decode;
+        };
+
+        struct s_Shelf
+        {
+            GLsizei y;
+            GLsizei height;
+            GLsizei x;
+        };
+
+        struct s_Layer
+        {
+            std::vector<s_Shelf> shelves;
+            GLsizei top = 0;
+            unsigned int slots = 0;
+        };
+
+        GLuint m_textureId;
+        GLsizei m_layerSize;
+        GLsizei m_levels;
+        std::size_t m_budget;
+        std::size_t m_residentBytes;
+        std::uint64_t m_frame;
+        std::vector<s_Layer> m_layers;
+        std::vector<s_Slot> m_slots;
+        std::vector<s_Entry> m_entries;
+        std::unordered_map<std::string, int> m_paths;
+        std::unordered_map<std::uint64_t, int> m_hashes;
+        GLBuffer m_unpackBuffer;
+
+        void startDecode(s_Entry& entry);
+        int place(const s_Decoded& decoded);
+        bool allocate(GLsizei width, GLsizei height, GLint& layer, GLsizei& x, GLsizei& y);
+        bool evictLeastRecentlyUsed();
+        void evict(int slot);
+        void upload(const s_Decoded& decoded, GLint layer, GLsizei x, GLsizei y);
+        void freeTexture();
+        static std::unique_ptr<s_Decoded> sPrepare(const std::vector<GLTexture::s_Image>& levels, GLsizei levelCount);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef GLUNIFORMBLOCK_HPP
+# define GLUNIFORMBLOCK_HPP
+
+# include <glad/glad.h>
+# include <string>
+# include <type_traits>
+# include "GLStreamBuffer.hpp"
+# include "GLShader.hpp"
+
+class GLUniformBlock
+{
+    public:
+        GLUniformBlock(GLuint bindingPoint = 0);
+        GLUniformBlock(const GLUniformBlock& other) = delete;
+        GLUniformBlock(GLUniformBlock&& other) = default;
+        ~GLUniformBlock() = default;
+
+        GLUniformBlock& operator=(const GLUniformBlock& other) = delete;
+        GLUniformBlock& operator=(GLUniformBlock&& other) = default;
+
+        bool setup(GLsizeiptr size);
+        bool attach(const GLShader& shader, const std::string& blockName) const;
+        void finishFrame();
+        GLuint getBindingPoint() const;
+
+        /**
+         * @param data the std140 laid out struct with the block contents
+         * @brief writes the struct into the next region of the ring and binds that region to the binding point
+         * @return true if the block is updated, false if the struct doesn't fit the block or mapping failed
+         * @warning the layout of T must match the std140 layout of the block in the shader
+         */
+        template<typename T>
+        bool update(const T& data)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "uniform block data must be trivially copyable");
+
+            if (!m_stream.write(&data, static_cast<GLsizeiptr>(sizeof(T))))
+                return false;
+            m_stream.bindRange(m_bindingPoint);
+            return true;
+        }
+    private:
+        GLStreamBuffer m_stream;
+        GLuint m_bindingPoint;
+};
+
+#endif
\ No newline at end of file
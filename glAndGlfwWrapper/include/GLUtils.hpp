@@ -3,12 +3,15 @@
 
 # include <string>
 # include <vector>
+# include <cstdint>
 
 class GLUtils
 {
     public:
         static bool sReadShaderFile(const char* path, std::vector<unsigned char>& buffer);
         static bool sReadTexture(const char* path, std::vector<unsigned char>& buffer);
+        static bool sWriteFile(const char* path, const std::vector<unsigned char>& buffer);
+        static std::uint64_t sHash(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ULL);
 };
 
 #endif
\ No newline at end of file
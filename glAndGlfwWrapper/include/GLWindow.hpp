@@ -24,6 +24,8 @@ class GLWindow
         bool isKeyPressed(int key) const;
         GLFWkeyfun setKeyCallback(GLFWkeyfun callback);
         GLFWcursorposfun setCursorCallback(GLFWcursorposfun callback);
+        GLFWmousebuttonfun setMouseButtonCallback(GLFWmousebuttonfun callback);
+        void getCursorPos(double& x, double& y) const;
 
         void setClearColor(float red, float green, float blue, float alpha);
         void clear(bool color = true, bool depth = true) const;
@@ -1,4 +1,5 @@
 #include "GLBuffer.hpp"
+#include "GLState.hpp"
 #include <stdexcept>
 #include <string>
 
@@ -27,7 +28,10 @@ m_count(other.m_count)
 GLBuffer::~GLBuffer()
 {
     if (0 != m_id)
+    {
+        GLState::sForgetBuffer(m_id);
         glDeleteBuffers(1, &m_id);
+    }
 }
 
 /**
@@ -40,7 +44,10 @@ GLBuffer& GLBuffer::operator=(GLBuffer&& other)
     if (this != &other)
     {
         if (0 != m_id)
+        {
+            GLState::sForgetBuffer(m_id);
             glDeleteBuffers(1, &m_id);
+        }
         
         m_id = other.m_id;
         m_type = other.m_type;
@@ -69,7 +76,7 @@ bool GLBuffer::setup()
  */
 void GLBuffer::bind() const
 {
-    glBindBuffer(sToGLenum(m_type), m_id);
+    GLState::sBindBuffer(sToGLenum(m_type), m_id);
 }
 
 /**
@@ -77,7 +84,18 @@ void GLBuffer::bind() const
  */
 void GLBuffer::unbind() const
 {
-    glBindBuffer(sToGLenum(m_type), 0);
+    GLState::sBindBuffer(sToGLenum(m_type), 0);
+}
+
+/**
+ * @brief binds the buffer to GL_COPY_WRITE_BUFFER to write its data. No draw reads that target, so uploading never replaces
+ * the index buffer of the vertex array the last draw left bound, and a core context has no default vertex array to bind instead
+ * @return the target the buffer is bound to
+ */
+GLenum GLBuffer::bindForUpload() const
+{
+    GLState::sBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+    return GL_COPY_WRITE_BUFFER;
 }
 
 /**
@@ -124,6 +142,10 @@ GLenum GLBuffer::sToGLenum(e_Type type)
             return GL_SHADER_STORAGE_BUFFER;
         case e_Type::Uniform:
             return GL_UNIFORM_BUFFER;
+        case e_Type::PixelUnpack:
+            return GL_PIXEL_UNPACK_BUFFER;
+        case e_Type::DrawIndirect:
+            return GL_DRAW_INDIRECT_BUFFER;
         default:
             return GL_ARRAY_BUFFER;
     }
@@ -6,7 +6,8 @@
 /**
  * @param major the major version of glfw you want to use
  * @param minor the minor version of glfw you want to use
- * @brief initializes glfw and sets the glfw version to the one given after senitizing to make sure it works and is a valid version
+ * @brief initializes glfw and sets the glfw version to the one given after senitizing to make sure it works and is a valid version,
+ * debug builds also ask for a debug context
  * @exception runtime error if glfwInit fails
  */
 GLContext::GLContext(int major, int minor)
@@ -18,6 +19,10 @@ GLContext::GLContext(int major, int minor)
 
     glfwWindowHint(GLFW_VERSION_MAJOR, major);
     glfwWindowHint(GLFW_VERSION_MINOR, minor);
+    #ifdef DEBUG
+        // only debug contexts are guaranteed to report through KHR_debug, see GLDebug::sEnable
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    #endif
 }
 
 /**
@@ -1,30 +1,150 @@
 #include "GLDebug.hpp"
+#include "GLState.hpp"
+#include <algorithm>
 #include <iostream>
 
 /**
- * @brief sets up debug messaging for OpenGL with the help of messageCallback as callback function
+ * @param minSeverity the lowest severity that still reaches the callback, GL_DEBUG_SEVERITY_NOTIFICATION lets everything through
+ * @param capacity how many messages the ring buffer keeps, older ones get overwritten
+ * @brief sets up debug messaging for OpenGL with the help of messageCallback as callback function, the filtering happens in the
+ * driver with glDebugMessageControl so dropped severities never cost a callback
+ * @return true if debug output is active, false if the context is no debug context or KHR_debug is missing
  */
-void GLDebug::sEnable()
+bool GLDebug::sEnable(GLenum minSeverity, std::size_t capacity)
 {
-    GLint flags;
+    s_Log& log = sLog();
+    log.capacity = std::max<std::size_t>(capacity, 1);
+    log.messages.clear();
+    log.messages.reserve(log.capacity);
+    log.head = 0;
+    log.dropped = 0;
+
+    GLint flags = 0;
     glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
 
-    if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || !GLAD_GL_KHR_debug || !glDebugMessageCallback)
     {
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        std::cerr << "[GLDebug] Warning: Debug context not available. "
+            << "Run with a debug OpenGL context to enable debug output, falling back to glGetError."
+            << std::endl;
+        log.enabled = false;
+        return false;
+    }
 
-        glDebugMessageCallback(GLDebug::sMessageCallback, nullptr);
-        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    GLState::sEnable(GL_DEBUG_OUTPUT);
+    GLState::sEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 
-        std::cout << "[GLDebug] OpenGL debug output enabled" << std::endl;
-    }
-    else
+    glDebugMessageCallback(GLDebug::sMessageCallback, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+
+    // severities below the minimum are switched off, from the least severe upwards
+    const GLenum severities[] = {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH};
+    for (GLenum severity : severities)
     {
-        std::cerr << "[GLDebug] Warning: Debug context not available. "
-            << "Run with a debug OpenGL context to enable debug output."
-            << std::endl;
+        if (severity == minSeverity)
+            break;
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
     }
+
+    // push and pop group markers are only interesting to capture tools
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+
+    log.enabled = true;
+    std::cout << "[GLDebug] OpenGL debug output enabled" << std::endl;
+    return true;
+}
+
+/**
+ * @param ids the message ids that should never reach the callback, e.g. driver specific buffer usage hints
+ * @brief disables the given message ids for every source and type
+ */
+void GLDebug::sIgnore(const std::vector<GLuint>& ids)
+{
+    if (!sLog().enabled || ids.empty())
+        return;
+
+    // ids are only unique per source and type, so each pair has to be disabled on its own
+    const GLenum sources[] = {GL_DEBUG_SOURCE_API, GL_DEBUG_SOURCE_WINDOW_SYSTEM, GL_DEBUG_SOURCE_SHADER_COMPILER,
+        GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_SOURCE_OTHER};
+    const GLenum types[] = {GL_DEBUG_TYPE_ERROR, GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR, GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR,
+        GL_DEBUG_TYPE_PORTABILITY, GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_TYPE_OTHER};
+    for (GLenum source : sources)
+        for (GLenum type : types)
+            glDebugMessageControl(source, type, GL_DONT_CARE, static_cast<GLsizei>(ids.size()), ids.data(), GL_FALSE);
+}
+
+/**
+ * @return true if the debug output callback is installed
+ */
+bool GLDebug::sIsEnabled()
+{
+    return sLog().enabled;
+}
+
+/**
+ * @param where a label printed with every error so the location can be found
+ * @brief drains glGetError, only for contexts without debug output since every call can stall the pipeline, does nothing
+ * when debug output is active
+ */
+void GLDebug::sCheckErrors(const char* where)
+{
+    if (sLog().enabled)
+        return;
+
+    GLenum err = GL_NO_ERROR;
+    while ((err = glGetError()) != GL_NO_ERROR)
+        std::cerr << "[GLDebug] GL error 0x" << std::hex << err << std::dec << " at " << where << std::endl;
+}
+
+/**
+ * @return the buffered messages from oldest to newest
+ */
+std::vector<GLDebug::s_Message> GLDebug::sGetMessages()
+{
+    const s_Log& log = sLog();
+    std::vector<s_Message> messages;
+    messages.reserve(log.messages.size());
+    for (std::size_t i = 0; i < log.messages.size(); i++)
+        messages.push_back(log.messages[(log.head + i) % log.messages.size()]);
+    return messages;
+}
+
+/**
+ * @return how many messages were overwritten since sEnable because the ring buffer was full
+ */
+std::size_t GLDebug::sGetDropped()
+{
+    return sLog().dropped;
+}
+
+/**
+ * @param out the stream to print to
+ * @brief prints all buffered messages from oldest to newest
+ */
+void GLDebug::sDump(std::ostream& out)
+{
+    std::vector<s_Message> messages = sGetMessages();
+    if (messages.empty())
+        return;
+
+    out << "[GLDebug] last " << messages.size() << " messages";
+    if (sGetDropped())
+        out << " (" << sGetDropped() << " older ones dropped)";
+    out << "\n";
+    for (const s_Message& message : messages)
+        sPrint(out, message);
+    out << std::flush;
+}
+
+/**
+ * @brief the log lives in a function so it is constructed on first use
+ * @return the ring buffer and its state
+ */
+GLDebug::s_Log& GLDebug::sLog()
+{
+    static s_Log log;
+    return log;
 }
 
 /**
@@ -32,16 +152,44 @@ void GLDebug::sEnable()
  * @param type what kind of error were talking about
  * @param id the error id
  * @param severity the severity of the error
- * @param length unused
+ * @param length the length of message
  * @param message the message from this error
  * @param userParam unused
+ * @brief keeps the message in the ring buffer, overwriting the oldest one when it is full, high and medium messages are
+ * printed right away while the rest only shows up in sDump
+ */
+void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* /*userParam*/)
+{
+    s_Log& log = sLog();
+    s_Message entry = {source, type, id, severity, 0 <= length ? std::string(message, length) : std::string(message)};
+
+    if (GL_DEBUG_SEVERITY_HIGH == severity)
+        sPrint(std::cerr, entry);
+    else if (GL_DEBUG_SEVERITY_MEDIUM == severity)
+        sPrint(std::cout, entry);
+
+    if (0 == log.capacity)
+        return;
+    if (log.messages.size() < log.capacity)
+    {
+        log.messages.push_back(std::move(entry));
+        return;
+    }
+    log.messages[log.head] = std::move(entry);
+    log.head = (log.head + 1) % log.capacity;
+    log.dropped++;
+}
+
+/**
+ * @param out the stream to print to
+ * @param message the message to print
  * @brief tries to format the error message based from it source, type, and severity, and prints that info its id and message
  */
-void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/, const GLchar* message, const void* /*userParam*/)
+void GLDebug::sPrint(std::ostream& out, const s_Message& message)
 {
     std::string src, t, sev;
 
-    switch (source)
+    switch (message.source)
     {
         case GL_DEBUG_SOURCE_API: 
             src = "API";
@@ -66,7 +214,7 @@ void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum sev
             break;
     }
 
-    switch (type)
+    switch (message.type)
     {
         case GL_DEBUG_TYPE_ERROR:
             t = "error";
@@ -80,6 +228,9 @@ void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum sev
         case GL_DEBUG_TYPE_PORTABILITY:
             t = "Portability";
             break;
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            t = "Performance";
+            break;
         case GL_DEBUG_TYPE_MARKER:
             t = "Marker";
             break;
@@ -97,7 +248,7 @@ void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum sev
             break;
     }
 
-    switch (severity)
+    switch (message.severity)
     {
         case GL_DEBUG_SEVERITY_HIGH:
             sev = "HIGH";
@@ -116,10 +267,9 @@ void GLDebug::sMessageCallback(GLenum source, GLenum type, GLuint id, GLenum sev
             break;
     }
 
-    std::ostream& out = (severity == GL_DEBUG_SEVERITY_HIGH) ? std::cerr : std::cout;
-    out << "[OpenGL Debug] (" << id << ") "
+    out << "[OpenGL Debug] (" << message.id << ") "
         << "Source: " << src << ", "
         << "Type: " << t << ", "
         << "Severity: " << sev << "\n"
-        << " Message: " << message << "\n";
+        << " Message: " << message.text << "\n";
 }
\ No newline at end of file
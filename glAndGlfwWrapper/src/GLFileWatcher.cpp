@@ -0,0 +1,185 @@
+#include "GLFileWatcher.hpp"
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+# include <poll.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+/**
+ * @brief sets all handles to invalid, call setup to start watching
+ */
+GLFileWatcher::GLFileWatcher():
+m_inotifyFd(-1),
+m_wakeFds{-1, -1},
+m_running(false)
+{}
+
+/**
+ * @brief stops the watcher thread and closes the handles
+ */
+GLFileWatcher::~GLFileWatcher()
+{
+    stop();
+}
+
+/**
+ * @brief creates the inotify instance and starts the thread that collects the changes
+ * @return true if the watcher is running, false if the platform has no inotify or creating it failed
+ */
+bool GLFileWatcher::setup()
+{
+#ifdef __linux__
+    if (m_running)
+        return true;
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (-1 == m_inotifyFd)
+    {
+        std::cerr << "GLFileWatcher: inotify_init1 failed" << std::endl;
+        return false;
+    }
+
+    if (-1 == pipe(m_wakeFds))
+    {
+        std::cerr << "GLFileWatcher: failed to create wake pipe" << std::endl;
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&GLFileWatcher::run, this);
+    return true;
+#else
+    std::cerr << "GLFileWatcher: file watching is only supported on linux" << std::endl;
+    return false;
+#endif
+}
+
+/**
+ * @param filePath the file to watch
+ * @brief watches the directory of the file, so editors that save by writing a new file and renaming it are picked up as well
+ * @return true if the file is watched, false if the watcher isn't running or the directory can't be watched
+ */
+bool GLFileWatcher::watch(const std::string& filePath)
+{
+#ifdef __linux__
+    if (!m_running)
+        return false;
+
+    std::string file = sNormalize(filePath);
+    std::string directory = std::filesystem::path(file).parent_path().string();
+    if (directory.empty())
+        directory.push_back('.'); // assigning the literal trips a gcc 12 -Wrestrict false positive at -O2
+
+    int wd = inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (-1 == wd)
+    {
+        std::cerr << "GLFileWatcher: failed to watch " << directory << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directories[wd] = directory;
+    m_files.insert(file);
+    return true;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+/**
+ * @brief takes the files that changed since the last poll, a file that was saved multiple times is reported once
+ * @return the normalized paths of the changed files
+ */
+std::vector<std::string> GLFileWatcher::poll()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> changed(m_changed.begin(), m_changed.end());
+    m_changed.clear();
+    return changed;
+}
+
+/**
+ * @param filePath the path to normalize
+ * @brief makes the path absolute and removes . and .. parts, so paths from the watcher can be compared with paths given to watch
+ * @return the normalized path
+ */
+std::string GLFileWatcher::sNormalize(const std::string& filePath)
+{
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(filePath, error);
+    if (error)
+        absolute = filePath;
+    return absolute.lexically_normal().string();
+}
+
+/**
+ * @brief waits on the inotify handle and records the watched files that were written or moved into place, until stop wakes it up
+ */
+void GLFileWatcher::run()
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{m_inotifyFd, POLLIN, 0}, {m_wakeFds[0], POLLIN, 0}};
+
+    while (m_running)
+    {
+        if (0 >= ::poll(fds, 2, -1))
+            continue;
+        if (fds[1].revents & POLLIN)
+            break;
+
+        ssize_t length = 0;
+        while (0 < (length = read(m_inotifyFd, buffer, sizeof(buffer))))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (char* ptr = buffer; ptr < buffer + length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                std::unordered_map<int, std::string>::const_iterator dir = m_directories.find(event->wd);
+                if (dir == m_directories.end() || 0 == event->len)
+                    continue;
+
+                std::string file = (std::filesystem::path(dir->second) / event->name).lexically_normal().string();
+                if (m_files.count(file))
+                    m_changed.insert(file);
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * @brief wakes the watcher thread, joins it and closes the handles
+ */
+void GLFileWatcher::stop()
+{
+#ifdef __linux__
+    if (m_running)
+    {
+        m_running = false;
+        char wake = 1;
+        if (-1 == write(m_wakeFds[1], &wake, 1))
+            std::cerr << "GLFileWatcher: failed to wake watcher thread" << std::endl;
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+
+    if (-1 != m_inotifyFd)
+        close(m_inotifyFd);
+    if (-1 != m_wakeFds[0])
+        close(m_wakeFds[0]);
+    if (-1 != m_wakeFds[1])
+        close(m_wakeFds[1]);
+    m_inotifyFd = -1;
+    m_wakeFds[0] = -1;
+    m_wakeFds[1] = -1;
+#endif
+}
\ No newline at end of file
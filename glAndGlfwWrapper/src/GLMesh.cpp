@@ -1,4 +1,5 @@
 #include "GLMesh.hpp"
+#include "GLState.hpp"
 #include <iostream>
 #include <stdexcept>
 
@@ -66,7 +67,8 @@ bool GLMesh::setup()
 /**
  * @param buffer the vertex buffer object
  * @param attributes the attribute data that buffer needs, like vertices, faces, texture coords
- * @brief sets the attributes of the given vertex buffer
+ * @brief sets the attributes of the given vertex buffer, a buffer whose first attribute has a divisor holds per instance
+ * data and doesn't change the vertex count of the mesh
  * @returns true when the attributes are attached, false on error with error message
  * @attention attributes.offset and attributes.stride are assumed to hold there byte value
  */
@@ -93,6 +95,7 @@ bool GLMesh::attachVertexBuffer(const GLBuffer& buffer, const std::vector<s_Vert
     {
         glEnableVertexAttribArray(att.index);
         glVertexAttribPointer(att.index, att.size, att.type, att.normalized, att.stride, reinterpret_cast<const void*>(att.offset));
+        glVertexAttribDivisor(att.index, att.divisor);
 
         if (strideBytes < att.stride)
             strideBytes = att.stride;
@@ -112,10 +115,13 @@ bool GLMesh::attachVertexBuffer(const GLBuffer& buffer, const std::vector<s_Vert
         strideBytes = static_cast<GLsizei>(typeSize);
     }
 
-    if (0 < strideBytes)
-        m_vertexCount = static_cast<GLsizei>(buffer.getCount() / (strideBytes / typeSize));
-    else
-        m_vertexCount = 0;
+    if (0 == attributes[0].divisor)
+    {
+        if (0 < strideBytes)
+            m_vertexCount = static_cast<GLsizei>(buffer.getCount() / (strideBytes / typeSize));
+        else
+            m_vertexCount = 0;
+    }
 
     unbind();
 
@@ -147,7 +153,7 @@ bool GLMesh::attachElementBuffer(const GLBuffer& buffer)
  */
 void GLMesh::bind() const
 {
-    glBindVertexArray(m_vertexArrayObject);
+    GLState::sBindVertexArray(m_vertexArrayObject);
 }
 
 /**
@@ -155,14 +161,15 @@ void GLMesh::bind() const
  */
 void GLMesh::unbind() const
 {
-    glBindVertexArray(0);
+    GLState::sBindVertexArray(0);
 }
 
 /**
- * @param mode
- * @param count
- * @param indexType
- * @brief
+ * @param mode the primitive type, e.g. GL_TRIANGLES
+ * @param count the amount of indices or vertices to draw, 0 draws all of them
+ * @param indexType the type of the indices in the element buffer
+ * @brief draws the mesh with its indices when it has an element buffer, otherwise with its vertices.
+ * The vertex array stays bound afterwards so drawing the same mesh again doesn't rebind it
  */
 void GLMesh::draw(GLenum mode, GLsizei count, GLenum indexType) const
 {
@@ -171,15 +178,76 @@ void GLMesh::draw(GLenum mode, GLsizei count, GLenum indexType) const
     {
         GLsizei finalCount = (0 == count) ? m_indexCount : count;
         if (0 < finalCount)
+        {
             glDrawElements(mode, finalCount, indexType, nullptr);
+            GLState::sCount();
+        }
     }
     else if (0 < m_vertexCount)
     {
         GLsizei finalCount = (0 == count) ? m_vertexCount : count;
         if (0 < finalCount)
+        {
             glDrawArrays(mode, 0, finalCount);
+            GLState::sCount();
+        }
     }
-    unbind();
+}
+
+/**
+ * @param instanceCount how many instances to draw, attributes with a divisor advance per instance
+ * @param mode the primitive type, e.g. GL_TRIANGLES
+ * @param count the amount of indices or vertices per instance, 0 draws all of them
+ * @param indexType the type of the indices in the element buffer
+ * @brief draws all instances of the mesh with one call, like draw the vertex array stays bound afterwards
+ */
+void GLMesh::drawInstanced(GLsizei instanceCount, GLenum mode, GLsizei count, GLenum indexType) const
+{
+    if (0 >= instanceCount)
+        return;
+
+    bind();
+    if (0 < m_indexCount)
+    {
+        GLsizei finalCount = (0 == count) ? m_indexCount : count;
+        if (0 < finalCount)
+        {
+            glDrawElementsInstanced(mode, finalCount, indexType, nullptr, instanceCount);
+            GLState::sCount();
+        }
+    }
+    else if (0 < m_vertexCount)
+    {
+        GLsizei finalCount = (0 == count) ? m_vertexCount : count;
+        if (0 < finalCount)
+        {
+            glDrawArraysInstanced(mode, 0, finalCount, instanceCount);
+            GLState::sCount();
+        }
+    }
+}
+
+/**
+ * @param firstIndex the first index of the range in the element buffer
+ * @param count the amount of indices to draw
+ * @param mode the primitive type, e.g. GL_TRIANGLES
+ * @param indexType the type of the indices in the element buffer
+ * @brief draws one range of the element buffer, meshes without one draw the same range of vertices
+ */
+void GLMesh::drawRange(GLuint firstIndex, GLsizei count, GLenum mode, GLenum indexType) const
+{
+    if (0 >= count)
+        return;
+
+    bind();
+    if (0 < m_indexCount)
+    {
+        std::size_t indexSize = (GL_UNSIGNED_BYTE == indexType) ? 1 : (GL_UNSIGNED_SHORT == indexType) ? 2 : 4;
+        glDrawElements(mode, count, indexType, reinterpret_cast<const void*>(static_cast<std::size_t>(firstIndex) * indexSize));
+    }
+    else
+        glDrawArrays(mode, static_cast<GLint>(firstIndex), count);
+    GLState::sCount();
 }
 
 /**
@@ -198,6 +266,7 @@ void GLMesh::cleanup()
 {
     if (m_vertexArrayObject)
     {
+        GLState::sForgetVertexArray(m_vertexArrayObject);
         glDeleteVertexArrays(1, &m_vertexArrayObject);
         m_vertexArrayObject = 0;
     }
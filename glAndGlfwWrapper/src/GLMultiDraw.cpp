@@ -0,0 +1,150 @@
+#include "GLMultiDraw.hpp"
+#include "GLState.hpp"
+#include <cstdint>
+#include <iostream>
+
+/**
+ * @brief creates an empty command list, call setup before setCommands
+ */
+GLMultiDraw::GLMultiDraw():
+m_commandBuffer(GLBuffer::e_Type::DrawIndirect),
+m_indexType(GL_UNSIGNED_INT),
+m_indirect(false),
+m_instanced(false)
+{}
+
+/**
+ * @brief picks the submission path, the indirect buffer is only created when the context can consume it
+ * @return true if the draw can be used, false if the command buffer couldn't be created
+ */
+bool GLMultiDraw::setup()
+{
+    m_indirect = sHasIndirect();
+    if (m_indirect && !m_commandBuffer.setup())
+    {
+        std::cerr << "GLMultiDraw: failed to create the indirect command buffer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param commands one entry per range of the element buffer, empty ranges are allowed and skipped by gl
+ * @param indexType the type of the indices in the element buffer
+ * @brief replaces the command list, with indirect support the commands are uploaded once and only read by the gpu,
+ * otherwise the count, offset and base vertex arrays for glMultiDrawElementsBaseVertex are built here
+ * @return true if the commands are stored, false if the upload failed
+ */
+bool GLMultiDraw::setCommands(const std::vector<s_Command>& commands, GLenum indexType)
+{
+    m_commands = commands;
+    m_indexType = indexType;
+    m_counts.clear();
+    m_offsets.clear();
+    m_baseVertices.clear();
+    m_instanced = false;
+
+    if (m_commands.empty())
+        return true;
+
+    if (m_indirect)
+        return m_commandBuffer.setData(m_commands, GL_DYNAMIC_DRAW);
+
+    std::size_t indexSize = sIndexSize(indexType);
+    m_counts.reserve(m_commands.size());
+    m_offsets.reserve(m_commands.size());
+    m_baseVertices.reserve(m_commands.size());
+    for (const s_Command& command : m_commands)
+    {
+        m_counts.push_back(static_cast<GLsizei>(command.count));
+        m_offsets.push_back(reinterpret_cast<const void*>(static_cast<std::uintptr_t>(command.firstIndex) * indexSize));
+        m_baseVertices.push_back(command.baseVertex);
+        if (1 != command.instanceCount || 0 != command.baseInstance)
+            m_instanced = true;
+    }
+    return true;
+}
+
+/**
+ * @param mesh the vertex array holding the shared vertex and element buffer the commands index into
+ * @param mode the primitive type, e.g. GL_TRIANGLES
+ * @brief submits all commands with one call. Without indirect support instanced commands fall back to one
+ * glDrawElementsInstancedBaseVertex per command, since glMultiDrawElements has no instance count
+ */
+void GLMultiDraw::draw(const GLMesh& mesh, GLenum mode) const
+{
+    if (m_commands.empty())
+        return;
+
+    mesh.bind();
+    if (m_indirect)
+    {
+        m_commandBuffer.bind();
+        glMultiDrawElementsIndirect(mode, m_indexType, nullptr, static_cast<GLsizei>(m_commands.size()), sizeof(s_Command));
+        GLState::sCount();
+        return;
+    }
+
+    if (!m_instanced)
+    {
+        glMultiDrawElementsBaseVertex(mode, m_counts.data(), m_indexType, m_offsets.data(),
+            static_cast<GLsizei>(m_commands.size()), m_baseVertices.data());
+        GLState::sCount();
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_commands.size(); ++i)
+    {
+        if (0 == m_counts[i] || 0 == m_commands[i].instanceCount)
+            continue;
+        glDrawElementsInstancedBaseVertex(mode, m_counts[i], m_indexType, m_offsets[i],
+            static_cast<GLsizei>(m_commands[i].instanceCount), m_baseVertices[i]);
+        GLState::sCount();
+    }
+}
+
+/**
+ * @brief gets the amount of commands
+ * @return the amount of commands given to setCommands
+ */
+GLsizei GLMultiDraw::getCommandCount() const
+{
+    return static_cast<GLsizei>(m_commands.size());
+}
+
+/**
+ * @brief tells which submission path draw takes
+ * @return true if the commands are read from the indirect buffer, false if they are passed as arrays
+ */
+bool GLMultiDraw::isIndirect() const
+{
+    return m_indirect;
+}
+
+/**
+ * @brief glMultiDrawElementsIndirect is core in 4.3, glad is generated for 4.1 so it is only loaded through
+ * ARB_multi_draw_indirect, which 4.3 drivers expose as well
+ * @return true if the current context can draw from an indirect buffer
+ */
+bool GLMultiDraw::sHasIndirect()
+{
+    return GLAD_GL_ARB_multi_draw_indirect && glMultiDrawElementsIndirect;
+}
+
+/**
+ * @param indexType GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ * @brief gets the size of one index
+ * @return the size of one index in bytes
+ */
+std::size_t GLMultiDraw::sIndexSize(GLenum indexType)
+{
+    switch (indexType)
+    {
+        case GL_UNSIGNED_BYTE:
+            return sizeof(GLubyte);
+        case GL_UNSIGNED_SHORT:
+            return sizeof(GLushort);
+        default:
+            return sizeof(GLuint);
+    }
+}
\ No newline at end of file
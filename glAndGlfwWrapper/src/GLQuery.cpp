@@ -0,0 +1,216 @@
+#include "GLQuery.hpp"
+#include "GLState.hpp"
+#include <iostream>
+
+// marks that no query of the pool is between begin and end
+static const std::size_t sNoActive = static_cast<std::size_t>(-1);
+
+/**
+ * @brief creates an empty pool, call setup to create the queries
+ */
+GLQuery::GLQuery(): m_target(0), m_active(sNoActive) {}
+
+/**
+ * @param other the pool to be moved
+ * @brief takes ownership of the queries of other
+ */
+GLQuery::GLQuery(GLQuery&& other):
+m_ids(std::move(other.m_ids)),
+m_states(std::move(other.m_states)),
+m_target(other.m_target),
+m_active(other.m_active)
+{
+    other.m_ids.clear();
+    other.m_states.clear();
+    other.m_active = sNoActive;
+}
+
+/**
+ * @brief deletes all queries of the pool
+ */
+GLQuery::~GLQuery()
+{
+    cleanup();
+}
+
+/**
+ * @param other the pool to be moved
+ * @brief deletes the current queries and takes ownership of the queries of other
+ * @return the moved GLQuery
+ */
+GLQuery& GLQuery::operator=(GLQuery&& other)
+{
+    if (this != &other)
+    {
+        cleanup();
+        m_ids = std::move(other.m_ids);
+        m_states = std::move(other.m_states);
+        m_target = other.m_target;
+        m_active = other.m_active;
+        other.m_ids.clear();
+        other.m_states.clear();
+        other.m_active = sNoActive;
+    }
+    return *this;
+}
+
+/**
+ * @param count the amount of queries in the pool
+ * @param target the query target, e.g. GL_ANY_SAMPLES_PASSED or GL_TIME_ELAPSED
+ * @brief deletes the old queries, pending ones included, and generates count new ones
+ * @return true if the queries are created, false if no ids could be generated
+ */
+bool GLQuery::setup(std::size_t count, GLenum target)
+{
+    cleanup();
+    m_target = target;
+    if (0 == count)
+        return true;
+
+    m_ids.assign(count, 0);
+    glGenQueries(static_cast<GLsizei>(count), m_ids.data());
+    if (0 == m_ids.front())
+    {
+        std::cerr << "GLQuery: failed to generate " << count << " queries" << std::endl;
+        m_ids.clear();
+        return false;
+    }
+    m_states.assign(count, Unused);
+    return true;
+}
+
+/**
+ * @param index the query of the pool
+ * @brief starts counting into the query, only one query of a target can be active at a time
+ * @warning restarting a pending query throws away its result, check isPending first
+ */
+void GLQuery::begin(std::size_t index)
+{
+    if (index >= m_ids.size() || sNoActive != m_active)
+        return;
+
+    glBeginQuery(m_target, m_ids[index]);
+    GLState::sCount();
+    m_active = index;
+}
+
+/**
+ * @brief stops the active query, its result will be available some frames later
+ */
+void GLQuery::end()
+{
+    if (sNoActive == m_active)
+        return;
+
+    glEndQuery(m_target);
+    GLState::sCount();
+    m_states[m_active] = Pending;
+    m_active = sNoActive;
+}
+
+/**
+ * @param index the query of the pool
+ * @param result gets the result when it is available, it isn't touched otherwise
+ * @brief asks gl if the result is there and only reads it then, so the call never waits for the gpu
+ * @return true if a new result was read, false if the query isn't pending or the gpu isn't done with it
+ */
+bool GLQuery::poll(std::size_t index, GLuint& result)
+{
+    if (index >= m_ids.size() || Pending != m_states[index])
+        return false;
+
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(m_ids[index], GL_QUERY_RESULT_AVAILABLE, &available);
+    GLState::sCount();
+    if (GL_FALSE == available)
+        return false;
+
+    glGetQueryObjectuiv(m_ids[index], GL_QUERY_RESULT, &result);
+    GLState::sCount();
+    m_states[index] = Ready;
+    return true;
+}
+
+/**
+ * @param index the query of the pool
+ * @brief tells if the query was ended and its result wasn't read yet
+ * @return true if the query is pending, else false
+ */
+bool GLQuery::isPending(std::size_t index) const
+{
+    return index < m_states.size() && Pending == m_states[index];
+}
+
+/**
+ * @param index the query of the pool
+ * @brief tells if the query was ever begun, gl only accepts those for conditional rendering
+ * @return true if the query was issued at least once, else false
+ */
+bool GLQuery::wasIssued(std::size_t index) const
+{
+    return index < m_states.size() && Unused != m_states[index];
+}
+
+/**
+ * @param index the query of the pool
+ * @param mode GL_QUERY_NO_WAIT draws when the result isn't there yet, GL_QUERY_WAIT lets the gpu wait for it
+ * @brief draws until endConditionalRender are discarded by the gpu when the query counted no samples,
+ * the cpu never waits in either mode
+ */
+void GLQuery::beginConditionalRender(std::size_t index, GLenum mode) const
+{
+    if (!wasIssued(index))
+        return;
+
+    glBeginConditionalRender(m_ids[index], mode);
+    GLState::sCount();
+}
+
+/**
+ * @brief ends the conditional rendering started with beginConditionalRender
+ */
+void GLQuery::endConditionalRender() const
+{
+    glEndConditionalRender();
+    GLState::sCount();
+}
+
+/**
+ * @brief gives the amount of queries in the pool
+ * @return the pool size
+ */
+std::size_t GLQuery::size() const
+{
+    return m_ids.size();
+}
+
+/**
+ * @brief gives the target the queries count for
+ * @return the query target
+ */
+GLenum GLQuery::getTarget() const
+{
+    return m_target;
+}
+
+/**
+ * @brief picks the cheapest occlusion target the context has. The conservative one may report false positives,
+ * which only costs a draw, and lets the gpu answer with its coarse depth test
+ * @return GL_ANY_SAMPLES_PASSED_CONSERVATIVE with ARB_ES3_compatibility, else GL_ANY_SAMPLES_PASSED
+ */
+GLenum GLQuery::sOcclusionTarget()
+{
+    return GLAD_GL_ARB_ES3_compatibility ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+}
+
+/**
+ * @brief deletes the queries, an active one is ended first
+ */
+void GLQuery::cleanup()
+{
+    end();
+    if (!m_ids.empty() && 0 != m_ids.front())
+        glDeleteQueries(static_cast<GLsizei>(m_ids.size()), m_ids.data());
+    m_ids.clear();
+    m_states.clear();
+}
\ No newline at end of file
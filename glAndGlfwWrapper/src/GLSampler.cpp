@@ -0,0 +1,96 @@
+#include "GLSampler.hpp"
+#include "GLState.hpp"
+
+/**
+ * @brief sets the id to 0, call setup to create the sampler
+ */
+GLSampler::GLSampler(): m_id(0) {}
+
+/**
+ * @param other the sampler to be moved
+ * @brief takes ownership of the sampler of other
+ */
+GLSampler::GLSampler(GLSampler&& other): m_id(other.m_id)
+{
+    other.m_id = 0;
+}
+
+/**
+ * @brief deletes the sampler object if set
+ */
+GLSampler::~GLSampler()
+{
+    if (0 != m_id)
+    {
+        GLState::sForgetSampler(m_id);
+        glDeleteSamplers(1, &m_id);
+    }
+}
+
+/**
+ * @param other the sampler to be moved
+ * @brief deletes the current sampler and takes ownership of the sampler of other
+ * @return the moved GLSampler
+ */
+GLSampler& GLSampler::operator=(GLSampler&& other)
+{
+    if (this != &other)
+    {
+        if (0 != m_id)
+        {
+            GLState::sForgetSampler(m_id);
+            glDeleteSamplers(1, &m_id);
+        }
+        m_id = other.m_id;
+        other.m_id = 0;
+    }
+    return *this;
+}
+
+/**
+ * @param minFilter the minifying filter, e.g. GL_LINEAR_MIPMAP_LINEAR
+ * @param magFilter the magnifying filter, GL_LINEAR or GL_NEAREST
+ * @param wrap the wrap mode used for both s and t
+ * @brief creates the sampler and sets its filter and wrap state, any texture bound to the same unit is sampled with it
+ * @return true if the sampler is created, false if no sampler id could be generated
+ */
+bool GLSampler::setup(GLint minFilter, GLint magFilter, GLint wrap)
+{
+    if (0 == m_id)
+        glGenSamplers(1, &m_id);
+    if (0 == m_id)
+        return false;
+
+    glSamplerParameteri(m_id, GL_TEXTURE_MIN_FILTER, minFilter);
+    glSamplerParameteri(m_id, GL_TEXTURE_MAG_FILTER, magFilter);
+    glSamplerParameteri(m_id, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(m_id, GL_TEXTURE_WRAP_T, wrap);
+    return true;
+}
+
+/**
+ * @param unit the texture unit, 0 for GL_TEXTURE0
+ * @brief binds the sampler to the texture unit, it overrides the sampling state of the texture bound there
+ */
+void GLSampler::bind(GLuint unit) const
+{
+    GLState::sBindSampler(unit, m_id);
+}
+
+/**
+ * @param unit the texture unit, 0 for GL_TEXTURE0
+ * @brief unbinds the sampler so the unit uses the state of the texture again
+ */
+void GLSampler::unbind(GLuint unit) const
+{
+    GLState::sBindSampler(unit, 0);
+}
+
+/**
+ * @brief gets the id of the sampler
+ * @return the sampler id
+ */
+GLuint GLSampler::getId() const
+{
+    return m_id;
+}
\ No newline at end of file
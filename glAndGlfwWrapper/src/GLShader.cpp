@@ -1,7 +1,24 @@
 #include "GLShader.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
 #include "GLUtils.hpp"
+#include "GLState.hpp"
+
+/**
+ * header in front of every cached program binary, the key is checked again after loading to guard against stale or foreign files
+ */
+struct s_ProgramBinaryHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t format;
+    std::uint32_t length;
+};
 
 /**
  * @brief sets object variables to default
@@ -14,13 +31,16 @@ GLShader::GLShader(): m_program(0) {}
 GLShader::~GLShader()
 {
     if (m_program)
+    {
+        GLState::sForgetProgram(m_program);
         glDeleteProgram(m_program);
+    }
 }
 
 /**
  * @param vertexFilePath the file path to the vertex shader
  * @param fragmentFilePath the file path to the fragment shader
- * @brief creats and links the saders to the shader program which is setup
+ * @brief reads the shader files and creates the shader program from their source
  * @return true if the shader compailing and linking succeeds, false if it fails and a error message is printed
  */
 bool GLShader::setup(const std::string& vertexFilePath, const std::string& fragmentFilePath)
@@ -32,27 +52,55 @@ bool GLShader::setup(const std::string& vertexFilePath, const std::string& fragm
         std::cerr << "Failed to read vertex shader file" << std::endl;
         return false;
     }
-    fileSource.emplace_back('\0');
-
-    std::string vertexSource = reinterpret_cast<char*>(fileSource.data());
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-    if (vertexShader == 0)
-    {
-        std::cerr << "Failed to compile vertexShader" << std::endl;
-        return false;
-    }
+    std::string vertexSource(fileSource.begin(), fileSource.end());
     
     fileSource.clear();
 
     if (!GLUtils::sReadShaderFile(fragmentFilePath.c_str(), fileSource))
     {
-        glDeleteShader(vertexShader);
         std::cerr << "Failed to read fragment shader file" << std::endl;
         return false;
     }
-    fileSource.emplace_back('\0');
+    std::string fragmentSource(fileSource.begin(), fileSource.end());
+
+    return setupFromSource(vertexSource, fragmentSource);
+}
+
+/**
+ * @param vertexSource the source code of the vertex shader
+ * @param fragmentSource the source code of the fragment shader
+ * @brief creats and links the saders to the shader program which is setup.
+ * When a binary cache directory is set the program is first looked up in the cache, and a freshly linked program is written to it
+ * @return true if the shader compailing and linking succeeds, false if it fails and a error message is printed
+ */
+bool GLShader::setupFromSource(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    if (m_program)
+    {
+        GLState::sForgetProgram(m_program);
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+    m_uniformCache.clear();
+
+    bool useCache = !m_cacheDir.empty() && sBinaryCacheSupported();
+    std::string cachePath;
+    std::uint64_t cacheKey = 0;
+    if (useCache)
+    {
+        cacheKey = sBinaryCacheKey(vertexSource, fragmentSource);
+        cachePath = sBinaryCachePath(m_cacheDir, cacheKey);
+        if (loadProgramBinary(cachePath, cacheKey))
+            return true;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    if (vertexShader == 0)
+    {
+        std::cerr << "Failed to compile vertexShader" << std::endl;
+        return false;
+    }
 
-    std::string fragmentSource = reinterpret_cast<char*>(fileSource.data());
     GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
     if (fragmentShader == 0)
     {
@@ -70,29 +118,45 @@ bool GLShader::setup(const std::string& vertexFilePath, const std::string& fragm
         return false;
     }
 
+    if (useCache)
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     attachShader(vertexShader);
     attachShader(fragmentShader);
-    linkProgram();
 
-    if (!checkCompileErrors(m_program, GL_LINK_STATUS, true))
+    if (!linkProgram())
     {
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         glDeleteProgram(m_program);
+        m_program = 0;
         std::cerr << "Failed to link shaders to program" << std::endl;
         return false;
     }
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    if (useCache)
+        saveProgramBinary(cachePath, cacheKey);
+
     return true;
 }
 
+/**
+ * @param directory the directory the program binaries are stored in, an empty string disables the cache
+ * @brief sets where setupFromSource looks for and stores linked program binaries
+ */
+void GLShader::setBinaryCacheDir(const std::string& directory)
+{
+    m_cacheDir = directory;
+}
+
 /**
  * @brief binds the shader program of the object
  */
 void GLShader::bind() const
 {
-    glUseProgram(m_program);
+    GLState::sUseProgram(m_program);
 }
 
 /**
@@ -100,7 +164,7 @@ void GLShader::bind() const
  */
 void GLShader::unbind() const
 {
-    glUseProgram(0);
+    GLState::sUseProgram(0);
 }
 
 /**
@@ -123,7 +187,7 @@ void GLShader::attachShader(GLuint shader)
 }
 
 /**
- * @brief links the shader program and the shaders
+ * @brief links the shader program and the shaders, and resolves all active uniforms of the linked program
  * @return true if linking is successfull, else false is returned 
  */
 bool GLShader::linkProgram()
@@ -138,28 +202,128 @@ bool GLShader::linkProgram()
     for (GLuint shader : m_shaders)
         glDetachShader(m_program, shader);
     m_shaders.clear();
+
+    reflectUniforms();
+    return true;
+}
+
+/**
+ * @param name the name of the uniform
+ * @brief checks the uniforms that were reflected at link time, without asking OpenGL or printing a warning
+ * @return true if the program has an active uniform with that name, else false
+ */
+bool GLShader::hasUniform(const std::string& name) const
+{
+    std::unordered_map<std::string, s_UniformInfo>::const_iterator it = m_uniformCache.find(name);
+    return it != m_uniformCache.end() && -1 != it->second.location;
+}
+
+/**
+ * @param blockName the name of the uniform block in the shader
+ * @param bindingPoint the uniform buffer binding point the block should read from
+ * @brief connects the uniform block of the program to the binding point
+ * @return true if the block is found and bound, false if the program has no block with that name
+ */
+bool GLShader::setUniformBlockBinding(const std::string& blockName, GLuint bindingPoint) const
+{
+    GLuint blockIndex = glGetUniformBlockIndex(m_program, blockName.c_str());
+    if (GL_INVALID_INDEX == blockIndex)
+    {
+        std::cerr << "Warning: uniform block '" << blockName << "' doesn't exist" << std::endl;
+        return false;
+    }
+
+    glUniformBlockBinding(m_program, blockIndex, bindingPoint);
     return true;
 }
 
 /**
  * @param name the name of the uniform
- * @brief tries to find the uniform of the given name in the shaderprogram, if found its stored in a map for easy lookup later
+ * @brief gets the location of the uniform from the cache that was filled when the program was linked
  * @return an integer represending the id of where the uniform was found, or -1 if not found or error
  */
 GLint GLShader::getUniformLocation(const std::string& name)
 {
-    if (m_uniformCache.find(name) != m_uniformCache.end())
-        return m_uniformCache[name];
-    
-    GLint location = glGetUniformLocation(m_program, name.c_str());
-    if (location == -1)
-    {
+    return getUniformInfo(name).location;
+}
+
+/**
+ * @param name the name of the uniform
+ * @brief looks the uniform up in the cache, names that weren't reflected (like a single array element) are asked from OpenGL once and stored as well
+ * @return the cached info of the uniform, with location -1 if it doesn't exist so missing uniforms only warn once
+ */
+const s_UniformInfo& GLShader::getUniformInfo(const std::string& name)
+{
+    std::unordered_map<std::string, s_UniformInfo>::const_iterator it = m_uniformCache.find(name);
+    if (it != m_uniformCache.end())
+        return it->second;
+
+    s_UniformInfo info = {glGetUniformLocation(m_program, name.c_str()), GL_NONE, 0};
+    if (info.location == -1)
         std::cerr << "Warning: uniform '" << name << "' doesn't exist" << std::endl;
-        return -1;
+
+    return m_uniformCache.emplace(name, info).first->second;
+}
+
+/**
+ * @brief fills the uniform cache with the location, type and size of every active uniform in the program by introspecting GL_ACTIVE_UNIFORMS,
+ * uniforms that live in a uniform block have no location and are skipped
+ */
+void GLShader::reflectUniforms()
+{
+    m_uniformCache.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    if (0 >= count || 0 >= maxLength)
+        return;
+
+    std::vector<char> nameBuffer(static_cast<std::size_t>(maxLength));
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        s_UniformInfo info = {-1, GL_NONE, 0};
+        glGetActiveUniform(m_program, static_cast<GLuint>(i), maxLength, &length, &info.size, &info.type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), static_cast<std::size_t>(length));
+        info.location = glGetUniformLocation(m_program, name.c_str());
+        if (-1 == info.location)
+            continue;
+
+        // arrays are reported as "name[0]", store them under "name" as well
+        std::size_t bracket = name.find('[');
+        if (std::string::npos != bracket)
+            m_uniformCache.emplace(name.substr(0, bracket), info);
+        m_uniformCache.emplace(name, info);
     }
+}
 
-    m_uniformCache.emplace(name, location);
-    return location;
+/**
+ * @param type the GLSL type of a uniform
+ * @brief checks if the type is one of the sampler types, which are set with an int texture unit
+ * @return true if type is a sampler, else false
+ */
+bool GLShader::sIsSamplerType(GLenum type)
+{
+    switch (type)
+    {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+            return true;
+        default:
+            return false;
+    }
 }
 
 /**
@@ -203,7 +367,10 @@ GLuint GLShader::compileShader(GLenum type, const std::string& source)
     glCompileShader(shader);
 
     if (!checkCompileErrors(shader, type, false))
+    {
+        glDeleteShader(shader);
         return 0;
+    }
     
     return shader;
 }
@@ -244,3 +411,125 @@ bool GLShader::checkCompileErrors(GLuint object, GLenum type, bool isProgram)
     }
     return false;
 }
+
+
+/**
+ * @brief checks if the driver can hand out and take back program binaries
+ * @return true if glGetProgramBinary is available and at least one binary format is supported, else false
+ */
+bool GLShader::sBinaryCacheSupported()
+{
+    if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return 0 < formats;
+}
+
+/**
+ * @param vertexSource the source code of the vertex shader
+ * @param fragmentSource the source code of the fragment shader
+ * @brief hashes both sources together with the vendor, renderer and version string of the driver, so a driver update never loads an old binary
+ * @return the key of the program in the cache
+ */
+std::uint64_t GLShader::sBinaryCacheKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    std::uint64_t key = GLUtils::sHash(vertexSource.data(), vertexSource.size());
+    key = GLUtils::sHash(fragmentSource.data(), fragmentSource.size(), key);
+
+    const GLenum driverStrings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : driverStrings)
+    {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        if (value)
+            key = GLUtils::sHash(value, std::strlen(value), key);
+    }
+    return key;
+}
+
+/**
+ * @param directory the cache directory
+ * @param key the key of the program
+ * @brief builds the file path of the cached program
+ * @return the path to the cache file
+ */
+std::string GLShader::sBinaryCachePath(const std::string& directory, std::uint64_t key)
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return (std::filesystem::path(directory) / name.str()).string();
+}
+
+/**
+ * @param path the path to the cache file
+ * @param key the key the cache file must have
+ * @brief tries to create the program from a cached binary, a missing file, a key mismatch or a binary the driver rejects all fall back to compiling
+ * @return true if the program is created from the binary, else false
+ */
+bool GLShader::loadProgramBinary(const std::string& path, std::uint64_t key)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(path, error))
+        return false;
+
+    std::vector<unsigned char> buffer;
+    if (!GLUtils::sReadShaderFile(path.c_str(), buffer) || buffer.size() < sizeof(s_ProgramBinaryHeader))
+        return false;
+
+    s_ProgramBinaryHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (0 != std::memcmp(header.magic, "SCPB", 4) || 1 != header.version || key != header.key
+        || buffer.size() - sizeof(header) != header.length)
+        return false;
+
+    m_program = glCreateProgram();
+    if (0 == m_program)
+        return false;
+
+    glProgramBinary(m_program, header.format, buffer.data() + sizeof(header), static_cast<GLsizei>(header.length));
+
+    GLint success = 0;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(m_program);
+        m_program = 0;
+        return false;
+    }
+
+    reflectUniforms();
+    return true;
+}
+
+/**
+ * @param path the path to the cache file
+ * @param key the key of the program
+ * @brief writes the binary of the linked program to the cache, failing to write only costs a compile on the next launch
+ */
+void GLShader::saveProgramBinary(const std::string& path, std::uint64_t key) const
+{
+    GLint length = 0;
+    glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (0 >= length)
+        return;
+
+    s_ProgramBinaryHeader header = {{'S', 'C', 'P', 'B'}, 1, key, 0, 0};
+    std::vector<unsigned char> buffer(sizeof(header) + static_cast<std::size_t>(length));
+
+    GLsizei written = 0;
+    GLenum format = GL_NONE;
+    glGetProgramBinary(m_program, length, &written, &format, buffer.data() + sizeof(header));
+    if (0 >= written)
+        return;
+
+    header.format = format;
+    header.length = static_cast<std::uint32_t>(written);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    buffer.resize(sizeof(header) + static_cast<std::size_t>(written));
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    if (!GLUtils::sWriteFile(path.c_str(), buffer))
+        std::cerr << "Warning: failed to write program binary cache: " << path << std::endl;
+}
\ No newline at end of file
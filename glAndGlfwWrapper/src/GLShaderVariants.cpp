@@ -0,0 +1,329 @@
+#include "GLShaderVariants.hpp"
+#include "GLUtils.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief creates an empty variant set, call setup before get
+ */
+GLShaderVariants::GLShaderVariants(): m_generation(0) {}
+
+/**
+ * @param vertexFilePath the file path to the vertex shader
+ * @param fragmentFilePath the file path to the fragment shader
+ * @param features the define names of the features, bit i of a mask turns on features[i]
+ * @brief reads both shaders and resolves their includes, programs are only compiled when a mask is first asked for
+ * @return true if both sources are loaded, false if reading or resolving an include fails
+ */
+bool GLShaderVariants::setup(const std::string& vertexFilePath, const std::string& fragmentFilePath, const std::vector<std::string>& features)
+{
+    if (32 < features.size())
+    {
+        std::cerr << "GLShaderVariants: at most 32 features fit a mask" << std::endl;
+        return false;
+    }
+
+    if (!sLoadSources(vertexFilePath, fragmentFilePath, m_sources))
+        return false;
+
+    m_vertexPath = vertexFilePath;
+    m_fragmentPath = fragmentFilePath;
+    m_features = features;
+    m_programs.clear();
+    return true;
+}
+
+/**
+ * @param directory the directory the program binaries are stored in, an empty string disables the cache
+ * @brief passes the binary cache directory on to every variant that gets built
+ */
+void GLShaderVariants::setBinaryCacheDir(const std::string& directory)
+{
+    m_cacheDir = directory;
+}
+
+/**
+ * @param blockName the name of the uniform block in the shaders
+ * @param bindingPoint the uniform buffer binding point the block should read from
+ * @brief every variant that gets built has the block bound to the binding point
+ */
+void GLShaderVariants::addUniformBlock(const std::string& blockName, GLuint bindingPoint)
+{
+    m_uniformBlocks.emplace_back(blockName, bindingPoint);
+}
+
+/**
+ * @param name the name of the sampler uniform
+ * @param unit the texture unit the sampler reads from
+ * @brief every variant that uses the sampler has it set to the texture unit once when it's built
+ */
+void GLShaderVariants::addSampler(const std::string& name, int unit)
+{
+    m_samplers.emplace_back(name, unit);
+}
+
+/**
+ * @param masks the feature masks to build
+ * @brief compiles the given variants up front so switching to them later doesn't stall a frame
+ * @return true if all variants are built, false if one of them fails
+ */
+bool GLShaderVariants::prebuild(const std::vector<std::uint32_t>& masks)
+{
+    bool success = true;
+    for (std::uint32_t mask : masks)
+    {
+        if (!get(mask))
+            success = false;
+    }
+    return success;
+}
+
+/**
+ * @param mask the bitmask of features the program needs
+ * @brief looks the variant up in the cache and builds it on first use
+ * @return the program of the variant, or nullptr if it failed to build
+ */
+GLShader* GLShaderVariants::get(std::uint32_t mask)
+{
+    std::unordered_map<std::uint32_t, std::unique_ptr<GLShader>>::const_iterator it = m_programs.find(mask);
+    if (it != m_programs.end())
+        return it->second.get();
+
+    std::unique_ptr<GLShader> shader = build(m_sources, mask);
+    GLShader* result = shader.get();
+    if (shader)
+        m_programs.emplace(mask, std::move(shader));
+    return result;
+}
+
+/**
+ * @param sources the new sources, loaded with sLoadSources
+ * @brief rebuilds every variant that was built before from the new sources. The programs are only swapped in when all of them compile and link,
+ * otherwise the old programs and sources stay in use. The new programs start with an empty uniform cache, so GLUniform handles have to be fetched again
+ * when getGeneration changes
+ * @return true if the new programs are in use, false if one of them failed and nothing changed
+ */
+bool GLShaderVariants::reload(const s_ShaderSources& sources)
+{
+    std::unordered_map<std::uint32_t, std::unique_ptr<GLShader>> programs;
+    for (const std::pair<const std::uint32_t, std::unique_ptr<GLShader>>& entry : m_programs)
+    {
+        std::unique_ptr<GLShader> shader = build(sources, entry.first);
+        if (!shader)
+        {
+            std::cerr << "GLShaderVariants: reload failed, keeping the previous programs" << std::endl;
+            return false;
+        }
+        programs.emplace(entry.first, std::move(shader));
+    }
+
+    m_sources = sources;
+    m_programs.swap(programs);
+    ++m_generation;
+    return true;
+}
+
+/**
+ * @brief gives the path of the vertex shader given to setup
+ * @return the vertex shader path
+ */
+const std::string& GLShaderVariants::getVertexPath() const
+{
+    return m_vertexPath;
+}
+
+/**
+ * @brief gives the path of the fragment shader given to setup
+ * @return the fragment shader path
+ */
+const std::string& GLShaderVariants::getFragmentPath() const
+{
+    return m_fragmentPath;
+}
+
+/**
+ * @brief gives every file the current sources were built from, including the included files
+ * @return the paths of the source files
+ */
+const std::vector<std::string>& GLShaderVariants::getSourceFiles() const
+{
+    return m_sources.files;
+}
+
+/**
+ * @brief gives a counter that goes up every time reload swaps in new programs
+ * @return the generation of the programs
+ */
+unsigned int GLShaderVariants::getGeneration() const
+{
+    return m_generation;
+}
+
+/**
+ * @param sources the sources to build from
+ * @param mask the bitmask of features the program needs
+ * @brief injects the defines of the mask into both sources, compiles and links them, and applies the block bindings and samplers
+ * @return the new program, or nullptr if compiling or linking failed
+ */
+std::unique_ptr<GLShader> GLShaderVariants::build(const s_ShaderSources& sources, std::uint32_t mask) const
+{
+    std::vector<std::string> defines;
+    for (std::size_t i = 0; i < m_features.size(); ++i)
+    {
+        if (mask & (1u << i))
+            defines.push_back(m_features[i]);
+    }
+
+    std::unique_ptr<GLShader> shader = std::make_unique<GLShader>();
+    shader->setBinaryCacheDir(m_cacheDir);
+    if (!shader->setupFromSource(sInjectDefines(sources.vertex, defines), sInjectDefines(sources.fragment, defines)))
+    {
+        std::cerr << "GLShaderVariants: failed to build variant 0x" << std::hex << mask << std::dec << std::endl;
+        return nullptr;
+    }
+
+    for (const std::pair<std::string, GLuint>& block : m_uniformBlocks)
+        shader->setUniformBlockBinding(block.first, block.second);
+
+    shader->bind();
+    for (const std::pair<std::string, int>& sampler : m_samplers)
+    {
+        if (shader->hasUniform(sampler.first))
+            shader->setUniform(shader->getUniform<int>(sampler.first), sampler.second);
+    }
+    shader->unbind();
+    return shader;
+}
+
+/**
+ * @param vertexFilePath the file path to the vertex shader
+ * @param fragmentFilePath the file path to the fragment shader
+ * @param out the struct that will hold both sources with their includes resolved
+ * @brief reads both shaders from disk, only does file io so it can run on any thread, like a background thread that prepares a reload
+ * @return true if both sources are loaded, else false and an error message is printed
+ */
+bool GLShaderVariants::sLoadSources(const std::string& vertexFilePath, const std::string& fragmentFilePath, s_ShaderSources& out)
+{
+    s_ShaderSources sources;
+    std::vector<std::string> stack;
+    if (!sResolveIncludes(vertexFilePath, sources.vertex, stack, &sources.files))
+    {
+        std::cerr << "Failed to read vertex shader file" << std::endl;
+        return false;
+    }
+    if (!sResolveIncludes(fragmentFilePath, sources.fragment, stack, &sources.files))
+    {
+        std::cerr << "Failed to read fragment shader file" << std::endl;
+        return false;
+    }
+    out = std::move(sources);
+    return true;
+}
+
+/**
+ * @param filePath the shader file to read
+ * @param out the string that will hold the source with every #include "file" replaced by that file
+ * @brief reads the file and recursively pastes in included files, paths are relative to the including file
+ * @return true if the file and all its includes are read, false on a missing file or an include cycle
+ */
+bool GLShaderVariants::sResolveIncludes(const std::string& filePath, std::string& out)
+{
+    std::vector<std::string> stack;
+    out.clear();
+    return sResolveIncludes(filePath, out, stack, nullptr);
+}
+
+/**
+ * @param filePath the shader file to read
+ * @param out the string the resolved source is appended to
+ * @param stack the files that are currently being included, used to find cycles
+ * @param files when not null every file that is read gets added to it
+ * @brief appends the file to out, #line directives keep the line numbers in compile errors pointing at the right file and line
+ * @return true if the file and all its includes are read, false on a missing file or an include cycle
+ */
+bool GLShaderVariants::sResolveIncludes(const std::string& filePath, std::string& out, std::vector<std::string>& stack, std::vector<std::string>* files)
+{
+    std::string normalized = std::filesystem::path(filePath).lexically_normal().string();
+    if (std::find(stack.begin(), stack.end(), normalized) != stack.end())
+    {
+        std::cerr << "GLShaderVariants: include cycle at " << normalized << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> buffer;
+    if (!GLUtils::sReadShaderFile(normalized.c_str(), buffer))
+        return false;
+
+    std::size_t sourceIndex = stack.size();
+    stack.push_back(normalized);
+    if (files && std::find(files->begin(), files->end(), normalized) == files->end())
+        files->push_back(normalized);
+
+    std::istringstream stream(std::string(buffer.begin(), buffer.end()));
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+        std::size_t start = line.find_first_not_of(" \t");
+        if (std::string::npos == start || 0 != line.compare(start, 8, "#include"))
+        {
+            out += line;
+            out += '\n';
+            continue;
+        }
+
+        std::size_t open = line.find('"', start);
+        std::size_t close = (std::string::npos == open) ? std::string::npos : line.find('"', open + 1);
+        if (std::string::npos == close)
+        {
+            std::cerr << normalized << ":" << lineNumber << ": malformed #include" << std::endl;
+            return false;
+        }
+
+        std::filesystem::path includePath = std::filesystem::path(normalized).parent_path() / line.substr(open + 1, close - open - 1);
+        out += "#line 1 " + std::to_string(stack.size()) + "\n";
+        if (!sResolveIncludes(includePath.string(), out, stack, files))
+        {
+            std::cerr << "  included from " << normalized << ":" << lineNumber << std::endl;
+            return false;
+        }
+        out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+    }
+
+    stack.pop_back();
+    return true;
+}
+
+/**
+ * @param source the shader source starting with a #version line
+ * @param defines the names to define
+ * @brief inserts a "#define NAME 1" for every name right after the #version line, which has to stay the first statement
+ * @return the source with the defines added
+ */
+std::string GLShaderVariants::sInjectDefines(const std::string& source, const std::vector<std::string>& defines)
+{
+    if (defines.empty())
+        return source;
+
+    std::size_t insertAt = 0;
+    std::size_t version = source.find("#version");
+    if (std::string::npos != version)
+    {
+        std::size_t lineEnd = source.find('\n', version);
+        insertAt = (std::string::npos == lineEnd) ? source.size() : lineEnd + 1;
+    }
+
+    std::string block;
+    for (const std::string& define : defines)
+        block += "#define " + define + " 1\n";
+
+    std::size_t versionLines = static_cast<std::size_t>(std::count(source.begin(), source.begin() + insertAt, '\n'));
+    block += "#line " + std::to_string(versionLines + 1) + " 0\n";
+
+    std::string result = source;
+    result.insert(insertAt, block);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "GLState.hpp"
+
+// shadow value for state that isn't known, the next request for it always reaches gl
+static const GLuint sUnknown = 0xffffffffu;
+
+/**
+ * @param program the program to use, 0 for none
+ * @brief calls glUseProgram when the program isn't in use already
+ */
+void GLState::sUseProgram(GLuint program)
+{
+    if (sChanged(sState().program, program))
+        glUseProgram(program);
+}
+
+/**
+ * @param vertexArray the vertex array object to bind, 0 for none
+ * @brief calls glBindVertexArray when it isn't bound already. The element array buffer binding belongs to the vertex array,
+ * so its shadow is unknown after every vertex array change
+ */
+void GLState::sBindVertexArray(GLuint vertexArray)
+{
+    s_State& state = sState();
+    if (!sChanged(state.vertexArray, vertexArray))
+        return;
+    glBindVertexArray(vertexArray);
+    state.buffers[GL_ELEMENT_ARRAY_BUFFER] = sUnknown;
+}
+
+/**
+ * @param target the buffer target, e.g. GL_ARRAY_BUFFER
+ * @param buffer the buffer to bind, 0 for none
+ * @brief calls glBindBuffer when the buffer isn't bound to target already
+ */
+void GLState::sBindBuffer(GLenum target, GLuint buffer)
+{
+    s_State& state = sState();
+    std::unordered_map<GLenum, GLuint>::iterator found = state.buffers.emplace(target, sUnknown).first;
+    if (sChanged(found->second, buffer))
+        glBindBuffer(target, buffer);
+}
+
+/**
+ * @param target the indexed target, GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+ * @param index the binding point
+ * @param buffer the buffer to bind
+ * @param offset the byte offset of the range
+ * @param size the byte size of the range
+ * @brief always calls glBindBufferRange as ring buffers move the offset every frame, and records the generic binding it sets as well
+ */
+void GLState::sBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    s_State& state = sState();
+    ++state.frame.requested;
+    ++state.frame.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+    state.buffers[target] = buffer;
+}
+
+/**
+ * @param unit the texture unit, 0 for GL_TEXTURE0
+ * @brief calls glActiveTexture when the unit isn't active already
+ */
+void GLState::sActiveTexture(GLuint unit)
+{
+    if (sChanged(sState().activeUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+/**
+ * @param target the texture target, e.g. GL_TEXTURE_2D
+ * @param texture the texture to bind, 0 for none
+ * @brief calls glBindTexture when the texture isn't bound to target on the active unit already
+ */
+void GLState::sBindTexture(GLenum target, GLuint texture)
+{
+    s_State& state = sState();
+    if (sUnknown == state.activeUnit)
+        sActiveTexture(0);
+
+    std::uint64_t key = (static_cast<std::uint64_t>(state.activeUnit) << 32) | target;
+    std::unordered_map<std::uint64_t, GLuint>::iterator found = state.textures.emplace(key, sUnknown).first;
+    if (sChanged(found->second, texture))
+        glBindTexture(target, texture);
+}
+
+/**
+ * @param unit the texture unit, 0 for GL_TEXTURE0
+ * @param target the texture target, e.g. GL_TEXTURE_2D
+ * @param texture the texture to bind, 0 for none
+ * @brief binds the texture to the unit, the unit is only made active when the binding has to change
+ */
+void GLState::sBindTextureUnit(GLuint unit, GLenum target, GLuint texture)
+{
+    s_State& state = sState();
+    std::uint64_t key = (static_cast<std::uint64_t>(unit) << 32) | target;
+    std::unordered_map<std::uint64_t, GLuint>::iterator found = state.textures.find(key);
+    if (found != state.textures.end() && found->second == texture)
+    {
+        ++state.frame.requested;
+        return;
+    }
+    sActiveTexture(unit);
+    sBindTexture(target, texture);
+}
+
+/**
+ * @param unit the texture unit, 0 for GL_TEXTURE0
+ * @param sampler the sampler to bind, 0 for none
+ * @brief calls glBindSampler when the sampler isn't bound to the unit already
+ */
+void GLState::sBindSampler(GLuint unit, GLuint sampler)
+{
+    s_State& state = sState();
+    std::unordered_map<GLuint, GLuint>::iterator found = state.samplers.emplace(unit, sUnknown).first;
+    if (sChanged(found->second, sampler))
+        glBindSampler(unit, sampler);
+}
+
+/**
+ * @param capability the capability, e.g. GL_DEPTH_TEST
+ * @brief calls glEnable when the capability isn't enabled already
+ */
+void GLState::sEnable(GLenum capability)
+{
+    s_State& state = sState();
+    ++state.frame.requested;
+    std::unordered_map<GLenum, bool>::iterator found = state.capabilities.find(capability);
+    if (found != state.capabilities.end() && found->second)
+        return;
+    ++state.frame.issued;
+    glEnable(capability);
+    state.capabilities[capability] = true;
+}
+
+/**
+ * @param capability the capability, e.g. GL_DEPTH_TEST
+ * @brief calls glDisable when the capability isn't disabled already
+ */
+void GLState::sDisable(GLenum capability)
+{
+    s_State& state = sState();
+    ++state.frame.requested;
+    std::unordered_map<GLenum, bool>::iterator found = state.capabilities.find(capability);
+    if (found != state.capabilities.end() && !found->second)
+        return;
+    ++state.frame.issued;
+    glDisable(capability);
+    state.capabilities[capability] = false;
+}
+
+/**
+ * @param func the depth compare function, e.g. GL_LEQUAL
+ * @brief calls glDepthFunc when the function differs
+ */
+void GLState::sDepthFunc(GLenum func)
+{
+    if (sChanged(sState().depthFunc, func))
+        glDepthFunc(func);
+}
+
+/**
+ * @param mode GL_CCW or GL_CW
+ * @brief calls glFrontFace when the winding differs
+ */
+void GLState::sFrontFace(GLenum mode)
+{
+    if (sChanged(sState().frontFace, mode))
+        glFrontFace(mode);
+}
+
+/**
+ * @param write true to write all four color channels, false to write none
+ * @brief calls glColorMask when the mask differs, passes that only fill the depth buffer or only count samples turn it off
+ */
+void GLState::sColorMask(bool write)
+{
+    if (sChanged(sState().colorMask, write ? 1u : 0u))
+    {
+        GLboolean mask = write ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+    }
+}
+
+/**
+ * @param write true to write depth values, false to only test against them
+ * @brief calls glDepthMask when the mask differs
+ */
+void GLState::sDepthMask(bool write)
+{
+    if (sChanged(sState().depthMask, write ? 1u : 0u))
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+/**
+ * @param program the program that is deleted
+ * @brief drops the program from the shadow state
+ */
+void GLState::sForgetProgram(GLuint program)
+{
+    s_State& state = sState();
+    if (state.program == program)
+        state.program = sUnknown;
+}
+
+/**
+ * @param vertexArray the vertex array that is deleted
+ * @brief drops the vertex array from the shadow state, gl binds 0 in its place
+ */
+void GLState::sForgetVertexArray(GLuint vertexArray)
+{
+    s_State& state = sState();
+    if (state.vertexArray == vertexArray)
+    {
+        state.vertexArray = sUnknown;
+        state.buffers[GL_ELEMENT_ARRAY_BUFFER] = sUnknown;
+    }
+}
+
+/**
+ * @param buffer the buffer that is deleted
+ * @brief drops the buffer from every target it is shadowed on
+ */
+void GLState::sForgetBuffer(GLuint buffer)
+{
+    for (std::pair<const GLenum, GLuint>& binding : sState().buffers)
+    {
+        if (binding.second == buffer)
+            binding.second = sUnknown;
+    }
+}
+
+/**
+ * @param texture the texture that is deleted
+ * @brief drops the texture from every unit it is shadowed on
+ */
+void GLState::sForgetTexture(GLuint texture)
+{
+    for (std::pair<const std::uint64_t, GLuint>& binding : sState().textures)
+    {
+        if (binding.second == texture)
+            binding.second = sUnknown;
+    }
+}
+
+/**
+ * @param sampler the sampler that is deleted
+ * @brief drops the sampler from every unit it is shadowed on
+ */
+void GLState::sForgetSampler(GLuint sampler)
+{
+    for (std::pair<const GLuint, GLuint>& binding : sState().samplers)
+    {
+        if (binding.second == sampler)
+            binding.second = sUnknown;
+    }
+}
+
+/**
+ * @brief forgets all shadowed state, call after gl state was changed outside the wrapper or the context changed
+ */
+void GLState::sInvalidate()
+{
+    s_State& state = sState();
+    s_CallStats frame = state.frame;
+    state = {sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, {}, {}, {}, {}, frame};
+}
+
+/**
+ * @param calls the amount of calls
+ * @brief counts gl calls that aren't state changes, like draws and clears, so the frame stats cover the whole frame
+ */
+void GLState::sCount(unsigned int calls)
+{
+    s_State& state = sState();
+    state.frame.requested += calls;
+    state.frame.issued += calls;
+}
+
+/**
+ * @brief gives the call counts since the last call and starts counting again
+ * @return the requested and issued call counts of the frame
+ */
+GLState::s_CallStats GLState::sEndFrame()
+{
+    s_State& state = sState();
+    s_CallStats frame = state.frame;
+    state.frame = {0, 0};
+    return frame;
+}
+
+/**
+ * @brief gives the shadow state, everything starts unknown
+ * @return the shadow state of the current context
+ */
+GLState::s_State& GLState::sState()
+{
+    static s_State state = {sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, sUnknown, {}, {}, {}, {}, {0, 0}};
+    return state;
+}
+
+/**
+ * @param shadow the shadowed value
+ * @param value the requested value
+ * @brief counts the request and updates the shadow when the value differs
+ * @return true if the gl call has to be made, false if it is redundant
+ */
+bool GLState::sChanged(GLuint& shadow, GLuint value)
+{
+    s_State& state = sState();
+    ++state.frame.requested;
+    if (shadow == value)
+        return false;
+    ++state.frame.issued;
+    shadow = value;
+    return true;
+}
\ No newline at end of file
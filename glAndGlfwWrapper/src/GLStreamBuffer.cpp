@@ -0,0 +1,317 @@
+#include "GLStreamBuffer.hpp"
+#include "GLState.hpp"
+#include <cstring>
+#include <utility>
+
+/**
+ * @param type the type of buffer the ring will be bound as
+ * @param regionCount the amount of regions in the ring, 3 gives triple buffering
+ * @brief sets the type and region count and the rest to default values
+ */
+GLStreamBuffer::GLStreamBuffer(GLBuffer::e_Type type, unsigned int regionCount):
+m_buffer(type),
+m_regionSize(0),
+m_regionCount(0 == regionCount ? 1 : regionCount),
+m_region(0),
+m_mapped(nullptr),
+m_persistent(false)
+{}
+
+/**
+ * @param other the stream buffer with data to be moved
+ * @brief moves the data to take ownership and sets the parameters of other to default
+ */
+GLStreamBuffer::GLStreamBuffer(GLStreamBuffer&& other):
+m_buffer(std::move(other.m_buffer)),
+m_regionSize(other.m_regionSize),
+m_regionCount(other.m_regionCount),
+m_region(other.m_region),
+m_mapped(other.m_mapped),
+m_persistent(other.m_persistent),
+m_fences(std::move(other.m_fences))
+{
+    other.m_regionSize = 0;
+    other.m_region = 0;
+    other.m_mapped = nullptr;
+    other.m_persistent = false;
+    other.m_fences.clear();
+}
+
+/**
+ * @brief deletes the fences that are still pending, the buffer itself is unmapped and deleted by GLBuffer
+ */
+GLStreamBuffer::~GLStreamBuffer()
+{
+    deleteFences();
+}
+
+/**
+ * @param other the stream buffer with data to be moved
+ * @brief takes the ownership of other data and sets other variables to default
+ * @return the moved GLStreamBuffer
+ */
+GLStreamBuffer& GLStreamBuffer::operator=(GLStreamBuffer&& other)
+{
+    if (this != &other)
+    {
+        deleteFences();
+
+        m_buffer = std::move(other.m_buffer);
+        m_regionSize = other.m_regionSize;
+        m_regionCount = other.m_regionCount;
+        m_region = other.m_region;
+        m_mapped = other.m_mapped;
+        m_persistent = other.m_persistent;
+        m_fences = std::move(other.m_fences);
+
+        other.m_regionSize = 0;
+        other.m_region = 0;
+        other.m_mapped = nullptr;
+        other.m_persistent = false;
+        other.m_fences.clear();
+    }
+    return *this;
+}
+
+/**
+ * @param regionSize the amount of bytes one frame can write
+ * @brief generates the buffer and allocates regionCount regions of regionSize, rounded up to the offset alignment of the buffer type.
+ * When ARB_buffer_storage is available the storage is immutable and persistently mapped, otherwise the ring falls back to orphaning with unsynchronized maps
+ * @return true if the buffer is allocated (and mapped), false on error with message printed
+ */
+bool GLStreamBuffer::setup(GLsizeiptr regionSize)
+{
+    if (0 >= regionSize)
+    {
+        std::cerr << "GLStreamBuffer: region size must be greater then 0" << std::endl;
+        return false;
+    }
+
+    if (!m_buffer.setup())
+    {
+        std::cerr << "GLStreamBuffer: failed to generate buffer" << std::endl;
+        return false;
+    }
+
+    GLsizeiptr alignment = getOffsetAlignment();
+    m_regionSize = ((regionSize + alignment - 1) / alignment) * alignment;
+    m_region = 0;
+    m_fences.assign(m_regionCount, nullptr);
+
+    GLenum target = GLBuffer::sToGLenum(m_buffer.getType());
+    GLsizeiptr totalSize = m_regionSize * m_regionCount;
+
+    m_buffer.bind();
+    m_persistent = GLAD_GL_ARB_buffer_storage;
+    if (m_persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, totalSize, nullptr, flags);
+        m_mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, totalSize, flags));
+        if (!m_mapped)
+        {
+            std::cerr << "GLStreamBuffer: failed to persistently map buffer" << std::endl;
+            m_buffer.unbind();
+            return false;
+        }
+    }
+    else
+        glBufferData(target, totalSize, nullptr, GL_STREAM_DRAW);
+
+    m_buffer.unbind();
+    return true;
+}
+
+/**
+ * @brief gives a pointer to the start of the current region, waits on its fence first if the GPU may still read from it.
+ * On the fallback path the whole buffer is orphaned when the ring wraps around so the unsynchronized map never stalls
+ * @return a writable pointer of getRegionSize() bytes, or nullptr on failure
+ * @warning every beginWrite must be followed by endWrite before the region is used for drawing
+ */
+void* GLStreamBuffer::beginWrite()
+{
+    if (m_persistent)
+    {
+        waitForRegion(m_region);
+        return m_mapped + getOffset();
+    }
+
+    GLenum target = GLBuffer::sToGLenum(m_buffer.getType());
+    m_buffer.bind();
+    if (0 == m_region)
+        glBufferData(target, m_regionSize * m_regionCount, nullptr, GL_STREAM_DRAW);
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* ptr = glMapBufferRange(target, getOffset(), m_regionSize, flags);
+    if (!ptr)
+        std::cerr << "GLStreamBuffer: failed to map region " << m_region << std::endl;
+    return ptr;
+}
+
+/**
+ * @brief ends the write to the current region, on the fallback path the region is unmapped. Persistent coherent maps need no action
+ */
+void GLStreamBuffer::endWrite()
+{
+    if (m_persistent)
+        return;
+
+    m_buffer.bind();
+    glUnmapBuffer(GLBuffer::sToGLenum(m_buffer.getType()));
+}
+
+/**
+ * @brief marks the current region as in use by the commands issued so far and moves the ring to the next region
+ * @attention call this once per frame after the last draw that reads from the current region
+ */
+void GLStreamBuffer::finishRegion()
+{
+    if (m_persistent)
+    {
+        if (m_fences[m_region])
+            glDeleteSync(m_fences[m_region]);
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    m_region = (m_region + 1) % m_regionCount;
+}
+
+/**
+ * @param data pointer to the data to copy
+ * @param size the amount of bytes to copy
+ * @brief copies size bytes into the current region of the ring
+ * @return true if the data is written, false if size doesn't fit a region or mapping failed
+ */
+bool GLStreamBuffer::write(const void* data, GLsizeiptr size)
+{
+    if (!data || 0 >= size || size > m_regionSize)
+    {
+        std::cerr << "GLStreamBuffer: write of " << size << " bytes doesn't fit region of " << m_regionSize << " bytes" << std::endl;
+        return false;
+    }
+
+    void* dst = beginWrite();
+    if (!dst)
+        return false;
+    std::memcpy(dst, data, static_cast<std::size_t>(size));
+    endWrite();
+    return true;
+}
+
+/**
+ * @brief binds the whole ring buffer to its target
+ */
+void GLStreamBuffer::bind() const
+{
+    m_buffer.bind();
+}
+
+/**
+ * @param index the binding point of the uniform or shader storage block
+ * @brief binds the current region to the given indexed binding point
+ */
+void GLStreamBuffer::bindRange(GLuint index) const
+{
+    GLState::sBindBufferRange(GLBuffer::sToGLenum(m_buffer.getType()), index, m_buffer.getId(), getOffset(), m_regionSize);
+}
+
+/**
+ * @brief gets the id of the buffer
+ * @return the id of the buffer
+ */
+GLuint GLStreamBuffer::getId() const
+{
+    return m_buffer.getId();
+}
+
+/**
+ * @brief gets the byte offset of the current region, to use as the base offset for attribute pointers or draws
+ * @return the byte offset of the current region
+ */
+GLintptr GLStreamBuffer::getOffset() const
+{
+    return static_cast<GLintptr>(m_region) * m_regionSize;
+}
+
+/**
+ * @brief gets the size of one region after alignment
+ * @return the size of one region in bytes
+ */
+GLsizeiptr GLStreamBuffer::getRegionSize() const
+{
+    return m_regionSize;
+}
+
+/**
+ * @brief checks if the ring uses the persistent mapped path
+ * @return true if the buffer is persistently mapped, false if it uses the orphaning fallback
+ */
+bool GLStreamBuffer::isPersistent() const
+{
+    return m_persistent;
+}
+
+/**
+ * @brief gets the alignment a region offset needs for the type of buffer
+ * @return the offset alignment in bytes
+ */
+GLsizeiptr GLStreamBuffer::getOffsetAlignment() const
+{
+    GLint alignment = 0;
+    switch (m_buffer.getType())
+    {
+        case GLBuffer::e_Type::Uniform:
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            break;
+        case GLBuffer::e_Type::ShaderStorage:
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            break;
+        default:
+            break;
+    }
+    if (16 > alignment)
+        alignment = 16;
+    return static_cast<GLsizeiptr>(alignment);
+}
+
+/**
+ * @param region the region that is about to be written
+ * @brief blocks until the GPU has finished the commands that read from the region, only stalls when the CPU is regionCount frames ahead
+ */
+void GLStreamBuffer::waitForRegion(unsigned int region)
+{
+    GLsync fence = m_fences[region];
+    if (!fence)
+        return;
+
+    GLbitfield waitFlags = 0;
+    GLuint64 timeout = 0;
+    while (true)
+    {
+        GLenum result = glClientWaitSync(fence, waitFlags, timeout);
+        if (GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result)
+            break;
+        if (GL_WAIT_FAILED == result)
+        {
+            std::cerr << "GLStreamBuffer: waiting on fence failed" << std::endl;
+            break;
+        }
+        waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        timeout = 1000000;
+    }
+
+    glDeleteSync(fence);
+    m_fences[region] = nullptr;
+}
+
+/**
+ * @brief deletes all pending fences
+ */
+void GLStreamBuffer::deleteFences()
+{
+    for (GLsync& fence : m_fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
\ No newline at end of file
@@ -2,10 +2,15 @@
 #include "stb_image.h"
 #include "GLTexture.hpp"
 #include "GLUtils.hpp"
+#include "GLState.hpp"
+#include "GLTextureContainer.hpp"
+#include <filesystem>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 
 /**
  * @param value the value to set between min and max
@@ -26,7 +31,15 @@ static s_vec2 sClamp(const s_vec2& value, float minVal = 0.f, float maxVal = 1.f
 /**
  * @brief initializes all object variables
  */
-GLTexture::GLTexture(): m_textureId(0), m_width(0), m_height(0), m_channels(0) {}
+GLTexture::GLTexture():
+m_textureId(0),
+m_width(0),
+m_height(0),
+m_channels(0),
+m_unpackBuffer(GLBuffer::e_Type::PixelUnpack),
+m_pendingId(0),
+m_pendingFence(nullptr)
+{}
 
 /**
  * @param other the old texture object
@@ -36,12 +49,19 @@ GLTexture::GLTexture(GLTexture&& other):
 m_textureId(other.m_textureId),
 m_width(other.m_width),
 m_height(other.m_height),
-m_channels(other.m_channels)
+m_channels(other.m_channels),
+m_decode(std::move(other.m_decode)),
+m_unpackBuffer(std::move(other.m_unpackBuffer)),
+m_pending(std::move(other.m_pending)),
+m_pendingId(other.m_pendingId),
+m_pendingFence(other.m_pendingFence)
 {
     other.m_textureId = 0;
     other.m_width = 0;
     other.m_height = 0;
     other.m_channels = 0;
+    other.m_pendingId = 0;
+    other.m_pendingFence = nullptr;
 }
 
 /**
@@ -54,16 +74,24 @@ GLTexture& GLTexture::operator=(GLTexture&& other)
     if(this != &other)
     {
         freeTexture();
+        freePending();
 
         m_textureId = other.m_textureId;
         m_width = other.m_width;
         m_height = other.m_height;
         m_channels = other.m_channels;
+        m_decode = std::move(other.m_decode);
+        m_unpackBuffer = std::move(other.m_unpackBuffer);
+        m_pending = std::move(other.m_pending);
+        m_pendingId = other.m_pendingId;
+        m_pendingFence = other.m_pendingFence;
 
         other.m_textureId = 0;
         other.m_width = 0;
         other.m_height = 0;
         other.m_channels = 0;
+        other.m_pendingId = 0;
+        other.m_pendingFence = nullptr;
     }
     return *this;
 }
@@ -73,17 +101,19 @@ GLTexture& GLTexture::operator=(GLTexture&& other)
  */
 GLTexture::~GLTexture()
 {
+    freePending();
     freeTexture();
 }
 
 /**
- * @param path the path to the texture
+ * @param path the path to the texture, .stex files are loaded as baked container
  * @brief initializes the texture
  * @return true if texture setup is successfull, false on failed
  */
 bool GLTexture::setup(const std::string& path)
 {
-    if (!loadFromFile(path))
+    bool loaded = (".stex" == std::filesystem::path(path).extension()) ? loadFromContainer(path) : loadFromFile(path);
+    if (!loaded)
     {
         std::cerr << "failed to load texture" << std::endl;
         return false;
@@ -91,6 +121,55 @@ bool GLTexture::setup(const std::string& path)
     return true;
 }
 
+/**
+ * @param path the path to the texture
+ * @brief starts decoding the texture on a worker thread, until update() swaps the new texture in the previous texture stays bound,
+ * or a 1x1 white placeholder when there is none yet
+ * @return true if the decode is started, false if a load is already running or the placeholder can't be created
+ */
+bool GLTexture::setupAsync(const std::string& path)
+{
+    if (isLoading())
+    {
+        std::cerr << "setupAsync: texture is still loading, ignoring " << path << std::endl;
+        return false;
+    }
+
+    if (0 == m_textureId && !createPlaceholder())
+    {
+        std::cerr << "setupAsync: failed to create placeholder texture" << std::endl;
+        return false;
+    }
+
+    m_decode = std::async(std::launch::async, [path]()
+    {
+        std::unique_ptr<s_Image> image = std::make_unique<s_Image>();
+        if (!sDecode(path, *image))
+            image.reset();
+        return image;
+    });
+    return true;
+}
+
+/**
+ * @param image the decoded image
+ * @brief starts uploading an image decoded elsewhere through the pixel unpack buffer, update() swaps it in like a setupAsync(path) load
+ * @return true if the upload is queued, false if a load is already running or the upload can't be started
+ */
+bool GLTexture::setupAsync(std::unique_ptr<s_Image> image)
+{
+    if (isLoading())
+    {
+        std::cerr << "setupAsync: texture is still loading, ignoring the image" << std::endl;
+        return false;
+    }
+
+    if (!image || (0 == m_textureId && !createPlaceholder()))
+        return false;
+
+    return uploadPending(std::move(image));
+}
+
 /**
  * @brief gives the id of the texture
  * @return the texture id
@@ -102,13 +181,13 @@ GLuint GLTexture::getTextureId()
 
 /**
  * @param path the path to the texture
- * @brief loads the texture info from the path and makes it ready for use
- * @return true if texture was loaded in correctly, false if reading into the file or decoding it fails
+ * @param image the image that will hold the decoded pixels
+ * @brief reads and decodes the image file, flipped so the first row is the bottom like gl expects. Doesn't touch gl so it is safe on any thread.
+ * 3 channel images are padded to 4 channels while decoding, RGB8 has no native layout on most hardware so the driver would repack it on upload
+ * @return true if the image is decoded, false if reading into the file or decoding it fails
  */
-bool GLTexture::loadFromFile(const std::string& path)
+bool GLTexture::sDecode(const std::string& path, s_Image& image)
 {
-    freeTexture();
-
     std::vector<unsigned char> buffer;
     if(!GLUtils::sReadTexture(path.c_str(), buffer))
     {
@@ -116,42 +195,173 @@ bool GLTexture::loadFromFile(const std::string& path)
         return false;
     }
 
-    buffer.emplace_back('\0');
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &m_width, &m_height, &m_channels, 0);
+    int fileChannels = 0;
+    if (!stbi_info_from_memory(buffer.data(), static_cast<int>(buffer.size()), &image.width, &image.height, &fileChannels))
+    {
+        std::cerr << "failed to decode image: " << path << std::endl;
+        return false;
+    }
+    int requestedChannels = (3 == fileChannels) ? 4 : 0;
+
+    stbi_set_flip_vertically_on_load_thread(true);
+    unsigned char* data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &image.width, &image.height, &fileChannels, requestedChannels);
 
     if (!data)
     {
         std::cerr << "failed to decode image: " << path << std::endl;
         return false;
     }
+    image.channels = requestedChannels ? requestedChannels : fileChannels;
+
+    std::size_t size = static_cast<std::size_t>(image.width) * image.height * image.channels;
+    image.pixels.assign(data, data + size);
+    stbi_image_free(data);
+    return true;
+}
 
-    GLenum format = GL_RGB;
-    if (1 == m_channels)
-        format = GL_RED;
-    else if (3 == m_channels)
-        format = GL_RGB;
-    else if (4 == m_channels)
-        format = GL_RGBA;
+/**
+ * @param path the path to the texture
+ * @brief loads the texture info from the path and makes it ready for use
+ * @return true if texture was loaded in correctly, false if reading into the file or decoding it fails
+ */
+bool GLTexture::loadFromFile(const std::string& path)
+{
+    s_Image image;
+    if (!sDecode(path, image))
+        return false;
+    return loadFromImage(image);
+}
+
+/**
+ * @param image the decoded image
+ * @brief uploads the image straight from client memory and generates its mips, the call returns once the driver has copied the pixels
+ * @return true if the texture is created, false if the image is empty
+ */
+bool GLTexture::loadFromImage(const s_Image& image)
+{
+    if (0 >= image.width || 0 >= image.height || image.pixels.empty())
+        return false;
+
+    freeTexture();
+    m_width = image.width;
+    m_height = image.height;
+    m_channels = image.channels;
 
     glGenTextures(1, &m_textureId);
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
+    GLState::sBindTexture(GL_TEXTURE_2D, m_textureId);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
+    sAllocateStorage(sLevelCount(m_width, m_height), m_channels, m_width, m_height);
+    sUploadBaseLevel(m_channels, m_width, m_height, image.pixels.data());
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GLState::sBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
-    data = nullptr;
+/**
+ * @param path the path to the .stex container made by texbake
+ * @brief maps the container and uploads every baked mip level as is, no decoding or mip generation happens at runtime.
+ * The storage is allocated once with glTexStorage2D when ARB_texture_storage is available, per level otherwise
+ * @return true if the texture is uploaded, false if the container is invalid or its format isn't supported
+ */
+bool GLTexture::loadFromContainer(const std::string& path)
+{
+    GLTextureContainer container;
+    if (!container.open(path))
+        return false;
+
+    const GLTextureContainer::s_Header& header = container.getHeader();
+    if (header.compressed && !GLAD_GL_EXT_texture_compression_s3tc)
+    {
+        std::cerr << "loadFromContainer: " << path << " is BC1 compressed but S3TC is not supported" << std::endl;
+        return false;
+    }
 
+    freeTexture();
+    glGenTextures(1, &m_textureId);
+    GLState::sBindTexture(GL_TEXTURE_2D, m_textureId);
+
+    GLsizei levelCount = static_cast<GLsizei>(header.levelCount);
+    if (GLAD_GL_ARB_texture_storage)
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, header.internalFormat, header.width, header.height);
+
+    for (GLsizei i = 0; i < levelCount; ++i)
+    {
+        const GLTextureContainer::s_Level& level = container.getLevel(i);
+        const unsigned char* data = container.getLevelData(i);
+        GLsizei size = static_cast<GLsizei>(level.size);
+        if (GLAD_GL_ARB_texture_storage && header.compressed)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, header.internalFormat, size, data);
+        else if (GLAD_GL_ARB_texture_storage)
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, header.format, GL_UNSIGNED_BYTE, data);
+        else if (header.compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, header.internalFormat, level.width, level.height, 0, size, data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, i, header.internalFormat, level.width, level.height, 0, header.format, GL_UNSIGNED_BYTE, data);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    GLState::sBindTexture(GL_TEXTURE_2D, 0);
+
+    m_width = static_cast<int>(header.width);
+    m_height = static_cast<int>(header.height);
+    m_channels = header.compressed ? 3 : 4;
     return true;
 }
 
+/**
+ * @brief advances an async load, call once per frame on the gl thread before binding.
+ * A finished decode is copied into the pixel unpack buffer and the texture and its mips are created from it on the gpu,
+ * the new texture replaces the bound one only once its fence has signaled so the frame never waits on the upload
+ * @return true on the frame the new texture is swapped in, false otherwise
+ */
+bool GLTexture::update()
+{
+    if (m_pendingFence)
+    {
+        GLenum result = glClientWaitSync(m_pendingFence, 0, 0);
+        if (GL_TIMEOUT_EXPIRED == result)
+            return false;
+        if (GL_WAIT_FAILED == result)
+            std::cerr << "update: waiting on texture upload failed" << std::endl;
+
+        glDeleteSync(m_pendingFence);
+        m_pendingFence = nullptr;
+
+        freeTexture();
+        m_textureId = m_pendingId;
+        m_width = m_pending->width;
+        m_height = m_pending->height;
+        m_channels = m_pending->channels;
+        m_pendingId = 0;
+        m_pending.reset();
+        return true;
+    }
+
+    if (!m_decode.valid() || std::future_status::ready != m_decode.wait_for(std::chrono::seconds(0)))
+        return false;
+
+    std::unique_ptr<s_Image> image = m_decode.get();
+    if (!image)
+    {
+        std::cerr << "update: texture decode failed, keeping the current texture" << std::endl;
+        return false;
+    }
+
+    if (!uploadPending(std::move(image)))
+        std::cerr << "update: texture upload failed, keeping the current texture" << std::endl;
+    return false;
+}
+
+/**
+ * @brief checks if a texture is being decoded or uploaded
+ * @return true while an async load hasn't been swapped in yet
+ */
+bool GLTexture::isLoading() const
+{
+    return m_decode.valid() || nullptr != m_pendingFence;
+}
+
 /**
  * @param slot the slot the texture will hold
  * @brief activates the texture on the given slot and bind the texture
@@ -159,8 +369,7 @@ bool GLTexture::loadFromFile(const std::string& path)
 
 void GLTexture::bind(unsigned int slot) const
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
+    GLState::sBindTextureUnit(slot, GL_TEXTURE_2D, m_textureId);
 }
 
 /**
@@ -168,7 +377,7 @@ void GLTexture::bind(unsigned int slot) const
  */
 void GLTexture::unbind() const
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::sBindTexture(GL_TEXTURE_2D, 0);
 }
 
 /**
@@ -178,17 +387,201 @@ void GLTexture::freeTexture()
 {
     if (0 != m_textureId)
     {
+        GLState::sForgetTexture(m_textureId);
         glDeleteTextures(1, &m_textureId);
         m_textureId = 0;
     }
 }
 
+/**
+ * @brief frees a texture that is uploaded but not swapped in yet, together with its fence
+ */
+void GLTexture::freePending()
+{
+    if (m_pendingFence)
+    {
+        glDeleteSync(m_pendingFence);
+        m_pendingFence = nullptr;
+    }
+    if (0 != m_pendingId)
+    {
+        GLState::sForgetTexture(m_pendingId);
+        glDeleteTextures(1, &m_pendingId);
+        m_pendingId = 0;
+    }
+    m_pending.reset();
+}
+
+/**
+ * @brief creates a 1x1 white texture to sample while the real one loads
+ * @return true if the texture is created, false if no texture id could be generated
+ */
+bool GLTexture::createPlaceholder()
+{
+    const unsigned char white[4] = {255, 255, 255, 255};
+
+    glGenTextures(1, &m_textureId);
+    if (0 == m_textureId)
+        return false;
+
+    GLState::sBindTexture(GL_TEXTURE_2D, m_textureId);
+    sAllocateStorage(1, 4, 1, 1);
+    sUploadBaseLevel(4, 1, 1, white);
+    GLState::sBindTexture(GL_TEXTURE_2D, 0);
+
+    m_width = 1;
+    m_height = 1;
+    m_channels = 4;
+    return true;
+}
+
+/**
+ * @param image the decoded image to upload
+ * @brief copies the pixels into the orphaned pixel unpack buffer and creates the pending texture from it.
+ * The transfer and the mip generation run on the gpu after this returns, a fence marks when the texture is complete
+ * @return true if the upload is queued, false if the buffer couldn't be created or mapped
+ */
+bool GLTexture::uploadPending(std::unique_ptr<s_Image> image)
+{
+    GLsizeiptr size = static_cast<GLsizeiptr>(image->pixels.size());
+    if (0 == m_unpackBuffer.getId() && !m_unpackBuffer.setup())
+        return false;
+
+    m_unpackBuffer.bind();
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst)
+    {
+        m_unpackBuffer.unbind();
+        return false;
+    }
+    std::memcpy(dst, image->pixels.data(), image->pixels.size());
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    freePending();
+    glGenTextures(1, &m_pendingId);
+    GLState::sBindTexture(GL_TEXTURE_2D, m_pendingId);
+
+    // with a pixel unpack buffer bound the data pointer is an offset into it
+    sAllocateStorage(sLevelCount(image->width, image->height), image->channels, image->width, image->height);
+    sUploadBaseLevel(image->channels, image->width, image->height, nullptr);
+    m_unpackBuffer.unbind();
+    glGenerateMipmap(GL_TEXTURE_2D);
+    GLState::sBindTexture(GL_TEXTURE_2D, 0);
+
+    m_pendingFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    image->pixels.clear();
+    image->pixels.shrink_to_fit();
+    m_pending = std::move(image);
+    return true;
+}
+
+/**
+ * @param channels the amount of channels of the image
+ * @param internalFormat will hold the sized internal format
+ * @param format will hold the pixel format of the upload
+ * @brief gives the sized internal format and matching pixel format for the amount of channels
+ */
+void GLTexture::sFormats(int channels, GLenum& internalFormat, GLenum& format)
+{
+    switch (channels)
+    {
+        case 1:
+            internalFormat = GL_R8;
+            format = GL_RED;
+            break;
+        case 2:
+            internalFormat = GL_RG8;
+            format = GL_RG;
+            break;
+        case 3:
+            internalFormat = GL_RGB8;
+            format = GL_RGB;
+            break;
+        default:
+            internalFormat = GL_RGBA8;
+            format = GL_RGBA;
+            break;
+    }
+}
+
+/**
+ * @param width the width of the base level
+ * @param height the height of the base level
+ * @brief counts the levels of a full mip chain
+ * @return the amount of levels down to 1x1
+ */
+GLsizei GLTexture::sLevelCount(int width, int height)
+{
+    GLsizei levels = 1;
+    int size = std::max(width, height);
+    while (1 < size)
+    {
+        size /= 2;
+        ++levels;
+    }
+    return levels;
+}
+
+/**
+ * @param levels the amount of mip levels
+ * @param channels the amount of channels of the image
+ * @param width the width of the base level
+ * @param height the height of the base level
+ * @brief allocates immutable storage with a sized format for the bound texture, without ARB_texture_storage every level is specified
+ * with glTexImage2D and the level range is limited so the texture is complete the same way
+ */
+void GLTexture::sAllocateStorage(GLsizei levels, int channels, int width, int height)
+{
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    sFormats(channels, internalFormat, format);
+
+    if (GLAD_GL_ARB_texture_storage)
+    {
+        glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+        return;
+    }
+
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+/**
+ * @param channels the amount of channels of the pixels
+ * @param width the width of the base level
+ * @param height the height of the base level
+ * @param pixels the tightly packed pixels, or the offset into the bound pixel unpack buffer
+ * @brief writes the base level of the bound texture, the unpack alignment is set to the largest one the row size allows
+ * so tightly packed 1 and 2 channel rows are read correctly, and put back to the default after
+ */
+void GLTexture::sUploadBaseLevel(int channels, int width, int height, const void* pixels)
+{
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    sFormats(channels, internalFormat, format);
+
+    std::size_t rowSize = static_cast<std::size_t>(width) * channels;
+    GLint alignment = (0 == rowSize % 4) ? 4 : (0 == rowSize % 2) ? 2 : 1;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 /**
  * @param indices the vector holding all the faces of the object
  * @param out the s_vec2 vector that will hold the texure coordinates
  * @brief creates the texture coordinates so the texture is taking up 1 face
  */
-void GLTexture::generateTexCoordPerFace(
+void GLTexture::sGenerateTexCoordPerFace(
     const std::vector<unsigned int>& indices,
     std::vector<s_vec2>& out)
 {
@@ -209,13 +602,13 @@ void GLTexture::generateTexCoordPerFace(
  * @param out the s_vec2 vector that will hold the coordinates of the texture
  * @brief generate the texture coords to go over the hole object
  */
-void GLTexture::generateTexCoordGlobal(
+void GLTexture::sGenerateTexCoordGlobal(
     const std::vector<s_vec3>& vertices,
     const std::vector<unsigned int>& indices,
     std::vector<s_vec2>& out)
 {
     out.clear();
-    out.reserve(vertices.size());
+    out.resize(vertices.size(), {0.f, 0.f});
 
     auto project = [](const s_vec3& v, int majorAxis) -> s_vec2
     {
@@ -0,0 +1,475 @@
+#include "GLTextureContainer.hpp"
+#include "GLUtils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+/**
+ * @brief sets the container to empty, call open to map a file
+ */
+GLTextureContainer::GLTextureContainer():
+m_data(nullptr),
+m_size(0),
+m_mapped(false),
+m_header()
+{}
+
+/**
+ * @param other the container with the mapping to be moved
+ * @brief takes over the mapping or buffer of other and leaves other empty
+ */
+GLTextureContainer::GLTextureContainer(GLTextureContainer&& other):
+m_data(other.m_data),
+m_size(other.m_size),
+m_mapped(other.m_mapped),
+m_buffer(std::move(other.m_buffer)),
+m_header(other.m_header),
+m_levels(std::move(other.m_levels))
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_mapped = false;
+    other.m_levels.clear();
+}
+
+/**
+ * @brief unmaps the file if it is still open
+ */
+GLTextureContainer::~GLTextureContainer()
+{
+    close();
+}
+
+/**
+ * @param other the container with the mapping to be moved
+ * @brief closes the current file and takes over the mapping or buffer of other
+ * @return the moved GLTextureContainer
+ */
+GLTextureContainer& GLTextureContainer::operator=(GLTextureContainer&& other)
+{
+    if (this != &other)
+    {
+        close();
+
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_mapped = other.m_mapped;
+        m_buffer = std::move(other.m_buffer);
+        m_header = other.m_header;
+        m_levels = std::move(other.m_levels);
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+        other.m_levels.clear();
+    }
+    return *this;
+}
+
+/**
+ * @param path the path to the .stex file
+ * @brief maps the file read only and checks the header and level table, the level data is only paged in when it is uploaded.
+ * Platforms without mmap read the file into memory instead
+ * @return true if the container is valid and ready to upload, false on error with message printed
+ */
+bool GLTextureContainer::open(const std::string& path)
+{
+    close();
+
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (-1 == fd)
+    {
+        std::cerr << "GLTextureContainer: failed to open " << path << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (-1 == ::fstat(fd, &info) || 0 == info.st_size)
+    {
+        std::cerr << "GLTextureContainer: failed to stat " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == mapping)
+    {
+        std::cerr << "GLTextureContainer: failed to map " << path << std::endl;
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(mapping);
+    m_size = static_cast<std::size_t>(info.st_size);
+    m_mapped = true;
+#else
+    if (!GLUtils::sReadTexture(path.c_str(), m_buffer))
+        return false;
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#endif
+
+    if (!validate(path))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief unmaps the file or frees the buffer holding it
+ */
+void GLTextureContainer::close()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_mapped && m_data)
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_buffer.clear();
+    m_levels.clear();
+    m_header = s_Header();
+}
+
+/**
+ * @brief gets the header of the open container
+ * @return the header
+ */
+const GLTextureContainer::s_Header& GLTextureContainer::getHeader() const
+{
+    return m_header;
+}
+
+/**
+ * @param level the mip level, 0 is the full size image
+ * @brief gets the size and location of a mip level
+ * @return the level entry
+ */
+const GLTextureContainer::s_Level& GLTextureContainer::getLevel(std::uint32_t level) const
+{
+    return m_levels[level];
+}
+
+/**
+ * @param level the mip level, 0 is the full size image
+ * @brief gets the data of a mip level straight from the mapping
+ * @return pointer to getLevel(level).size bytes
+ */
+const unsigned char* GLTextureContainer::getLevelData(std::uint32_t level) const
+{
+    return m_data + m_levels[level].offset;
+}
+
+/**
+ * @brief gets the amount of bytes all levels take, which is what the texture takes in video memory
+ * @return the summed size of all levels
+ */
+std::size_t GLTextureContainer::getDataSize() const
+{
+    std::size_t size = 0;
+    for (const s_Level& level : m_levels)
+        size += static_cast<std::size_t>(level.size);
+    return size;
+}
+
+/**
+ * @param pixels the decoded image, rows bottom to top like gl expects
+ * @param width the width of the image
+ * @param height the height of the image
+ * @param channels the amount of channels per pixel, 1 to 4
+ * @param compress true to store the levels as BC1 (DXT1), false for RGBA8
+ * @param out the buffer that will hold the whole container file
+ * @brief expands the image to RGBA, builds the full mip chain with a box filter and writes the container
+ * @return true if the container is written to out, false if the image is empty
+ */
+bool GLTextureContainer::sBake(const unsigned char* pixels, int width, int height, int channels, bool compress, std::vector<unsigned char>& out)
+{
+    if (!pixels || 0 >= width || 0 >= height || 1 > channels || 4 < channels)
+    {
+        std::cerr << "GLTextureContainer: nothing to bake" << std::endl;
+        return false;
+    }
+
+    std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+    std::vector<unsigned char> rgba(pixelCount * 4);
+    for (std::size_t i = 0; i < pixelCount; ++i)
+    {
+        const unsigned char* src = pixels + i * channels;
+        unsigned char* dst = rgba.data() + i * 4;
+        if (3 <= channels)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+        else
+        {
+            dst[0] = src[0];
+            dst[1] = src[0];
+            dst[2] = src[0];
+        }
+        dst[3] = (4 == channels) ? src[3] : (2 == channels) ? src[1] : 255;
+    }
+
+    std::vector<std::vector<unsigned char>> levelData;
+    std::vector<s_Level> levels;
+    std::uint32_t levelWidth = static_cast<std::uint32_t>(width);
+    std::uint32_t levelHeight = static_cast<std::uint32_t>(height);
+    while (true)
+    {
+        levelData.push_back(compress ? sCompressBC1(rgba, levelWidth, levelHeight) : rgba);
+        levels.push_back({levelWidth, levelHeight, 0, levelData.back().size()});
+        if (1 == levelWidth && 1 == levelHeight)
+            break;
+
+        rgba = sDownsample(rgba, levelWidth, levelHeight);
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+
+    s_Header header = {};
+    std::memcpy(header.magic, "STEX", 4);
+    header.version = 1;
+    header.internalFormat = compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
+    header.format = compress ? 0 : GL_RGBA;
+    header.width = static_cast<std::uint32_t>(width);
+    header.height = static_cast<std::uint32_t>(height);
+    header.levelCount = static_cast<std::uint32_t>(levels.size());
+    header.compressed = compress ? 1 : 0;
+
+    // level data starts 16 byte aligned so the mapping can be handed to gl as is
+    std::size_t offset = sizeof(s_Header) + levels.size() * sizeof(s_Level);
+    for (s_Level& level : levels)
+    {
+        offset = (offset + 15) & ~static_cast<std::size_t>(15);
+        level.offset = offset;
+        offset += static_cast<std::size_t>(level.size);
+    }
+
+    out.assign(offset, 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), levels.data(), levels.size() * sizeof(s_Level));
+    for (std::size_t i = 0; i < levels.size(); ++i)
+        std::memcpy(out.data() + levels[i].offset, levelData[i].data(), levelData[i].size());
+    return true;
+}
+
+/**
+ * @param path the path of the file, for error messages
+ * @brief checks the header, that the format is one sBake writes and that every level has the size of its mip and lies inside the file.
+ * The level entries go straight to glTexSubImage2D so a level that disagrees with its dimensions would make gl read past it
+ * @return true if the container can be uploaded, false on error with message printed
+ */
+bool GLTextureContainer::validate(const std::string& path)
+{
+    if (m_size < sizeof(s_Header))
+    {
+        std::cerr << "GLTextureContainer: " << path << " is too small" << std::endl;
+        return false;
+    }
+
+    std::memcpy(&m_header, m_data, sizeof(s_Header));
+    if (0 != std::memcmp(m_header.magic, "STEX", 4) || 1 != m_header.version)
+    {
+        std::cerr << "GLTextureContainer: " << path << " is not a version 1 .stex file" << std::endl;
+        return false;
+    }
+
+    bool rgba8 = GL_RGBA8 == m_header.internalFormat && GL_RGBA == m_header.format && 0 == m_header.compressed;
+    bool bc1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT == m_header.internalFormat && 0 == m_header.format && 1 == m_header.compressed;
+    if (!rgba8 && !bc1)
+    {
+        std::cerr << "GLTextureContainer: " << path << " has an unsupported format" << std::endl;
+        return false;
+    }
+
+    // the full chain of a 2^16 image is 17 levels, bigger textures are beyond any gl limit anyway
+    std::uint32_t maxSide = std::max(m_header.width, m_header.height);
+    if (0 == m_header.width || 0 == m_header.height || 65536 < maxSide)
+    {
+        std::cerr << "GLTextureContainer: " << path << " has a broken size" << std::endl;
+        return false;
+    }
+
+    std::uint32_t fullChain = 1;
+    while (maxSide >> fullChain)
+        ++fullChain;
+    if (0 == m_header.levelCount || fullChain < m_header.levelCount || m_size < sizeof(s_Header) + m_header.levelCount * sizeof(s_Level))
+    {
+        std::cerr << "GLTextureContainer: " << path << " has a broken level table" << std::endl;
+        return false;
+    }
+
+    m_levels.resize(m_header.levelCount);
+    std::memcpy(m_levels.data(), m_data + sizeof(s_Header), m_levels.size() * sizeof(s_Level));
+    for (std::uint32_t i = 0; i < m_header.levelCount; ++i)
+    {
+        const s_Level& level = m_levels[i];
+        if (std::max(1u, m_header.width >> i) != level.width || std::max(1u, m_header.height >> i) != level.height
+            || sLevelSize(m_header, level.width, level.height) != level.size)
+        {
+            std::cerr << "GLTextureContainer: " << path << " has a level that doesn't match its size" << std::endl;
+            return false;
+        }
+        if (level.offset > m_size || level.size > m_size - level.offset)
+        {
+            std::cerr << "GLTextureContainer: " << path << " is truncated" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @param header the header giving the format
+ * @param width the width of the level
+ * @param height the height of the level
+ * @brief computes the bytes a level takes, 4 per pixel for RGBA8 and 8 per 4x4 block for BC1
+ * @return the size of the level data
+ */
+std::uint64_t GLTextureContainer::sLevelSize(const s_Header& header, std::uint32_t width, std::uint32_t height)
+{
+    if (header.compressed)
+        return static_cast<std::uint64_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+    return static_cast<std::uint64_t>(width) * height * 4;
+}
+
+/**
+ * @param rgba the RGBA8 pixels of the level
+ * @param width the width of the level
+ * @param height the height of the level
+ * @brief halves the level with a 2x2 box filter, odd edges reuse the last row or column
+ * @return the RGBA8 pixels of the next level
+ */
+std::vector<unsigned char> GLTextureContainer::sDownsample(const std::vector<unsigned char>& rgba, std::uint32_t width, std::uint32_t height)
+{
+    std::uint32_t nextWidth = std::max(1u, width / 2);
+    std::uint32_t nextHeight = std::max(1u, height / 2);
+    std::vector<unsigned char> next(static_cast<std::size_t>(nextWidth) * nextHeight * 4);
+
+    for (std::uint32_t y = 0; y < nextHeight; ++y)
+    {
+        std::uint32_t y0 = std::min(y * 2, height - 1);
+        std::uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (std::uint32_t x = 0; x < nextWidth; ++x)
+        {
+            std::uint32_t x0 = std::min(x * 2, width - 1);
+            std::uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                unsigned int sum = rgba[(static_cast<std::size_t>(y0) * width + x0) * 4 + c]
+                    + rgba[(static_cast<std::size_t>(y0) * width + x1) * 4 + c]
+                    + rgba[(static_cast<std::size_t>(y1) * width + x0) * 4 + c]
+                    + rgba[(static_cast<std::size_t>(y1) * width + x1) * 4 + c];
+                next[(static_cast<std::size_t>(y) * nextWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return next;
+}
+
+/**
+ * @param rgba the RGBA8 pixels of the level
+ * @param width the width of the level
+ * @param height the height of the level
+ * @brief encodes the level as BC1 blocks, the endpoints are the corners of the color bounding box of each 4x4 block
+ * and every pixel picks the closest of the 4 palette colors. Alpha is dropped
+ * @return the compressed level, 8 bytes per 4x4 block
+ */
+std::vector<unsigned char> GLTextureContainer::sCompressBC1(const std::vector<unsigned char>& rgba, std::uint32_t width, std::uint32_t height)
+{
+    auto pack565 = [](const unsigned char* c) -> std::uint16_t
+    {
+        return static_cast<std::uint16_t>(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+    };
+    auto unpack565 = [](std::uint16_t v, int* out)
+    {
+        int r = (v >> 11) & 31;
+        int g = (v >> 5) & 63;
+        int b = v & 31;
+        out[0] = (r << 3) | (r >> 2);
+        out[1] = (g << 2) | (g >> 4);
+        out[2] = (b << 3) | (b >> 2);
+    };
+
+    std::uint32_t blocksX = (width + 3) / 4;
+    std::uint32_t blocksY = (height + 3) / 4;
+    std::vector<unsigned char> out(static_cast<std::size_t>(blocksX) * blocksY * 8);
+    unsigned char* dst = out.data();
+
+    for (std::uint32_t by = 0; by < blocksY; ++by)
+    {
+        for (std::uint32_t bx = 0; bx < blocksX; ++bx)
+        {
+            const unsigned char* block[16];
+            unsigned char minColor[3] = {255, 255, 255};
+            unsigned char maxColor[3] = {0, 0, 0};
+            for (int i = 0; i < 16; ++i)
+            {
+                std::uint32_t x = std::min(bx * 4 + (i & 3), width - 1);
+                std::uint32_t y = std::min(by * 4 + (i >> 2), height - 1);
+                block[i] = rgba.data() + (static_cast<std::size_t>(y) * width + x) * 4;
+                for (int c = 0; c < 3; ++c)
+                {
+                    minColor[c] = std::min(minColor[c], block[i][c]);
+                    maxColor[c] = std::max(maxColor[c], block[i][c]);
+                }
+            }
+
+            // max >= min on every channel so color0 >= color1, equal endpoints fall back to index 0 everywhere
+            std::uint16_t color0 = pack565(maxColor);
+            std::uint16_t color1 = pack565(minColor);
+            std::uint32_t indices = 0;
+            if (color0 != color1)
+            {
+                int palette[4][3];
+                unpack565(color0, palette[0]);
+                unpack565(color1, palette[1]);
+                for (int c = 0; c < 3; ++c)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+
+                for (int i = 0; i < 16; ++i)
+                {
+                    int best = 0;
+                    int bestDistance = 0x7fffffff;
+                    for (int p = 0; p < 4; ++p)
+                    {
+                        int dr = block[i][0] - palette[p][0];
+                        int dg = block[i][1] - palette[p][1];
+                        int db = block[i][2] - palette[p][2];
+                        int distance = dr * dr + dg * dg + db * db;
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            best = p;
+                        }
+                    }
+                    indices |= static_cast<std::uint32_t>(best) << (i * 2);
+                }
+            }
+
+            dst[0] = static_cast<unsigned char>(color0 & 0xff);
+            dst[1] = static_cast<unsigned char>(color0 >> 8);
+            dst[2] = static_cast<unsigned char>(color1 & 0xff);
+            dst[3] = static_cast<unsigned char>(color1 >> 8);
+            for (int i = 0; i < 4; ++i)
+                dst[4 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+            dst += 8;
+        }
+    }
+    return out;
+}
\ No newline at end of file
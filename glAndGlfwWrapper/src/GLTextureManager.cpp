@@ -0,0 +1,582 @@
+#include "GLTextureManager.hpp"
+#include "GLTextureContainer.hpp"
+#include "GLUtils.hpp"
+#include "GLState.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+// border around every packed texture, filled with its edge texels so filtering doesn't bleed in the neighbours.
+// Mip level k only keeps sPadding >> k texels of it, so the array stops at the level with one texel left, the most a bilinear tap reaches past the edge
+static const GLsizei sPadding = 4;
+static const GLsizei sMaxLevel = 2;
+
+/**
+ * @param size the width or height of a texture
+ * @brief adds the padding on both sides and rounds up to whole texels of the last mip, so every packed texture starts and ends on a texel edge
+ * on every level and no mip texel mixes two textures
+ * @return the size the texture takes in a layer
+ */
+static GLsizei sPaddedSize(GLsizei size)
+{
+    const GLsizei alignment = 1 << sMaxLevel;
+    return (size + 2 * sPadding + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @param image the image to pad, 1 to 4 channels
+ * @param padding the border to leave on the top and left
+ * @param width the width of the padded region
+ * @param height the height of the padded region
+ * @param dst will hold width * height RGBA texels
+ * @brief expands the image to RGBA with its edge texels repeated into the border and up to the padded size
+ */
+static void sPad(const GLTexture::s_Image& image, GLsizei padding, GLsizei width, GLsizei height, unsigned char* dst)
+{
+    for (GLsizei row = 0; row < height; ++row)
+    {
+        int srcY = std::clamp(row - padding, 0, image.height - 1);
+        for (GLsizei col = 0; col < width; ++col, dst += 4)
+        {
+            int srcX = std::clamp(col - padding, 0, image.width - 1);
+            const unsigned char* src = image.pixels.data() + (static_cast<std::size_t>(srcY) * image.width + srcX) * image.channels;
+            if (3 <= image.channels)
+                std::memcpy(dst, src, 3);
+            else
+                std::memset(dst, src[0], 3);
+            dst[3] = (4 == image.channels) ? src[3] : (2 == image.channels) ? src[1] : 255;
+        }
+    }
+}
+
+/**
+ * @param src the RGBA texels of the level
+ * @param width the width of the level, even
+ * @param height the height of the level, even
+ * @param dst will hold the next level
+ * @brief halves a padded level with a 2x2 box filter, padded sizes are aligned so no edge case is left
+ */
+static void sHalve(const unsigned char* src, GLsizei width, GLsizei height, unsigned char* dst)
+{
+    std::size_t stride = static_cast<std::size_t>(width) * 4;
+    for (GLsizei y = 0; y < height / 2; ++y)
+    {
+        const unsigned char* top = src + y * 2 * stride;
+        const unsigned char* bottom = top + stride;
+        for (GLsizei x = 0; x < width / 2; ++x, top += 8, bottom += 8, dst += 4)
+        {
+            for (int c = 0; c < 4; ++c)
+                dst[c] = static_cast<unsigned char>((top[c] + top[c + 4] + bottom[c] + bottom[c + 4] + 2) / 4);
+        }
+    }
+}
+
+/**
+ * @brief sets the manager to empty, call setup to create the texture array
+ */
+GLTextureManager::GLTextureManager():
+m_textureId(0),
+m_layerSize(0),
+m_levels(0),
+m_budget(0),
+m_residentBytes(0),
+m_frame(0),
+m_unpackBuffer(GLBuffer::e_Type::PixelUnpack)
+{}
+
+/**
+ * @brief deletes the texture array, pending decodes are waited on by their futures
+ */
+GLTextureManager::~GLTextureManager()
+{
+    freeTexture();
+}
+
+/**
+ * @param layerSize the width and height of every layer of the array
+ * @param layerCount the amount of layers, together with layerSize the video memory the array takes
+ * @param budget the maximum amount of bytes the resident textures may take, 0 uses the whole array
+ * @brief allocates the texture array with immutable RGBA8 storage and the mips the padding covers, and packs a white placeholder
+ * that is handed out for textures that aren't resident yet
+ * @return true if the array is created, false on error with message printed
+ */
+bool GLTextureManager::setup(GLsizei layerSize, GLsizei layerCount, std::size_t budget)
+{
+    if (0 >= layerSize || 0 >= layerCount)
+    {
+        std::cerr << "GLTextureManager: layer size and count must be greater then 0" << std::endl;
+        return false;
+    }
+
+    freeTexture();
+    m_layerSize = layerSize;
+    m_levels = 1;
+    for (GLsizei size = layerSize; 1 < size && sMaxLevel >= m_levels; size /= 2)
+        ++m_levels;
+
+    glGenTextures(1, &m_textureId);
+    if (0 == m_textureId)
+    {
+        std::cerr << "GLTextureManager: failed to generate texture" << std::endl;
+        return false;
+    }
+
+    GLState::sBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+    if (GLAD_GL_ARB_texture_storage)
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_levels, GL_RGBA8, layerSize, layerSize, layerCount);
+    else
+    {
+        GLsizei size = layerSize;
+        for (GLsizei level = 0; level < m_levels; ++level, size = std::max(1, size / 2))
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+    GLState::sBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::size_t capacity = static_cast<std::size_t>(layerSize) * layerSize * 4 * layerCount;
+    m_budget = (0 == budget) ? capacity : std::min(budget, capacity);
+    m_layers.assign(static_cast<std::size_t>(layerCount), s_Layer());
+
+    GLTexture::s_Image white;
+    white.width = 4;
+    white.height = 4;
+    white.channels = 4;
+    white.pixels.assign(4 * 4 * 4, 255);
+    if (0 != place(*sPrepare({white}, m_levels)))
+    {
+        std::cerr << "GLTextureManager: failed to place placeholder" << std::endl;
+        return false;
+    }
+    m_slots[0].lastUsed = std::numeric_limits<std::uint64_t>::max();
+    return true;
+}
+
+/**
+ * @param path the path to an image or an uncompressed .stex container
+ * @brief registers the texture and starts decoding it on a worker, loading the same path twice gives the same id
+ * and images with the same pixels end up sharing one place in the array
+ * @return the id to get the region with, -1 if the manager isn't set up
+ */
+int GLTextureManager::load(const std::string& path)
+{
+    if (0 == m_textureId)
+    {
+        std::cerr << "GLTextureManager: load called before setup" << std::endl;
+        return -1;
+    }
+
+    std::string key = std::filesystem::absolute(path).lexically_normal().string();
+    std::unordered_map<std::string, int>::iterator found = m_paths.find(key);
+    if (found != m_paths.end())
+        return found->second;
+
+    int id = static_cast<int>(m_entries.size());
+    m_entries.emplace_back();
+    m_entries.back().path = path;
+    m_paths.emplace(key, id);
+    startDecode(m_entries.back());
+    return id;
+}
+
+/**
+ * @brief starts a new frame for the lru bookkeeping and packs the textures whose decode finished, call once per frame on the gl thread.
+ * The workers already padded every level, so packing a texture only copies it into the unpack buffer
+ */
+void GLTextureManager::update()
+{
+    ++m_frame;
+
+    for (s_Entry& entry : m_entries)
+    {
+        if (!entry.decode.valid() || std::future_status::ready != entry.decode.wait_for(std::chrono::seconds(0)))
+            continue;
+
+        std::unique_ptr<s_Decoded> decoded = entry.decode.get();
+        if (!decoded)
+        {
+            entry.failed = true;
+            continue;
+        }
+
+        std::unordered_map<std::uint64_t, int>::iterator found = m_hashes.find(decoded->hash);
+        if (found != m_hashes.end())
+        {
+            entry.slot = found->second;
+            continue;
+        }
+
+        entry.slot = place(*decoded);
+        if (0 > entry.slot)
+        {
+            std::cerr << "GLTextureManager: no room for " << entry.path << std::endl;
+            entry.failed = true;
+            continue;
+        }
+        m_hashes.emplace(decoded->hash, entry.slot);
+    }
+}
+
+/**
+ * @param id the id returned by load
+ * @param rect will hold the uv offset in xy and the uv scale in zw of the texture inside its layer
+ * @param layer will hold the layer of the array
+ * @brief gets where the texture is packed and marks it as used this frame. A texture that was evicted is decoded again,
+ * until it is resident the placeholder region is given
+ * @return true if the region is the texture, false if it is the placeholder
+ */
+bool GLTextureManager::getRegion(int id, s_vec4& rect, float& layer)
+{
+    int slotIndex = 0;
+    if (0 <= id && static_cast<std::size_t>(id) < m_entries.size())
+    {
+        s_Entry& entry = m_entries[id];
+        if (0 <= entry.slot)
+            slotIndex = entry.slot;
+        else if (!entry.failed && !entry.decode.valid())
+            startDecode(entry);
+    }
+
+    s_Slot& slot = m_slots[slotIndex];
+    if (0 != slotIndex)
+        slot.lastUsed = m_frame;
+
+    float size = static_cast<float>(m_layerSize);
+    rect = {slot.x / size, slot.y / size, slot.width / size, slot.height / size};
+    layer = static_cast<float>(slot.layer);
+    return 0 != slotIndex;
+}
+
+/**
+ * @param id the id returned by load
+ * @brief checks if the texture is packed in the array
+ * @return true if the texture is resident, false while decoding, after eviction or when loading failed
+ */
+bool GLTextureManager::isResident(int id) const
+{
+    return 0 <= id && static_cast<std::size_t>(id) < m_entries.size() && 0 <= m_entries[id].slot;
+}
+
+/**
+ * @param slot the texture unit to bind to
+ * @brief binds the texture array, as every material lives in it this is the only texture bind draws need
+ */
+void GLTextureManager::bind(unsigned int slot) const
+{
+    GLState::sBindTextureUnit(slot, GL_TEXTURE_2D_ARRAY, m_textureId);
+}
+
+/**
+ * @brief gets the amount of bytes the resident textures take, padding and mips included
+ * @return the resident bytes
+ */
+std::size_t GLTextureManager::getResidentBytes() const
+{
+    return m_residentBytes;
+}
+
+/**
+ * @brief gets the video memory budget for resident textures
+ * @return the budget in bytes
+ */
+std::size_t GLTextureManager::getBudget() const
+{
+    return m_budget;
+}
+
+/**
+ * @param path the path to an image or an uncompressed .stex container
+ * @param levels will hold the base level, followed by the baked mips the array has when the texture is a .stex container
+ * @brief loads the pixels of a texture without touching gl so it can run on a worker
+ * @return true if the image is loaded, false on error with message printed
+ */
+bool GLTextureManager::sLoadImage(const std::string& path, std::vector<GLTexture::s_Image>& levels)
+{
+    levels.clear();
+    if (".stex" != std::filesystem::path(path).extension())
+    {
+        levels.resize(1);
+        return GLTexture::sDecode(path, levels[0]);
+    }
+
+    GLTextureContainer container;
+    if (!container.open(path))
+        return false;
+    const GLTextureContainer::s_Header& header = container.getHeader();
+    if (header.compressed)
+    {
+        std::cerr << "GLTextureManager: " << path << " is compressed, texture arrays are RGBA8" << std::endl;
+        return false;
+    }
+
+    // upload reads width * height * 4 bytes, a level claiming other dimensions than its size would read past the copy
+    const GLTextureContainer::s_Level& level = container.getLevel(0);
+    if (header.width != level.width || header.height != level.height || static_cast<std::uint64_t>(level.width) * level.height * 4 != level.size)
+    {
+        std::cerr << "GLTextureManager: " << path << " has a base level that doesn't match its size" << std::endl;
+        return false;
+    }
+
+    // open checked every other level against its size the same way
+    levels.resize(std::min<std::size_t>(header.levelCount, sMaxLevel + 1));
+    for (std::uint32_t i = 0; i < levels.size(); ++i)
+    {
+        const GLTextureContainer::s_Level& mip = container.getLevel(i);
+        levels[i].width = static_cast<int>(mip.width);
+        levels[i].height = static_cast<int>(mip.height);
+        levels[i].channels = 4;
+        levels[i].pixels.assign(container.getLevelData(i), container.getLevelData(i) + mip.size);
+    }
+    return true;
+}
+
+/**
+ * @param entry the entry to decode
+ * @brief starts loading and padding the levels of the entry on a worker
+ */
+void GLTextureManager::startDecode(s_Entry& entry)
+{
+    std::string path = entry.path;
+    GLsizei levelCount = m_levels;
+    entry.decode = std::async(std::launch::async, [path, levelCount]()
+    {
+        std::vector<GLTexture::s_Image> levels;
+        if (!sLoadImage(path, levels))
+            return std::unique_ptr<s_Decoded>();
+        return sPrepare(levels, levelCount);
+    });
+}
+
+/**
+ * @param levels the base level and the baked mips, if any
+ * @param levelCount the amount of levels the array has
+ * @brief pads every level of the array and hashes the result. A baked mip is used when it holds exactly half the texels of the level above,
+ * other levels are filtered from the padded level above so they line up with the padding
+ * @return the padded levels ready to copy into the array
+ */
+std::unique_ptr<GLTextureManager::s_Decoded> GLTextureManager::sPrepare(const std::vector<GLTexture::s_Image>& levels, GLsizei levelCount)
+{
+    const GLTexture::s_Image& image = levels[0];
+    std::unique_ptr<s_Decoded> decoded = std::make_unique<s_Decoded>();
+    decoded->width = image.width;
+    decoded->height = image.height;
+
+    GLsizei paddedWidth = sPaddedSize(image.width);
+    GLsizei paddedHeight = sPaddedSize(image.height);
+    std::size_t size = 0;
+    for (GLsizei level = 0; level < levelCount; ++level)
+        size += static_cast<std::size_t>(paddedWidth >> level) * (paddedHeight >> level) * 4;
+    decoded->levels.resize(size);
+
+    unsigned char* dst = decoded->levels.data();
+    const unsigned char* above = nullptr;
+    for (GLsizei level = 0; level < levelCount; ++level)
+    {
+        GLsizei width = paddedWidth >> level;
+        GLsizei height = paddedHeight >> level;
+        bool baked = static_cast<std::size_t>(level) < levels.size() && 0 == image.width % (1 << level) && 0 == image.height % (1 << level)
+            && levels[level].width == image.width >> level && levels[level].height == image.height >> level;
+        if (baked)
+            sPad(levels[level], sPadding >> level, width, height, dst);
+        else
+            sHalve(above, width * 2, height * 2, dst);
+        above = dst;
+        dst += static_cast<std::size_t>(width) * height * 4;
+    }
+
+    decoded->hash = GLUtils::sHash(&decoded->width, sizeof(decoded->width));
+    decoded->hash = GLUtils::sHash(&decoded->height, sizeof(decoded->height), decoded->hash);
+    decoded->hash = GLUtils::sHash(decoded->levels.data(), decoded->levels.size(), decoded->hash);
+    return decoded;
+}
+
+/**
+ * @param decoded the padded levels
+ * @brief finds room for the texture, evicting the least recently used textures when the budget or the array is full, and uploads it
+ * @return the slot index, -1 if the texture is too big or nothing can be evicted
+ */
+int GLTextureManager::place(const s_Decoded& decoded)
+{
+    GLsizei paddedWidth = sPaddedSize(decoded.width);
+    GLsizei paddedHeight = sPaddedSize(decoded.height);
+    if (paddedWidth > m_layerSize || paddedHeight > m_layerSize)
+    {
+        std::cerr << "GLTextureManager: " << decoded.width << "x" << decoded.height << " doesn't fit a layer of " << m_layerSize << std::endl;
+        return -1;
+    }
+
+    std::size_t bytes = decoded.levels.size();
+    GLint layer = 0;
+    GLsizei x = 0;
+    GLsizei y = 0;
+    while (m_residentBytes + bytes > m_budget || !allocate(paddedWidth, paddedHeight, layer, x, y))
+    {
+        if (!evictLeastRecentlyUsed())
+            return -1;
+    }
+
+    int index = 0;
+    while (static_cast<std::size_t>(index) < m_slots.size() && m_slots[index].used)
+        ++index;
+    if (static_cast<std::size_t>(index) == m_slots.size())
+        m_slots.emplace_back();
+
+    s_Slot& slot = m_slots[index];
+    slot = {decoded.hash, layer, x + sPadding, y + sPadding, decoded.width, decoded.height, bytes, m_frame, true};
+    m_residentBytes += bytes;
+    ++m_layers[layer].slots;
+
+    upload(decoded, layer, x, y);
+    return index;
+}
+
+/**
+ * @param width the padded width to allocate
+ * @param height the padded height to allocate
+ * @param layer will hold the layer
+ * @param x will hold the x position in the layer
+ * @param y will hold the y position in the layer
+ * @brief shelf packs the rectangle in the first layer with room, a layer's space is reused once all its textures are evicted
+ * @return true if a place is found, false if every layer is full
+ */
+bool GLTextureManager::allocate(GLsizei width, GLsizei height, GLint& layer, GLsizei& x, GLsizei& y)
+{
+    for (std::size_t i = 0; i < m_layers.size(); ++i)
+    {
+        s_Layer& current = m_layers[i];
+        for (s_Shelf& shelf : current.shelves)
+        {
+            if (height <= shelf.height && shelf.x + width <= m_layerSize)
+            {
+                layer = static_cast<GLint>(i);
+                x = shelf.x;
+                y = shelf.y;
+                shelf.x += width;
+                return true;
+            }
+        }
+
+        if (current.top + height <= m_layerSize)
+        {
+            current.shelves.push_back({current.top, height, width});
+            layer = static_cast<GLint>(i);
+            x = 0;
+            y = current.top;
+            current.top += height;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief evicts the texture that was used the longest ago, textures used this frame and the placeholder are kept
+ * @return true if a texture was evicted, false if there is nothing left to evict
+ */
+bool GLTextureManager::evictLeastRecentlyUsed()
+{
+    int oldest = -1;
+    for (std::size_t i = 0; i < m_slots.size(); ++i)
+    {
+        const s_Slot& slot = m_slots[i];
+        if (!slot.used || slot.lastUsed >= m_frame)
+            continue;
+        if (0 > oldest || slot.lastUsed < m_slots[oldest].lastUsed)
+            oldest = static_cast<int>(i);
+    }
+
+    if (0 > oldest)
+        return false;
+    evict(oldest);
+    return true;
+}
+
+/**
+ * @param slot the slot to evict
+ * @brief frees the slot, the entries using it become non resident and are decoded again when asked for
+ */
+void GLTextureManager::evict(int slot)
+{
+    s_Slot& evicted = m_slots[slot];
+    for (s_Entry& entry : m_entries)
+    {
+        if (slot == entry.slot)
+            entry.slot = -1;
+    }
+    m_hashes.erase(evicted.hash);
+    m_residentBytes -= evicted.bytes;
+    evicted.used = false;
+
+    s_Layer& layer = m_layers[evicted.layer];
+    if (0 == --layer.slots)
+    {
+        layer.shelves.clear();
+        layer.top = 0;
+    }
+}
+
+/**
+ * @param decoded the padded levels
+ * @param layer the layer to write to
+ * @param x the x of the padded rectangle
+ * @param y the y of the padded rectangle
+ * @brief copies the levels into the orphaned pixel unpack buffer and writes each into its rectangle of the array, only the texels
+ * of this texture change on every level. Without the buffer the levels are written straight from memory
+ */
+void GLTextureManager::upload(const s_Decoded& decoded, GLint layer, GLsizei x, GLsizei y)
+{
+    GLsizeiptr size = static_cast<GLsizeiptr>(decoded.levels.size());
+    void* mapped = nullptr;
+    if (0 != m_unpackBuffer.getId() || m_unpackBuffer.setup())
+    {
+        m_unpackBuffer.bind();
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped)
+        {
+            std::memcpy(mapped, decoded.levels.data(), decoded.levels.size());
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+            m_unpackBuffer.unbind();
+    }
+
+    GLsizei paddedWidth = sPaddedSize(decoded.width);
+    GLsizei paddedHeight = sPaddedSize(decoded.height);
+    std::size_t offset = 0;
+    GLState::sBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+    for (GLsizei level = 0; level < m_levels; ++level)
+    {
+        GLsizei width = paddedWidth >> level;
+        GLsizei height = paddedHeight >> level;
+        // with a pixel unpack buffer bound the data pointer is an offset into it
+        const void* data = mapped ? reinterpret_cast<const void*>(offset) : decoded.levels.data() + offset;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        offset += static_cast<std::size_t>(width) * height * 4;
+    }
+    GLState::sBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    if (mapped)
+        m_unpackBuffer.unbind();
+}
+
+/**
+ * @brief deletes the texture array and forgets every texture
+ */
+void GLTextureManager::freeTexture()
+{
+    if (0 != m_textureId)
+    {
+        GLState::sForgetTexture(m_textureId);
+        glDeleteTextures(1, &m_textureId);
+        m_textureId = 0;
+    }
+    m_layers.clear();
+    m_slots.clear();
+    m_entries.clear();
+    m_paths.clear();
+    m_hashes.clear();
+    m_residentBytes = 0;
+}
\ No newline at end of file
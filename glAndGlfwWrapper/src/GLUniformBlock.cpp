@@ -0,0 +1,55 @@
+#include "GLUniformBlock.hpp"
+#include <iostream>
+
+/**
+ * @param bindingPoint the uniform buffer binding point the block will use
+ * @brief sets the binding point, the ring is triple buffered so a frame never waits on the previous one
+ */
+GLUniformBlock::GLUniformBlock(GLuint bindingPoint):
+m_stream(GLBuffer::e_Type::Uniform, 3),
+m_bindingPoint(bindingPoint)
+{}
+
+/**
+ * @param size the size in bytes of the block
+ * @brief creates the ring buffer that backs the block
+ * @return true if the buffer is created, false on error with message printed
+ */
+bool GLUniformBlock::setup(GLsizeiptr size)
+{
+    if (!m_stream.setup(size))
+    {
+        std::cerr << "GLUniformBlock: failed to setup uniform buffer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param shader the shader program that declares the block
+ * @param blockName the name of the uniform block in the shader
+ * @brief connects the block in the shader program to the binding point of this object
+ * @return true if the block is found and bound, false if the program has no block with that name
+ */
+bool GLUniformBlock::attach(const GLShader& shader, const std::string& blockName) const
+{
+    return shader.setUniformBlockBinding(blockName, m_bindingPoint);
+}
+
+/**
+ * @brief fences the region used this frame and moves on to the next one
+ * @attention call this after the last draw that reads the block
+ */
+void GLUniformBlock::finishFrame()
+{
+    m_stream.finishRegion();
+}
+
+/**
+ * @brief gives the binding point of the block
+ * @return the uniform buffer binding point
+ */
+GLuint GLUniformBlock::getBindingPoint() const
+{
+    return m_bindingPoint;
+}
\ No newline at end of file
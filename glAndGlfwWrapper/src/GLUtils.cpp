@@ -3,6 +3,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstdio>
 
 /**
  * @param path the string of the path to the shader file
@@ -75,4 +76,62 @@ bool GLUtils::sReadTexture(const char* path, std::vector<unsigned char>& buffer)
 
     file.close();
     return true;
+}
+
+/**
+ * @param path the path of the file to write
+ * @param buffer the data that will be written to the file
+ * @brief writes the buffer to a temporary file and renames it over path, so readers never see a half written file
+ * @return true if the file is written, else false and an error message is printed
+ */
+bool GLUtils::sWriteFile(const char* path, const std::vector<unsigned char>& buffer)
+{
+    if (!path)
+    {
+        std::cerr << "path is empty" << std::endl;
+        return false;
+    }
+
+    std::string tmpPath = std::string(path) + ".tmp";
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "failed to open file for writing: " << tmpPath << std::endl;
+        return false;
+    }
+
+    if (!file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+    {
+        file.close();
+        std::cerr << "writing file failed: " << tmpPath << std::endl;
+        return false;
+    }
+    file.close();
+
+    if (0 != std::rename(tmpPath.c_str(), path))
+    {
+        std::remove(tmpPath.c_str());
+        std::cerr << "failed to move file into place: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param data pointer to the bytes to hash
+ * @param size the amount of bytes
+ * @param seed the start value, pass a previous result to hash multiple pieces of data together
+ * @brief hashes the bytes with 64 bit FNV-1a
+ * @return the hash of the data
+ */
+std::uint64_t GLUtils::sHash(const void* data, std::size_t size, std::uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t hash = seed;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
 }
\ No newline at end of file
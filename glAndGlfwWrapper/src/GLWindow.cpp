@@ -1,3 +1,4 @@
+#include "GLState.hpp"
 #include "GLWindow.hpp"
 #include <stdexcept>
 #include <iostream>
@@ -209,6 +210,24 @@ GLFWcursorposfun GLWindow::setCursorCallback(GLFWcursorposfun callback)
     return glfwSetCursorPosCallback(m_window, callback);
 }
 
+/**
+ * @param callback the new callback function that handles mouse button presses and releases
+ * @return the previous set callback function, null if not set before or the library was not initialized
+ */
+GLFWmousebuttonfun GLWindow::setMouseButtonCallback(GLFWmousebuttonfun callback)
+{
+    return glfwSetMouseButtonCallback(m_window, callback);
+}
+
+/**
+ * @param x gets the cursor x position in screen coordinates relative to the left edge of the content area
+ * @param y gets the cursor y position in screen coordinates relative to the top edge of the content area
+ */
+void GLWindow::getCursorPos(double& x, double& y) const
+{
+    glfwGetCursorPos(m_window, &x, &y);
+}
+
 /**
  * @param red the anound of red in rgba value you want
  * @param green the amound of green in rgba value you want
@@ -233,6 +252,7 @@ void GLWindow::setClearColor(float red, float green, float blue, float alpha)
  */
 void GLWindow::clear(bool color, bool depth) const
 {
+    GLState::sCount();
     if (color && depth)
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     else if (color)
@@ -250,15 +270,15 @@ void GLWindow::enable(bool lequal, bool depth)
 {
     if (lequal && depth)
     {
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        GLState::sEnable(GL_DEPTH_TEST);
+        GLState::sDepthFunc(GL_LEQUAL);
     }
     else if (depth)
-        glEnable(GL_DEPTH_TEST);
+        GLState::sEnable(GL_DEPTH_TEST);
     else if (lequal)
-        glDepthFunc(GL_LEQUAL);
+        GLState::sDepthFunc(GL_LEQUAL);
 
-    glFrontFace(GL_CCW);;
+    GLState::sFrontFace(GL_CCW);
 }
 
 /**
@@ -0,0 +1,44 @@
+#ifndef BOUNDS_HPP
+# define BOUNDS_HPP
+
+# include <cstddef>
+# include "Bvh.hpp"
+# include "GLShader.hpp"
+# include "JobSystem.hpp"
+
+struct s_Sphere
+{
+    s_vec3 center;
+    float radius;
+};
+
+/**
+ * bounds of point sets and of transformed boxes and spheres. Point boxes read four points as three 4 wide loads and
+ * large sets are split over threads, boxes go through a matrix with Arvo's center and extent method, and spheres are
+ * either Ritter's or EPOS, which solves the exact sphere of a few extremal points and grows it over the rest.
+ * Without a job system everything runs on the calling thread
+ */
+class Bounds
+{
+    public:
+        static bool sPoints(const s_vec3* points, std::size_t count, s_Aabb& box, JobSystem* jobs = nullptr);
+
+        // the matrices are affine, the last row is not applied
+        static s_Aabb sTransform(const s_mat4& mat, const s_Aabb& box);
+        static void sTransform(const s_mat4& mat, const s_Aabb* boxes, std::size_t count, s_Aabb* out, JobSystem* jobs = nullptr);
+        static void sTransform(const s_mat4* mats, std::size_t count, const s_Aabb& box, s_Aabb* out, JobSystem* jobs = nullptr);
+        static s_Sphere sTransform(const s_mat4& mat, const s_Sphere& sphere);
+
+        static bool sRitterSphere(const s_vec3* points, std::size_t count, s_Sphere& sphere);
+        static bool sEposSphere(const s_vec3* points, std::size_t count, s_Sphere& sphere, unsigned int normalCount = 7, JobSystem* jobs = nullptr);
+    private:
+        static const std::size_t sPointGrain = 1 << 16;
+        static const std::size_t sBoxGrain = 1 << 12;
+
+        static s_Aabb sPointsRange(const s_vec3* points, std::size_t count);
+        static s_Sphere sMinSphere(s_vec3* points, std::size_t count, s_vec3* support, unsigned int supportCount);
+        static s_Sphere sSupportSphere(const s_vec3* support, unsigned int supportCount);
+        static void sGrow(s_Sphere& sphere, const s_vec3* points, std::size_t count);
+};
+
+#endif
\ No newline at end of file
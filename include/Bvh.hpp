@@ -0,0 +1,49 @@
+#ifndef BVH_HPP
+# define BVH_HPP
+
+# include <cstddef>
+# include <vector>
+# include "GLShader.hpp"
+
+struct s_Aabb
+{
+    s_vec3 min;
+    s_vec3 max;
+};
+
+/**
+ * bounding volume hierarchy over axis aligned boxes, built top down with binned SAH and stored as one flat node array.
+ * Siblings are next to each other, so an inner node only needs the index of its left child
+ */
+class Bvh
+{
+    public:
+        struct s_Node
+        {
+            s_vec3 min;
+            unsigned int leftFirst; // left child for inner nodes, first entry in the index list for leaves
+            s_vec3 max;
+            unsigned int count; // 0 for inner nodes, primitive count for leaves
+        };
+
+        Bvh() = default;
+        ~Bvh() = default;
+
+        void build(const std::vector<s_Aabb>& bounds, unsigned int maxLeafSize = 1);
+        void clear();
+
+        const std::vector<s_Node>& getNodes() const;
+        const std::vector<unsigned int>& getIndices() const;
+        bool empty() const;
+    private:
+        std::vector<s_Node> m_nodes;
+        std::vector<unsigned int> m_indices; // primitive ids, every leaf owns a contiguous run of them
+
+        void fitNode(s_Node& node, const std::vector<s_Aabb>& bounds) const;
+        bool findSplit(const s_Node& node, const std::vector<s_vec3>& centroids, const std::vector<s_Aabb>& bounds, int& axis, float& position) const;
+        static float sArea(const s_vec3& min, const s_vec3& max);
+};
+
+static_assert(32 == sizeof(Bvh::s_Node), "bvh nodes are meant to fill half a cache line");
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef DEPTHPREPASS_HPP
+# define DEPTHPREPASS_HPP
+
+# include <cstddef>
+# include "Struct.hpp"
+# include "GLQuery.hpp"
+
+/**
+ * decides per frame if the scene is drawn with a depth only pre-pass followed by a GL_EQUAL shading pass. Fragment
+ * work of every pass is counted with queries that are read frames later, in auto mode the other mode is probed now and
+ * then so the overdraw of the plain mode can be compared against the one fragment per pixel of the pre-pass mode
+ */
+class DepthPrepass
+{
+    public:
+        enum class e_Pass
+        {
+            Depth,
+            Shade
+        };
+
+        struct s_ModeStats
+        {
+            unsigned int frames = 0; // frames measured in the mode
+            double depthFragments = 0.0; // running averages per frame
+            double shadeFragments = 0.0;
+            double gpuMs = 0.0;
+        };
+
+        DepthPrepass();
+        DepthPrepass(const DepthPrepass& other) = delete;
+        ~DepthPrepass() = default;
+
+        DepthPrepass& operator=(const DepthPrepass& other) = delete;
+
+        bool setup();
+        bool beginFrame(e_PrepassMode mode);
+        void begin(e_Pass pass);
+        void end();
+        void endFrame();
+
+        bool isAutoEnabled() const;
+        float getOverdraw() const;
+        const s_ModeStats& getStats(bool prepass) const;
+        bool countsInvocations() const;
+    private:
+        static const unsigned int sFramesInFlight = 4;
+        static const unsigned int sSlotsPerFrame = 4;
+        static const unsigned long sProbeInterval = 120;
+
+        struct s_Frame
+        {
+            bool prepass = false;
+            unsigned int slots = 0;
+            e_Pass passes[sSlotsPerFrame] = {};
+            unsigned int remaining = 0; // queries of the frame that weren't read yet
+            double depthFragments = 0.0;
+            double shadeFragments = 0.0;
+            double gpuMs = 0.0;
+        };
+
+        GLQuery m_fragments;
+        GLQuery m_times;
+        s_Frame m_frames[sFramesInFlight];
+        unsigned long m_frame;
+        bool m_measuring;
+        bool m_autoPrepass;
+        s_ModeStats m_stats[2];
+        float m_overdraw;
+
+        void collect();
+        void record(const s_Frame& frame);
+};
+
+#endif
\ No newline at end of file
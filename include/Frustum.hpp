@@ -0,0 +1,35 @@
+#ifndef FRUSTUM_HPP
+# define FRUSTUM_HPP
+
+# include <cstddef>
+# include <vector>
+# include "Bounds.hpp"
+# include "Bvh.hpp"
+
+/**
+ * the six clip planes of a view projection matrix, stored as structure of arrays so four planes are tested against a
+ * box at once. Planes are taken from the full mvp, so boxes are tested in the space the mvp takes as input
+ */
+class Frustum
+{
+    public:
+        enum class e_Result
+        {
+            Outside,
+            Intersect,
+            Inside
+        };
+
+        void setup(const s_mat4& mvp);
+        e_Result test(const s_vec3& min, const s_vec3& max) const;
+        e_Result test(const s_Sphere& sphere) const;
+        void cull(const Bvh& bvh, std::vector<unsigned int>& visible) const;
+    private:
+        // 6 planes padded to 8 with planes that contain everything, so the tests run in two full batches
+        alignas(16) float m_x[8];
+        alignas(16) float m_y[8];
+        alignas(16) float m_z[8];
+        alignas(16) float m_w[8];
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef JOBSYSTEM_HPP
+# define JOBSYSTEM_HPP
+
+# include <atomic>
+# include <condition_variable>
+# include <cstddef>
+# include <deque>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+/**
+ * a fixed pool of worker threads with one deque each: a worker pushes and pops its own tasks at the back and steals
+ * from the front of the others once it runs dry. A task can depend on other tasks, it is queued when the last of them
+ * finished and it is skipped when one of them threw. Threads outside the pool share one extra deque, while they wait
+ * they only run the tasks they added themselves, so the render thread never picks up a stage of a background load.
+ * A system of 1 thread has no workers and every task runs inside the wait of the thread that added it
+ */
+class JobSystem
+{
+    public:
+        struct s_Task;
+        typedef std::shared_ptr<s_Task> t_Task;
+        typedef std::function<void(std::size_t begin, std::size_t end)> t_RangeWork;
+
+        JobSystem(unsigned int threads = 0);
+        JobSystem(const JobSystem& other) = delete;
+        ~JobSystem();
+
+        JobSystem& operator=(const JobSystem& other) = delete;
+
+        t_Task add(std::function<void()> work, const std::vector<t_Task>& dependencies = {});
+        void wait(const t_Task& task);
+        void wait(const std::vector<t_Task>& tasks);
+        void parallelFor(std::size_t count, std::size_t grain, const t_RangeWork& work);
+        unsigned int getThreadCount() const;
+
+        static void sParallelFor(JobSystem* jobs, std::size_t count, std::size_t grain, const t_RangeWork& work);
+    private:
+        struct s_Queue
+        {
+            std::mutex mutex;
+            std::deque<t_Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<s_Queue>> m_queues; // the first one is shared by the threads outside the pool
+        std::vector<std::thread> m_workers;
+        std::atomic<std::ptrdiff_t> m_queued;
+        std::atomic<unsigned long> m_scheduled; // counts every schedule, a thread outside the pool sleeps until it moves
+        std::atomic<unsigned int> m_waiting;
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        bool m_stop;
+
+        void workerLoop(std::size_t queue);
+        std::size_t currentQueue() const;
+        void schedule(const t_Task& task);
+        void release(const t_Task& task);
+        bool runOne(std::size_t queue);
+        bool runOwn();
+        void run(const t_Task& task);
+};
+
+#endif
\ No newline at end of file
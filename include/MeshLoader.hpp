@@ -0,0 +1,56 @@
+#ifndef MESHLOADER_HPP
+# define MESHLOADER_HPP
+
+# include <string>
+# include <vector>
+# include "JobSystem.hpp"
+# include "Struct.hpp"
+
+/**
+ * loads an .obj into everything the renderer uploads, as a task graph on a job system: after the file is read the
+ * bounds run next to the chunking, and once the triangles are ordered the texture coordinates, normals and chunk
+ * bvh of both vertex layouts are built side by side. The stages that loop over many items split them with parallelFor
+ */
+class MeshLoader
+{
+    public:
+        // wall time of every stage in milliseconds, stages overlap so they add up to more than the total
+        struct s_Times
+        {
+            double read = 0.0;
+            double bounds = 0.0;
+            double chunks = 0.0;
+            double order = 0.0;
+            double layout = 0.0;
+            double chunkBvh = 0.0;
+            double texCoords = 0.0;
+            double normals = 0.0;
+            double interleave = 0.0;
+            double texCoordsPerFace = 0.0;
+            double normalsPerFace = 0.0;
+            double interleavePerFace = 0.0;
+            double total = 0.0;
+        };
+
+        // the triangle order of an earlier load, kept while the file has the same faces so moving vertices leaves the indices alone
+        struct s_Order
+        {
+            std::vector<unsigned int> fileFaces;
+            std::vector<s_ObjectRange> objects;
+            std::vector<unsigned int> faces;
+            std::vector<s_Chunk> chunks;
+        };
+
+        static s_MeshData sLoad(const std::string& path, JobSystem& jobs, s_Times* times = nullptr, const s_Order* previous = nullptr);
+        static void sPrintTimes(const s_Times& times, unsigned int threads);
+    private:
+        static const std::size_t sVertexGrain = 1 << 14;
+
+        static bool sSameFaces(const s_Order& previous, const s_InputFileLines& info);
+        static void sUpdateChunkBounds(s_InputFileLines& info);
+
+        static void sInterleave(const std::vector<s_vec3>& positions, const std::vector<s_vec2>& texCoords, const std::vector<s_vec3>& normals,
+            std::vector<s_Vertex>& out, JobSystem& jobs);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef OCCLUSIONCULLER_HPP
+# define OCCLUSIONCULLER_HPP
+
+# include <cstddef>
+# include <vector>
+# include "Struct.hpp"
+# include "GLBuffer.hpp"
+# include "GLMesh.hpp"
+# include "GLQuery.hpp"
+# include "GLShaderVariants.hpp"
+
+/**
+ * hardware occlusion culling of the mesh chunks. Chunks that were visible in the last results are drawn first, then
+ * the bounding box of every chunk in the frustum is tested against that depth with an occlusion query. Chunks that were
+ * occluded are drawn under conditional rendering on their fresh query, so the gpu decides and the cpu never waits
+ */
+class OcclusionCuller
+{
+    public:
+        OcclusionCuller();
+        OcclusionCuller(const OcclusionCuller& other) = delete;
+        ~OcclusionCuller() = default;
+
+        OcclusionCuller& operator=(const OcclusionCuller& other) = delete;
+
+        bool setup(GLuint frameBlockBinding);
+        bool setChunks(const std::vector<s_Chunk>& chunks);
+        void reset();
+        bool collect();
+        void split(const std::vector<unsigned int>& inFrustum, std::vector<unsigned int>& visible, std::vector<unsigned int>& occluded) const;
+        unsigned int test(const s_mat4& mvp, const std::vector<unsigned int>& inFrustum);
+        void drawOccluded(const GLMesh& mesh, const std::vector<s_Chunk>& chunks, const std::vector<unsigned int>& occluded) const;
+    private:
+        GLShaderVariants m_shaders;
+        GLQuery m_queries;
+        GLBuffer m_vbo;
+        GLBuffer m_ebo;
+        GLMesh m_boxes;
+        std::vector<s_Aabb> m_bounds;
+        std::vector<unsigned char> m_occluded; // the last result read for each chunk
+        bool m_tested; // the queries of m_testedMvp were issued and none of them was dropped
+        s_mat4 m_testedMvp;
+
+        static bool sCrossesNearPlane(const s_mat4& mvp, const s_Aabb& box);
+};
+
+#endif
\ No newline at end of file
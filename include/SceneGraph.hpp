@@ -0,0 +1,47 @@
+#ifndef SCENEGRAPH_HPP
+# define SCENEGRAPH_HPP
+
+# include <cstddef>
+# include <cstdint>
+# include <vector>
+# include "GLShader.hpp"
+
+/**
+ * flat scene graph, every node property lives in its own array indexed by the node id. A parent is always created
+ * before its children so the arrays are in topological order and one forward pass updates the whole graph
+ */
+class SceneGraph
+{
+    public:
+        static const int sNoParent = -1;
+
+        SceneGraph() = default;
+        ~SceneGraph() = default;
+
+        int createNode(int parent = sNoParent);
+        void reserve(std::size_t count);
+        void clear();
+
+        void setTranslation(int node, const s_vec3& translation);
+        void setRotation(int node, const s_quat& rotation);
+        void setScale(int node, float scale);
+
+        std::size_t update();
+
+        const s_mat4& getWorld(int node) const;
+        int getParent(int node) const;
+        std::size_t size() const;
+    private:
+        std::vector<s_vec3> m_translations;
+        std::vector<s_quat> m_rotations;
+        std::vector<float> m_scales;
+        std::vector<int> m_parents;
+        std::vector<s_mat4> m_worlds;
+        std::vector<std::uint8_t> m_dirty;
+        std::size_t m_firstDirty = 0; // nothing before it needs to be visited by update
+
+        void markDirty(int node);
+        s_mat4 localMatrix(int node) const;
+};
+
+#endif
\ No newline at end of file
@@ -4,33 +4,105 @@
 # include "Struct.hpp"
 # include "GLContext.hpp"
 # include "GLWindow.hpp"
-# include "GLShader.hpp"
-# include "GLTexture.hpp"
+# include "GLShaderVariants.hpp"
+# include "GLTextureManager.hpp"
+# include "GLSampler.hpp"
 # include "GLTimer.hpp"
+# include "GLUniformBlock.hpp"
+# include "GLFileWatcher.hpp"
+# include "GLMultiDraw.hpp"
+# include "SceneGraph.hpp"
+# include "Bvh.hpp"
+# include "Frustum.hpp"
+# include "OcclusionCuller.hpp"
+# include "DepthPrepass.hpp"
+# include "TriangleBvh.hpp"
+# include "JobSystem.hpp"
+# include <chrono>
+# include <future>
+# include <memory>
+# include <string>
 
 class Scop
 {
     public:
-        Scop(char* objectFilePath);
+        Scop(char* objectFilePath, unsigned int instanceCount = 1, unsigned int threadCount = 0);
         ~Scop() = default;
         void start();
+
+        static bool smUploadChangedRanges(GLBuffer& buffer, const std::vector<s_Vertex>& current, const std::vector<s_Vertex>& next, std::size_t& rangeCount);
     private:
+        JobSystem m_jobs; // first, so the workers outlive everything that could still queue work
         GLContext m_context;
         GLWindow m_window;
-        GLShader m_shader;
-        GLTexture m_texture;
+        GLShaderVariants m_shaders;
+        GLTextureManager m_textures;
+        int m_material = -1;
+        GLSampler m_sampler;
         GLTimer m_timer;
+        GLUniformBlock m_frameBlock;
+        GLFileWatcher m_watcher;
+        std::future<std::unique_ptr<s_ShaderSources>> m_shaderReload;
+        bool m_shaderReloadQueued = false;
+        std::string m_objectPath;
+        std::future<std::unique_ptr<s_MeshData>> m_meshReload;
+        bool m_meshReloadQueued = false;
+        std::chrono::steady_clock::time_point m_meshReloadStart;
         s_Buffers m_buffers;
+        GLMultiDraw m_multiDraw;
         s_InputFileLines m_info;
+        std::vector<unsigned int> m_fileFaces;
+        std::vector<s_Vertex> m_vertices;
+        std::vector<s_Vertex> m_verticesPerFace;
         s_BoundingBox m_bbox;
+        s_Sphere m_sphere;
         s_DisplayInfo m_displayInfo;
+        unsigned int m_instanceCount;
+        std::vector<s_Instance> m_instances;
+        std::vector<s_mat4> m_instanceMatrices;
+        std::vector<s_Aabb> m_instanceBounds;
+        std::vector<unsigned int> m_visibleInstances;
+        SceneGraph m_scene;
+        int m_pivotNode = SceneGraph::sNoParent;
+        int m_modelNode = SceneGraph::sNoParent;
+        s_ViewCache m_viewCache;
+        Bvh m_chunkBvh;
+        Frustum m_frustum;
+        std::vector<unsigned int> m_visibleChunks;
+        OcclusionCuller m_occlusion;
+        std::vector<unsigned int> m_drawnChunks;
+        std::vector<unsigned int> m_occludedChunks;
+        DepthPrepass m_depthPrepass;
+        s_CullStats m_cullStats;
+        std::future<std::unique_ptr<TriangleBvh>> m_pickBuild;
+        bool m_pickBuildQueued = false;
+        std::unique_ptr<TriangleBvh> m_pickBvh;
 
-        std::vector<s_Vertex> setupShaderBufferData();
-        std::vector<s_Vertex> setupShaderBufferDataPerFace();
         bool setupBuffersGlobal(const std::vector<s_Vertex>& vertices, const std::vector<s_VertexAttribute>& attributes);
         bool setupBuffersPerFace(const std::vector<s_Vertex>& veritces, const std::vector<s_VertexAttribute>& attributes);
+        bool setupInstances();
+        bool uploadInstances();
+        bool setupDrawCommands();
+        void updateVisibleCommands();
+        void updateVisibleInstances();
+        void drawVisibleChunks(const GLMesh& mesh) const;
+        void startPickBuild();
+        void updatePicking();
+        std::vector<s_Instance> setupInstanceData() const;
+        unsigned int instanceGridSide() const;
+        float instanceSpacing() const;
+        void setupSceneNodes();
+        void placeSceneNodes();
         s_mat4 setupModelViewProjection(float fovRadian, float near, float far, float distance, const s_vec3& up);
+        s_FrameUniforms setupFrameUniforms();
+        std::uint32_t selectShaderVariant(bool depthOnly = false) const;
+        void watchShaderFiles();
+        void updateShaderReload(const std::vector<std::string>& changedFiles);
+        void updateModelReload(const std::vector<std::string>& changedFiles);
+        bool rebuildMeshBuffers(const s_MeshData& mesh);
         static void smKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+        static void smCursorCallback(GLFWwindow* window, double x, double y);
+        static void smMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 };
 
@@ -0,0 +1,255 @@
+#ifndef SIMD_HPP
+# define SIMD_HPP
+
+# if defined(SCOP_NO_SIMD)
+#  define SIMD_SCALAR
+# elif defined(__SSE2__) || defined(_M_X64)
+#  include <xmmintrin.h>
+#  define SIMD_SSE
+# elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define SIMD_NEON
+# else
+#  define SIMD_SCALAR
+# endif
+
+// the wrappers must disappear even when a file is built without optimizations
+# if defined(_MSC_VER)
+#  define SIMD_INLINE __forceinline
+# else
+#  define SIMD_INLINE inline __attribute__((always_inline))
+# endif
+
+/**
+ * 4 wide float operations on SSE, NEON or plain floats, the math kernels of Utils, the plane tests of Frustum and the
+ * box tests of TriangleBvh are written once against these.
+ * Building with SCOP_NO_SIMD defined forces the plain float version
+ */
+class Simd
+{
+    public:
+# if defined(SIMD_SSE)
+        typedef __m128 t_Float4;
+# elif defined(SIMD_NEON)
+        typedef float32x4_t t_Float4;
+# else
+        struct t_Float4 { float v[4]; };
+# endif
+
+        static const char* sBackend();
+
+        // sLoad and sStore need 16 byte aligned pointers, the unaligned versions take any float pointer
+        static t_Float4 sLoad(const float* p);
+        static t_Float4 sLoadUnaligned(const float* p);
+        static void sStore(float* p, t_Float4 a);
+        static void sStoreUnaligned(float* p, t_Float4 a);
+        static t_Float4 sSet(float x, float y, float z, float w);
+        static t_Float4 sSplat(float x);
+
+        static t_Float4 sAdd(t_Float4 a, t_Float4 b);
+        static t_Float4 sSub(t_Float4 a, t_Float4 b);
+        static t_Float4 sMul(t_Float4 a, t_Float4 b);
+        static t_Float4 sDiv(t_Float4 a, t_Float4 b);
+        static t_Float4 sMulAdd(t_Float4 a, t_Float4 b, t_Float4 c); // a * b + c
+        static t_Float4 sSqrt(t_Float4 a);
+        static t_Float4 sMin(t_Float4 a, t_Float4 b);
+        static t_Float4 sMax(t_Float4 a, t_Float4 b);
+        static t_Float4 sAbs(t_Float4 a);
+
+        template <int Lane>
+        static t_Float4 sBroadcast(t_Float4 a);
+        static t_Float4 sSwapPairs(t_Float4 a); // (y, x, w, z)
+        static t_Float4 sSwapHalves(t_Float4 a); // (z, w, x, y)
+        static t_Float4 sReverse(t_Float4 a); // (w, z, y, x)
+        static t_Float4 sDot(t_Float4 a, t_Float4 b); // the dot product in every lane
+        static float sFirst(t_Float4 a);
+        static int sLessMask(t_Float4 a, t_Float4 b); // bit i is set when lane i of a is below lane i of b
+        static int sLessEqualMask(t_Float4 a, t_Float4 b);
+        static void sTranspose(t_Float4& r0, t_Float4& r1, t_Float4& r2, t_Float4& r3); // rows become columns
+# if defined(SIMD_NEON)
+    private:
+        static int sMask(uint32x4_t compare);
+# endif
+};
+
+SIMD_INLINE const char* Simd::sBackend()
+{
+# if defined(SIMD_SSE)
+    return "sse";
+# elif defined(SIMD_NEON)
+    return "neon";
+# else
+    return "scalar";
+# endif
+}
+
+# if defined(SIMD_SSE)
+
+SIMD_INLINE Simd::t_Float4 Simd::sLoad(const float* p) { return _mm_load_ps(p); }
+SIMD_INLINE Simd::t_Float4 Simd::sLoadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+SIMD_INLINE void Simd::sStore(float* p, t_Float4 a) { _mm_store_ps(p, a); }
+SIMD_INLINE void Simd::sStoreUnaligned(float* p, t_Float4 a) { _mm_storeu_ps(p, a); }
+SIMD_INLINE Simd::t_Float4 Simd::sSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+SIMD_INLINE Simd::t_Float4 Simd::sSplat(float x) { return _mm_set1_ps(x); }
+
+SIMD_INLINE Simd::t_Float4 Simd::sAdd(t_Float4 a, t_Float4 b) { return _mm_add_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sSub(t_Float4 a, t_Float4 b) { return _mm_sub_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sMul(t_Float4 a, t_Float4 b) { return _mm_mul_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sDiv(t_Float4 a, t_Float4 b) { return _mm_div_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sMulAdd(t_Float4 a, t_Float4 b, t_Float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+SIMD_INLINE Simd::t_Float4 Simd::sSqrt(t_Float4 a) { return _mm_sqrt_ps(a); }
+SIMD_INLINE Simd::t_Float4 Simd::sMin(t_Float4 a, t_Float4 b) { return _mm_min_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sMax(t_Float4 a, t_Float4 b) { return _mm_max_ps(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sAbs(t_Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+
+template <int Lane>
+SIMD_INLINE Simd::t_Float4 Simd::sBroadcast(t_Float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(Lane, Lane, Lane, Lane)); }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapPairs(t_Float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapHalves(t_Float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)); }
+SIMD_INLINE Simd::t_Float4 Simd::sReverse(t_Float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+SIMD_INLINE Simd::t_Float4 Simd::sDot(t_Float4 a, t_Float4 b)
+{
+    __m128 product = _mm_mul_ps(a, b);
+    __m128 sum = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+SIMD_INLINE float Simd::sFirst(t_Float4 a) { return _mm_cvtss_f32(a); }
+SIMD_INLINE int Simd::sLessMask(t_Float4 a, t_Float4 b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+SIMD_INLINE int Simd::sLessEqualMask(t_Float4 a, t_Float4 b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+SIMD_INLINE void Simd::sTranspose(t_Float4& r0, t_Float4& r1, t_Float4& r2, t_Float4& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+
+# elif defined(SIMD_NEON)
+
+SIMD_INLINE Simd::t_Float4 Simd::sLoad(const float* p) { return vld1q_f32(p); }
+SIMD_INLINE Simd::t_Float4 Simd::sLoadUnaligned(const float* p) { return vld1q_f32(p); }
+SIMD_INLINE void Simd::sStore(float* p, t_Float4 a) { vst1q_f32(p, a); }
+SIMD_INLINE void Simd::sStoreUnaligned(float* p, t_Float4 a) { vst1q_f32(p, a); }
+SIMD_INLINE Simd::t_Float4 Simd::sSet(float x, float y, float z, float w)
+{
+    const float lanes[4] = {x, y, z, w};
+    return vld1q_f32(lanes);
+}
+SIMD_INLINE Simd::t_Float4 Simd::sSplat(float x) { return vdupq_n_f32(x); }
+
+SIMD_INLINE Simd::t_Float4 Simd::sAdd(t_Float4 a, t_Float4 b) { return vaddq_f32(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sSub(t_Float4 a, t_Float4 b) { return vsubq_f32(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sMul(t_Float4 a, t_Float4 b) { return vmulq_f32(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sDiv(t_Float4 a, t_Float4 b)
+{
+#  if defined(__aarch64__)
+    return vdivq_f32(a, b);
+#  else
+    // armv7 has no vector divide, two newton steps on the estimate get close to full precision
+    float32x4_t inverse = vrecpeq_f32(b);
+    inverse = vmulq_f32(vrecpsq_f32(b, inverse), inverse);
+    inverse = vmulq_f32(vrecpsq_f32(b, inverse), inverse);
+    return vmulq_f32(a, inverse);
+#  endif
+}
+SIMD_INLINE Simd::t_Float4 Simd::sMulAdd(t_Float4 a, t_Float4 b, t_Float4 c) { return vmlaq_f32(c, a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sSqrt(t_Float4 a)
+{
+#  if defined(__aarch64__)
+    return vsqrtq_f32(a);
+#  else
+    alignas(16) float lanes[4];
+    vst1q_f32(lanes, a);
+    for (int i = 0; i < 4; ++i)
+        lanes[i] = __builtin_sqrtf(lanes[i]);
+    return vld1q_f32(lanes);
+#  endif
+}
+SIMD_INLINE Simd::t_Float4 Simd::sMin(t_Float4 a, t_Float4 b) { return vminq_f32(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sMax(t_Float4 a, t_Float4 b) { return vmaxq_f32(a, b); }
+SIMD_INLINE Simd::t_Float4 Simd::sAbs(t_Float4 a) { return vabsq_f32(a); }
+
+template <int Lane>
+SIMD_INLINE Simd::t_Float4 Simd::sBroadcast(t_Float4 a) { return vdupq_n_f32(vgetq_lane_f32(a, Lane)); }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapPairs(t_Float4 a) { return vrev64q_f32(a); }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapHalves(t_Float4 a) { return vextq_f32(a, a, 2); }
+SIMD_INLINE Simd::t_Float4 Simd::sReverse(t_Float4 a) { return vrev64q_f32(vextq_f32(a, a, 2)); }
+
+SIMD_INLINE Simd::t_Float4 Simd::sDot(t_Float4 a, t_Float4 b)
+{
+    float32x4_t product = vmulq_f32(a, b);
+    float32x2_t sum = vadd_f32(vget_low_f32(product), vget_high_f32(product));
+    return vdupq_lane_f32(vpadd_f32(sum, sum), 0);
+}
+SIMD_INLINE float Simd::sFirst(t_Float4 a) { return vgetq_lane_f32(a, 0); }
+
+// neon has no movemask, every lane keeps its own bit of the all ones compare result and the four are added up
+SIMD_INLINE int Simd::sMask(uint32x4_t compare)
+{
+    const uint32_t weights[4] = {1, 2, 4, 8};
+    uint32x4_t bits = vandq_u32(compare, vld1q_u32(weights));
+    uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return static_cast<int>(vget_lane_u32(vpadd_u32(sum, sum), 0));
+}
+SIMD_INLINE int Simd::sLessMask(t_Float4 a, t_Float4 b) { return sMask(vcltq_f32(a, b)); }
+SIMD_INLINE int Simd::sLessEqualMask(t_Float4 a, t_Float4 b) { return sMask(vcleq_f32(a, b)); }
+SIMD_INLINE void Simd::sTranspose(t_Float4& r0, t_Float4& r1, t_Float4& r2, t_Float4& r3)
+{
+    float32x4x2_t low = vtrnq_f32(r0, r1);
+    float32x4x2_t high = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(low.val[0]), vget_low_f32(high.val[0]));
+    r1 = vcombine_f32(vget_low_f32(low.val[1]), vget_low_f32(high.val[1]));
+    r2 = vcombine_f32(vget_high_f32(low.val[0]), vget_high_f32(high.val[0]));
+    r3 = vcombine_f32(vget_high_f32(low.val[1]), vget_high_f32(high.val[1]));
+}
+
+# else
+
+SIMD_INLINE Simd::t_Float4 Simd::sLoad(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sLoadUnaligned(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+SIMD_INLINE void Simd::sStore(float* p, t_Float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+SIMD_INLINE void Simd::sStoreUnaligned(float* p, t_Float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+SIMD_INLINE Simd::t_Float4 Simd::sSet(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sSplat(float x) { return {{x, x, x, x}}; }
+
+SIMD_INLINE Simd::t_Float4 Simd::sAdd(t_Float4 a, t_Float4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sSub(t_Float4 a, t_Float4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sMul(t_Float4 a, t_Float4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sDiv(t_Float4 a, t_Float4 b) { return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sMulAdd(t_Float4 a, t_Float4 b, t_Float4 c) { return sAdd(sMul(a, b), c); }
+SIMD_INLINE Simd::t_Float4 Simd::sSqrt(t_Float4 a) { return {{__builtin_sqrtf(a.v[0]), __builtin_sqrtf(a.v[1]), __builtin_sqrtf(a.v[2]), __builtin_sqrtf(a.v[3])}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sMin(t_Float4 a, t_Float4 b)
+{
+    return {{b.v[0] < a.v[0] ? b.v[0] : a.v[0], b.v[1] < a.v[1] ? b.v[1] : a.v[1], b.v[2] < a.v[2] ? b.v[2] : a.v[2], b.v[3] < a.v[3] ? b.v[3] : a.v[3]}};
+}
+SIMD_INLINE Simd::t_Float4 Simd::sMax(t_Float4 a, t_Float4 b)
+{
+    return {{a.v[0] < b.v[0] ? b.v[0] : a.v[0], a.v[1] < b.v[1] ? b.v[1] : a.v[1], a.v[2] < b.v[2] ? b.v[2] : a.v[2], a.v[3] < b.v[3] ? b.v[3] : a.v[3]}};
+}
+SIMD_INLINE Simd::t_Float4 Simd::sAbs(t_Float4 a) { return {{__builtin_fabsf(a.v[0]), __builtin_fabsf(a.v[1]), __builtin_fabsf(a.v[2]), __builtin_fabsf(a.v[3])}}; }
+
+template <int Lane>
+SIMD_INLINE Simd::t_Float4 Simd::sBroadcast(t_Float4 a) { return sSplat(a.v[Lane]); }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapPairs(t_Float4 a) { return {{a.v[1], a.v[0], a.v[3], a.v[2]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sSwapHalves(t_Float4 a) { return {{a.v[2], a.v[3], a.v[0], a.v[1]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sReverse(t_Float4 a) { return {{a.v[3], a.v[2], a.v[1], a.v[0]}}; }
+SIMD_INLINE Simd::t_Float4 Simd::sDot(t_Float4 a, t_Float4 b) { return sSplat(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]); }
+SIMD_INLINE float Simd::sFirst(t_Float4 a) { return a.v[0]; }
+SIMD_INLINE int Simd::sLessMask(t_Float4 a, t_Float4 b)
+{
+    return (a.v[0] < b.v[0] ? 1 : 0) | (a.v[1] < b.v[1] ? 2 : 0) | (a.v[2] < b.v[2] ? 4 : 0) | (a.v[3] < b.v[3] ? 8 : 0);
+}
+SIMD_INLINE int Simd::sLessEqualMask(t_Float4 a, t_Float4 b)
+{
+    return (a.v[0] <= b.v[0] ? 1 : 0) | (a.v[1] <= b.v[1] ? 2 : 0) | (a.v[2] <= b.v[2] ? 4 : 0) | (a.v[3] <= b.v[3] ? 8 : 0);
+}
+SIMD_INLINE void Simd::sTranspose(t_Float4& r0, t_Float4& r1, t_Float4& r2, t_Float4& r3)
+{
+    t_Float4 c0 = {{r0.v[0], r1.v[0], r2.v[0], r3.v[0]}};
+    t_Float4 c1 = {{r0.v[1], r1.v[1], r2.v[1], r3.v[1]}};
+    t_Float4 c2 = {{r0.v[2], r1.v[2], r2.v[2], r3.v[2]}};
+    t_Float4 c3 = {{r0.v[3], r1.v[3], r2.v[3], r3.v[3]}};
+    r0 = c0;
+    r1 = c1;
+    r2 = c2;
+    r3 = c3;
+}
+
+# endif
+
+#endif
\ No newline at end of file
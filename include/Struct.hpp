@@ -1,9 +1,16 @@
 #ifndef STRUCT_HPP
 # define STRUCT_HPP
 
+# include <cstddef>
+# include <cstdint>
+# include <string>
+# include <vector>
 # include "GLShader.hpp"
 # include "GLBuffer.hpp"
 # include "GLMesh.hpp"
+# include "Bounds.hpp"
+# include "Bvh.hpp"
+# include "GLMultiDraw.hpp"
 
 struct s_Transform
 {
@@ -11,12 +18,38 @@ struct s_Transform
 	s_quat orientation;
 	s_mat4 model;
 	s_mat4 mvp;
+	s_mat4 viewProj;
 	float zoomFactor = 1.f;
 	const float zoomStep = 0.1f;
 	const float minZoom = 0.2f;
 	const float maxZoom = 5.f;
 };
 
+/**
+ * inputs the view projection matrix was last built from, it is only rebuilt when one of them changes
+ */
+struct s_ViewCache
+{
+	int width = 0;
+	int height = 0;
+	float zoom = 0.f;
+};
+
+/**
+ * result of the last frustum culling pass, the same mvp gives the same commands so culling is skipped until it changes
+ */
+struct s_CullStats
+{
+	bool valid = false;
+	s_mat4 mvp;
+	unsigned int visibleChunks = 0;
+	unsigned int visibleObjects = 0;
+	bool occlusion = false;
+	unsigned int occludedChunks = 0;
+	unsigned int visibleInstances = 0;
+	std::vector<GLMultiDraw::s_Command> commands;
+};
+
 struct s_BoundingBox
 {
 	s_vec3 min;
@@ -26,19 +59,76 @@ struct s_BoundingBox
 	float scale;
 };
 
+/**
+ * bits of the shader variant mask, the order matches the define names given to GLShaderVariants::setup
+ */
+enum class e_ShaderFeature : std::uint32_t
+{
+	None = 0,
+	Textured = 1u << 0,
+	Blend = 1u << 1,
+	Instanced = 1u << 2,
+	DepthOnly = 1u << 3
+};
+
+enum class e_PrepassMode
+{
+	Auto, // on while the measured overdraw is high
+	On,
+	Off
+};
+
 struct s_renderSettings
 {
 	bool useTexture = false;
 	float blendValue = 0.f;
 	bool perFace = false;
+	bool occlusion = true;
+	e_PrepassMode prepass = e_PrepassMode::Auto;
+};
+
+/**
+ * cursor state written by the mouse callbacks, a click is answered by the render loop
+ */
+struct s_PickRequest
+{
+	double cursorX = 0.0;
+	double cursorY = 0.0;
+	bool requested = false;
 };
 
 struct s_DisplayInfo
 {
 	s_renderSettings render;
 	s_Transform transform;
+	s_PickRequest pick;
+};
+
+/**
+ * per frame state read by the FrameData uniform block, laid out as std140 with row_major matrices
+ */
+struct s_FrameUniforms
+{
+	s_mat4 mvp;
+	s_mat4 model;
+	s_vec4 normalMatrix[3]; // mat3 rows, each padded to a vec4
+	s_vec4 lightDir;
+	float blend;
+	float texLayer; // layer of the texture array holding the material
+	float padding[2];
+	s_vec4 texRect; // uv offset in xy and uv scale in zw of the material inside its layer
+	s_mat4 viewProj; // instances are placed in world space between model and view
 };
 
+static_assert(0 == offsetof(s_FrameUniforms, mvp), "std140 offset of uMVP");
+static_assert(64 == offsetof(s_FrameUniforms, model), "std140 offset of uModel");
+static_assert(128 == offsetof(s_FrameUniforms, normalMatrix), "std140 offset of uNormalMatrix");
+static_assert(176 == offsetof(s_FrameUniforms, lightDir), "std140 offset of uLightDir");
+static_assert(192 == offsetof(s_FrameUniforms, blend), "std140 offset of uBlend");
+static_assert(196 == offsetof(s_FrameUniforms, texLayer), "std140 offset of uTexLayer");
+static_assert(208 == offsetof(s_FrameUniforms, texRect), "std140 offset of uTexRect");
+static_assert(224 == offsetof(s_FrameUniforms, viewProj), "std140 offset of uViewProj");
+
 struct s_Vertex
 {
 	s_vec3 position;
@@ -46,12 +136,58 @@ struct s_Vertex
 	s_vec3 normal;
 };
 
+/**
+ * per instance attributes, the transform is stored as the first three rows of a row major affine matrix
+ */
+struct s_Instance
+{
+	s_vec4 rows[3];
+	s_vec4 color;
+};
+
+/**
+ * the triangles of one o or g group, facesPerFace keeps the order of faces so the range is valid for both
+ */
+struct s_ObjectRange
+{
+	std::string name;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+/**
+ * a spatially compact run of triangles inside one object, the unit the frustum culling works on
+ */
+struct s_Chunk
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	unsigned int object; // index into s_InputFileLines::objects
+	s_Aabb bounds;
+};
+
 struct  s_InputFileLines
 {
     std::vector<s_vec3> vertices;
     std::vector<s_vec3> verticesPerFace;
     std::vector<unsigned int> faces;
     std::vector<unsigned int> facesPerFace;
+    std::vector<s_ObjectRange> objects;
+    std::vector<s_Chunk> chunks;
+};
+
+/**
+ * everything the gpu buffers are built from, parsed off the GL thread when the object file is reloaded
+ */
+struct s_MeshData
+{
+	s_InputFileLines info;
+	std::vector<unsigned int> fileFaces; // info.faces as parsed, before the chunking and ordering moved them
+	s_BoundingBox bbox;
+	s_Sphere sphere; // in the space the mesh was loaded in, the instances are culled with it
+	std::vector<s_Vertex> vertices;
+	std::vector<s_Vertex> verticesPerFace;
+	Bvh chunkBvh; // over info.chunks
 };
 
 struct s_Buffers
@@ -62,8 +198,9 @@ struct s_Buffers
 	GLBuffer vboFace;
 	GLBuffer ebo;
 	GLBuffer eboFace;
+	GLBuffer instances;
 
-	s_Buffers(): vao(), vaoFace(), vbo(GLBuffer::e_Type::Array), vboFace(GLBuffer::e_Type::Array), ebo(GLBuffer::e_Type::Element), eboFace(GLBuffer::e_Type::Element) {}
+	s_Buffers(): vao(), vaoFace(), vbo(GLBuffer::e_Type::Array), vboFace(GLBuffer::e_Type::Array), ebo(GLBuffer::e_Type::Element), eboFace(GLBuffer::e_Type::Element), instances(GLBuffer::e_Type::Array) {}
 	~s_Buffers() = default;
 };
 
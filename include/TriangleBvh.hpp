@@ -0,0 +1,60 @@
+#ifndef TRIANGLEBVH_HPP
+# define TRIANGLEBVH_HPP
+
+# include <cstddef>
+# include <vector>
+# include "Bvh.hpp"
+
+/**
+ * 4 wide bvh over the triangles of a mesh for ray queries. It is built as a binary SAH tree through Bvh and then
+ * collapsed, so every node holds the boxes of up to four children that one ray is tested against at once
+ */
+class TriangleBvh
+{
+    public:
+        struct s_Hit
+        {
+            float t; // along the ray direction as given, not normalized
+            unsigned int triangle; // index of the triangle in the faces given to build
+            float u; // barycentric weight of the second vertex
+            float v; // barycentric weight of the third vertex
+        };
+
+        bool build(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& faces);
+        bool intersect(const s_vec3& origin, const s_vec3& direction, s_Hit& hit) const;
+
+        std::size_t getTriangleCount() const;
+        std::size_t getNodeCount() const;
+        bool empty() const;
+    private:
+        static const unsigned int sEmpty = 0xffffffffu;
+
+        // pre transformed for Moeller-Trumbore, the edges are what the test needs
+        struct s_Triangle
+        {
+            s_vec3 v0;
+            s_vec3 edge1;
+            s_vec3 edge2;
+            unsigned int id;
+        };
+
+        struct alignas(16) s_Node4
+        {
+            float minX[4];
+            float minY[4];
+            float minZ[4];
+            float maxX[4];
+            float maxY[4];
+            float maxZ[4];
+            unsigned int child[4]; // node index for inner children, first triangle for leaves, sEmpty for unused slots
+            unsigned int count[4]; // triangles in a leaf, 0 for inner children
+        };
+
+        std::vector<s_Node4> m_nodes;
+        std::vector<s_Triangle> m_triangles;
+
+        unsigned int collapse(const Bvh& bvh, unsigned int binaryNode);
+        static bool sIntersectTriangle(const s_Triangle& triangle, const s_vec3& origin, const s_vec3& direction, s_Hit& hit);
+};
+
+#endif
\ No newline at end of file
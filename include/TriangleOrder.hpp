@@ -0,0 +1,33 @@
+#ifndef TRIANGLEORDER_HPP
+# define TRIANGLEORDER_HPP
+
+# include <cstddef>
+# include <vector>
+# include "JobSystem.hpp"
+# include "Struct.hpp"
+
+/**
+ * reorders the triangles of a parsed mesh for the post transform vertex cache and for less overdraw, after Sander,
+ * Nehab and Barczak: Tipsify orders the triangles of every chunk, its output is cut into clusters where the cache
+ * stays warm enough, and clusters and chunks are sorted so the ones facing away from the center are drawn first.
+ * The sort never moves a triangle out of its chunk: culling submits chunks as whole index ranges, and sorting across the
+ * object would also break up the Tipsify runs. mathbench measures what a whole object sort would gain on overdraw
+ */
+class TriangleOrder
+{
+    public:
+        static void sOptimize(s_InputFileLines& info, unsigned int cacheSize = 16, float cacheThreshold = 0.75f, JobSystem* jobs = nullptr);
+        static float sCacheMissRatio(const unsigned int* indices, std::size_t indexCount, unsigned int cacheSize = 16);
+    private:
+        static const unsigned int sMinClusterTriangles = 8;
+        static const std::size_t sChunkGrain = 16;
+
+        static void sTipsify(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize,
+            std::vector<unsigned int>& order, std::vector<unsigned int>& boundaries);
+        static void sSplitClusters(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& order, unsigned int cacheSize,
+            float maxMissRatio, std::vector<unsigned int>& boundaries);
+        static float sOverdrawKey(const s_InputFileLines& info, const unsigned int* indices, std::size_t triangleCount, const s_vec3& center);
+        static s_vec3 sCenter(const s_InputFileLines& info, const unsigned int* indices, std::size_t triangleCount);
+};
+
+#endif
\ No newline at end of file
@@ -1,36 +1,539 @@
 #ifndef UTILS_HPP
 # define UTILS_HPP
 
+# include <algorithm>
+# include <cmath>
+# include <cstddef>
+# include <limits>
+# include <type_traits>
 # include <vector>
+# include <string>
+# include "Bounds.hpp"
 # include "GLShader.hpp"
+# include "JobSystem.hpp"
+# include "Simd.hpp"
 # include "Struct.hpp"
 
+/**
+ * the math is constexpr and defined below the class, so constant transforms and tables fold at compile time. During
+ * constant evaluation every function takes a plain float path, at run time the hot ones use the Simd kernels
+ */
 class Utils
 {
 	public:
-		static std::vector<s_vec3> sComputeVertexNormals(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& indices);
-		static s_BoundingBox sComputeBoundingBoxAndScale(const std::vector<s_vec3>& vertices);
-		static s_vec3 sVec3Normalize(const s_vec3& v);
-		static s_vec3 sVec3Subtract(const s_vec3& a, const s_vec3& b);
-        static s_vec3 sVec3Add(const s_vec3& a, const s_vec3& b);
-		static s_vec3 sVec3Cross(const s_vec3& a, const s_vec3& b);
-		static float sVec3Dot(const s_vec3& a, const s_vec3& b);
-		static s_quat sQuatIdentify();
-		static s_quat sQuatMultiply(const s_quat& a, const s_quat& b);
-		static s_quat sQuatFromAxisAngle(const s_vec3& axis, float angleRad);
-		static s_quat sQuatNormalize(const s_quat& q);
-		static void sMat4ToArray(const s_mat4& mat, float* out);
-		static float sBoundingBoxRadius(const s_BoundingBox& bbox);
-		static float sDistance(float boundingRadius, float fovRadius);
-		static float sRadiance();
-		static s_mat4 sMat4Multiply(const s_mat4& a, const s_mat4&b);
-		static s_mat4 sMat4Perspective(float fovRadian, float aspact, float near, float far);
-		static s_mat4 sMat4LookAt(const s_vec3& eye, const s_vec3& center, const s_vec3& worldUp);
-		static s_mat4 sMat4Scale(float s);
-		static s_mat4 sMat4Translate(float tx, float ty, float tz);
-		static s_mat4 sQuatToMat4(const s_quat& q);
-		static s_mat4 sMat4Identify();
-		static s_InputFileLines sParseInput(const char* path);
+		template <typename T>
+		static constexpr T sPi = static_cast<T>(3.141592653589793238462643383279502884L);
+
+		template <typename T>
+		static constexpr T sAbs(T x);
+		template <typename T>
+		static constexpr T sSqrt(T x);
+		template <typename T>
+		static constexpr T sSin(T x);
+		template <typename T>
+		static constexpr T sCos(T x);
+		template <typename T>
+		static constexpr T sTan(T x);
+
+		static std::vector<s_vec3> sComputeVertexNormals(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& indices,
+			JobSystem* jobs = nullptr);
+		static constexpr s_BoundingBox sComputeBoundingBoxAndScale(const std::vector<s_vec3>& vertices, JobSystem* jobs = nullptr);
+		static constexpr s_vec3 sVec3Normalize(const s_vec3& v);
+		static constexpr s_vec3 sVec3Subtract(const s_vec3& a, const s_vec3& b);
+        static constexpr s_vec3 sVec3Add(const s_vec3& a, const s_vec3& b);
+		static constexpr s_vec3 sVec3Cross(const s_vec3& a, const s_vec3& b);
+		static constexpr float sVec3Dot(const s_vec3& a, const s_vec3& b);
+		static constexpr s_quat sQuatIdentify();
+		static constexpr s_quat sQuatMultiply(const s_quat& a, const s_quat& b);
+		static constexpr s_quat sQuatFromAxisAngle(const s_vec3& axis, float angleRad);
+		static constexpr s_quat sQuatNormalize(const s_quat& q);
+		static constexpr void sMat4ToArray(const s_mat4& mat, float* out);
+		static constexpr float sBoundingBoxRadius(const s_BoundingBox& bbox);
+		static constexpr float sDistance(float boundingRadius, float fovRadius);
+		static constexpr float sRadiance();
+		static constexpr s_mat4 sMat4Multiply(const s_mat4& a, const s_mat4&b);
+		static constexpr void sMat4TransformPoints(const s_mat4& mat, const s_vec3* points, std::size_t count, s_vec4* out);
+		static constexpr s_mat4 sMat4Perspective(float fovRadian, float aspact, float near, float far);
+		static constexpr s_mat4 sMat4LookAt(const s_vec3& eye, const s_vec3& center, const s_vec3& worldUp);
+		static constexpr s_mat4 sMat4Scale(float s);
+		static constexpr s_mat4 sMat4Translate(float tx, float ty, float tz);
+		static constexpr s_mat4 sQuatToMat4(const s_quat& q);
+		static constexpr s_mat4 sMat4Identify();
+		static constexpr s_mat4 sMat4NormalMatrix(const s_mat4& model);
+		static constexpr s_mat4 sMat4Inverse(const s_mat4& mat);
+		static std::string sResolveInputPath(const char* path);
+		static s_InputFileLines sParseInput(const char* path, JobSystem* jobs = nullptr);
+		static s_InputFileLines sReadObj(const char* path, JobSystem* jobs = nullptr);
+		static void sBuildChunks(s_InputFileLines& info, unsigned int maxTriangles = 256);
+		static void sLayoutPerFace(s_InputFileLines& info);
 };
 
+template <typename T>
+constexpr T Utils::sAbs(T x)
+{
+    return x < T(0) ? -x : x;
+}
+
+template <typename T>
+constexpr T Utils::sSqrt(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::sqrt(x);
+
+    // newton iterations in double until the estimate stops moving
+    if (!(x > T(0)))
+        return (x == T(0)) ? T(0) : static_cast<T>(std::numeric_limits<double>::quiet_NaN());
+    double value = static_cast<double>(x);
+    double estimate = value < 1.0 ? 1.0 : value;
+    for (int i = 0; i < 128; ++i)
+    {
+        double next = 0.5 * (estimate + value / estimate);
+        if (next == estimate)
+            break;
+        estimate = next;
+    }
+    return static_cast<T>(estimate);
+}
+
+template <typename T>
+constexpr T Utils::sSin(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::sin(x);
+
+    // taylor series in double after folding the angle into [-pi, pi]
+    double angle = static_cast<double>(x);
+    double turns = angle / (2.0 * sPi<double>);
+    angle -= 2.0 * sPi<double> * static_cast<double>(static_cast<long long>(turns + (turns < 0.0 ? -0.5 : 0.5)));
+    double term = angle;
+    double sum = angle;
+    for (int n = 1; n < 16; ++n)
+    {
+        term *= -angle * angle / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return static_cast<T>(sum);
+}
+
+template <typename T>
+constexpr T Utils::sCos(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::cos(x);
+    return static_cast<T>(sSin(static_cast<double>(x) + 0.5 * sPi<double>));
+}
+
+template <typename T>
+constexpr T Utils::sTan(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::tan(x);
+    return static_cast<T>(static_cast<double>(sSin(static_cast<double>(x))) / static_cast<double>(sCos(static_cast<double>(x))));
+}
+
+constexpr s_vec3 Utils::sVec3Normalize(const s_vec3& v)
+{
+    float len = sSqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    if (len < 1e-6f)
+        return {0.f, 0.f, 0.f};
+    return { v.x / len, v.y / len, v.z / len};
+}
+
+constexpr s_vec3 Utils::sVec3Subtract(const s_vec3& a, const s_vec3& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+constexpr s_vec3 Utils::sVec3Add(const s_vec3& a, const s_vec3& b)
+{
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+constexpr s_vec3 Utils::sVec3Cross(const s_vec3& a, const s_vec3& b)
+{
+    return {
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x
+    };
+}
+
+constexpr float Utils::sVec3Dot(const s_vec3& a, const s_vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+constexpr s_quat Utils::sQuatIdentify()
+{
+    return {1.f, 0.f, 0.f, 0.f};
+}
+
+constexpr s_quat Utils::sQuatNormalize(const s_quat& q)
+{
+    if (std::is_constant_evaluated())
+    {
+        float len = sSqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+        if (len <= 0.f)
+            return q;
+        return {q.w / len, q.x / len, q.y / len, q.z / len};
+    }
+
+    Simd::t_Float4 v = Simd::sSet(q.w, q.x, q.y, q.z);
+    Simd::t_Float4 len = Simd::sSqrt(Simd::sDot(v, v));
+    if (Simd::sFirst(len) <= 0.f)
+        return q;
+
+    alignas(16) float result[4];
+    Simd::sStore(result, Simd::sDiv(v, len));
+    return {result[0], result[1], result[2], result[3]};
+}
+
+constexpr s_BoundingBox Utils::sComputeBoundingBoxAndScale(const std::vector<s_vec3>& vertices, JobSystem* jobs)
+{
+    // an empty mesh gets an empty box at the origin instead of reading a vertex that is not there
+    if (vertices.empty())
+        return {{0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, 1.f};
+
+    s_vec3 min = vertices[0];
+    s_vec3 max = vertices[0];
+    if (std::is_constant_evaluated())
+    {
+        for (const s_vec3& v : vertices)
+        {
+            min.x = std::min(min.x, v.x);
+            min.y = std::min(min.y, v.y);
+            min.z = std::min(min.z, v.z);
+
+            max.x = std::max(max.x, v.x);
+            max.y = std::max(max.y, v.y);
+            max.z = std::max(max.z, v.z);
+        }
+    }
+    else
+    {
+        s_Aabb box;
+        Bounds::sPoints(vertices.data(), vertices.size(), box, jobs);
+        min = box.min;
+        max = box.max;
+    }
+
+    s_vec3 center = {
+        (min.x + max.x) * 0.5f,
+        (min.y + max.y) * 0.5f,
+        (min.z + max.z) * 0.5f
+    };
+
+    s_vec3 size = {max.x - min.x, max.y - min.y, max.z - min.z};
+    float maxDim = std::max({size.x, size.y, size.z});
+
+    // a single point or a degenerate mesh keeps its size instead of dividing by zero
+    float desiredSize = 1.f;
+    float scale = (0.f < maxDim) ? desiredSize / maxDim : 1.f;
+
+    return { min, max, center, size, scale };
+}
+
+constexpr float Utils::sBoundingBoxRadius(const s_BoundingBox& bbox)
+{
+    return 0.5f * bbox.scale *
+        sSqrt(bbox.size.x * bbox.size.x +
+            bbox.size.y * bbox.size.y +
+            bbox.size.z * bbox.size.z);
+}
+
+constexpr s_quat Utils::sQuatMultiply(const s_quat& a, const s_quat& b)
+{
+    if (std::is_constant_evaluated())
+    {
+        return {
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+        };
+    }
+
+    // Hamilton product: b in (w x y z) lanes scaled by each component of a, the copies scaled by x, y and z are
+    // permuted and sign flipped so all four lanes are one multiply add each
+    Simd::t_Float4 q = Simd::sSet(b.w, b.x, b.y, b.z);
+    Simd::t_Float4 sum = Simd::sMul(Simd::sSplat(a.w), q);
+    sum = Simd::sMulAdd(Simd::sSplat(a.x), Simd::sMul(Simd::sSwapPairs(q), Simd::sSet(-1.f, 1.f, -1.f, 1.f)), sum);
+    sum = Simd::sMulAdd(Simd::sSplat(a.y), Simd::sMul(Simd::sSwapHalves(q), Simd::sSet(-1.f, 1.f, 1.f, -1.f)), sum);
+    sum = Simd::sMulAdd(Simd::sSplat(a.z), Simd::sMul(Simd::sReverse(q), Simd::sSet(-1.f, -1.f, 1.f, 1.f)), sum);
+
+    alignas(16) float result[4];
+    Simd::sStore(result, sum);
+    return {result[0], result[1], result[2], result[3]};
+}
+
+constexpr s_quat Utils::sQuatFromAxisAngle(const s_vec3& axis, float angleRad)
+{
+    float halfAngle = angleRad * 0.5f;
+    float sinHalfAngle = sSin(halfAngle);
+    return {
+        sCos(halfAngle),
+        axis.x * sinHalfAngle,
+        axis.y * sinHalfAngle,
+        axis.z * sinHalfAngle
+    };
+}
+
+constexpr void Utils::sMat4ToArray(const s_mat4& mat, float* out)
+{
+    for (int col = 0; col < 4; ++col)
+    {
+        for (int row = 0; row < 4; ++row)
+            out[col * 4 + row] = mat.m[row][col];
+    }
+}
+
+constexpr float Utils::sDistance(float boundingRadius, float fovRadius)
+{
+    return boundingRadius / sTan(fovRadius / 3.f);
+}
+
+constexpr float Utils::sRadiance()
+{
+    return static_cast<float>(sPi<double> / 6.0);
+}
+
+constexpr s_mat4 Utils::sMat4Multiply(const s_mat4& a, const s_mat4& b)
+{
+    if (std::is_constant_evaluated())
+    {
+        s_mat4 result = {};
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int col = 0; col < 4; ++col)
+            {
+                for (int k = 0; k < 4; ++k)
+                    result.m[row][col] += a.m[row][k] * b.m[k][col];
+            }
+        }
+        return result;
+    }
+
+    // each row of the result is the rows of b weighted by the matching row of a
+    Simd::t_Float4 b0 = Simd::sLoad(b.m[0]);
+    Simd::t_Float4 b1 = Simd::sLoad(b.m[1]);
+    Simd::t_Float4 b2 = Simd::sLoad(b.m[2]);
+    Simd::t_Float4 b3 = Simd::sLoad(b.m[3]);
+
+    s_mat4 result;
+    for (int row = 0; row < 4; ++row)
+    {
+        Simd::t_Float4 r = Simd::sLoad(a.m[row]);
+        Simd::t_Float4 sum = Simd::sMul(Simd::sBroadcast<0>(r), b0);
+        sum = Simd::sMulAdd(Simd::sBroadcast<1>(r), b1, sum);
+        sum = Simd::sMulAdd(Simd::sBroadcast<2>(r), b2, sum);
+        sum = Simd::sMulAdd(Simd::sBroadcast<3>(r), b3, sum);
+        Simd::sStore(result.m[row], sum);
+    }
+    return result;
+}
+
+constexpr void Utils::sMat4TransformPoints(const s_mat4& mat, const s_vec3* points, std::size_t count, s_vec4* out)
+{
+    if (std::is_constant_evaluated())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const s_vec3& p = points[i];
+            out[i] = {
+                mat.m[0][0] * p.x + mat.m[0][1] * p.y + mat.m[0][2] * p.z + mat.m[0][3],
+                mat.m[1][0] * p.x + mat.m[1][1] * p.y + mat.m[1][2] * p.z + mat.m[1][3],
+                mat.m[2][0] * p.x + mat.m[2][1] * p.y + mat.m[2][2] * p.z + mat.m[2][3],
+                mat.m[3][0] * p.x + mat.m[3][1] * p.y + mat.m[3][2] * p.z + mat.m[3][3]
+            };
+        }
+        return;
+    }
+
+    // the columns of the matrix, every point is then three multiply adds onto the translation column
+    Simd::t_Float4 c0 = Simd::sSet(mat.m[0][0], mat.m[1][0], mat.m[2][0], mat.m[3][0]);
+    Simd::t_Float4 c1 = Simd::sSet(mat.m[0][1], mat.m[1][1], mat.m[2][1], mat.m[3][1]);
+    Simd::t_Float4 c2 = Simd::sSet(mat.m[0][2], mat.m[1][2], mat.m[2][2], mat.m[3][2]);
+    Simd::t_Float4 c3 = Simd::sSet(mat.m[0][3], mat.m[1][3], mat.m[2][3], mat.m[3][3]);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const s_vec3& p = points[i];
+        Simd::t_Float4 sum = Simd::sMulAdd(Simd::sSplat(p.z), c2, c3);
+        sum = Simd::sMulAdd(Simd::sSplat(p.y), c1, sum);
+        sum = Simd::sMulAdd(Simd::sSplat(p.x), c0, sum);
+        Simd::sStoreUnaligned(&out[i].x, sum);
+    }
+}
+
+constexpr s_mat4 Utils::sMat4Perspective(float fovRadian, float aspact, float near, float far)
+{
+    s_mat4 result = {};
+    float localLength = 1.f / sTan(fovRadian / 2.f);
+    result.m[0][0] = localLength / aspact;
+    result.m[1][1] = localLength;
+    result.m[2][2] = (far + near) / (near - far);
+    result.m[2][3] = (2.f * far * near) / (near - far);
+    result.m[3][2] = -1.f;
+    result.m[3][3] = 0.f;
+
+    return result;
+}
+
+constexpr s_mat4 Utils::sMat4LookAt(const s_vec3& eye, const s_vec3& center, const s_vec3& worldUp)
+{
+    s_vec3 forward = sVec3Normalize(sVec3Subtract(center, eye));
+    s_vec3 side = sVec3Normalize(sVec3Cross(forward, worldUp));
+    s_vec3 camUp = sVec3Normalize(sVec3Cross(side, forward));
+
+    s_mat4 result = sMat4Identify();
+    result.m[0][0] = side.x;
+    result.m[0][1] = side.y;
+    result.m[0][2] = side.z;
+
+    result.m[1][0] = camUp.x;
+    result.m[1][1] = camUp.y;
+    result.m[1][2] = camUp.z;
+
+    result.m[2][0] = -forward.x;
+    result.m[2][1] = -forward.y;
+    result.m[2][2] = -forward.z;
+
+    result.m[0][3] = -sVec3Dot(side, eye);
+    result.m[1][3] = -sVec3Dot(camUp, eye);
+    result.m[2][3] = sVec3Dot(forward, eye);
+
+    return result;
+}
+
+constexpr s_mat4 Utils::sMat4Scale(float s)
+{
+    s_mat4 result = {};
+
+    result.m[0][0] = s;
+    result.m[1][1] = s;
+    result.m[2][2] = s;
+    result.m[3][3] = 1.f;
+
+    return result;
+}
+
+constexpr s_mat4 Utils::sMat4Translate(float tx, float ty, float tz)
+{
+    s_mat4 mat = sMat4Identify();
+
+    mat.m[0][3] = tx;
+    mat.m[1][3] = ty;
+    mat.m[2][3] = tz;
+
+    return mat;
+}
+
+constexpr s_mat4 Utils::sQuatToMat4(const s_quat& q)
+{
+    s_mat4 mat = sMat4Identify();
+
+    mat.m[0][0] = 1.f - 2.f * q.y * q.y - 2.f * q.z * q.z; // 1 - 2*y^2 - 2*z^2
+    mat.m[0][1] = 2.f * q.x * q.y - 2.f * q.w * q.z; // 2*x*y - 2*w*z
+    mat.m[0][2] = 2.f * q.x * q.z + 2.f * q.w * q.y; // 2*x*z + 2*w*y
+    mat.m[0][3] = 0.f;
+
+    mat.m[1][0] = 2.f * q.x * q.y + 2.f * q.w *q.z; // 2*x*y + 2*w*z
+    mat.m[1][1] = 1.f - 2.f * q.x * q.x - 2.f * q.z * q.z; // 1 - 2*2^2 - 2*z^2
+    mat.m[1][2] = 2.f * q.y * q.z - 2.f * q.w * q.x; // 2*y*z - 2*w*x
+    mat.m[1][3] = 0.f;
+
+    mat.m[2][0] = 2.f * q.x * q.z - 2.f * q.w * q.y; // 2*x*z - 2*w*y
+    mat.m[2][1] = 2.f * q.y * q.z + 2.f * q.w * q.x; // 2*y*z + 2*w*x
+    mat.m[2][2] = 1.f - 2.f * q.x * q.x - 2.f * q.y * q.y; // 1 - 2*x^2 - 2*y^2
+    mat.m[2][3] = 0.f;
+
+    mat.m[3][0] = 0.f;
+    mat.m[3][1] = 0.f;
+    mat.m[3][2] = 0.f;
+    mat.m[3][3] = 1.f;
+
+    return mat;
+}
+
+constexpr s_mat4 Utils::sMat4Identify()
+{
+    s_mat4 result = {};
+
+    for (int i = 0; i < 4; ++ i)
+        result.m[i][i] = 1.f;
+    return result;
+}
+
+constexpr s_mat4 Utils::sMat4NormalMatrix(const s_mat4& model)
+{
+    const float (&m)[4][4] = model.m;
+    s_mat4 result = sMat4Identify();
+
+    // cofactors of the upper 3x3, the inverse transpose is the cofactor matrix divided by the determinant
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float c10 = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    float c11 = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    float c12 = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    float c20 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    float c21 = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    float c22 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (sAbs(det) < 1e-12f)
+        return result;
+    float invDet = 1.f / det;
+
+    result.m[0][0] = c00 * invDet;
+    result.m[0][1] = c01 * invDet;
+    result.m[0][2] = c02 * invDet;
+    result.m[1][0] = c10 * invDet;
+    result.m[1][1] = c11 * invDet;
+    result.m[1][2] = c12 * invDet;
+    result.m[2][0] = c20 * invDet;
+    result.m[2][1] = c21 * invDet;
+    result.m[2][2] = c22 * invDet;
+
+    return result;
+}
+
+constexpr s_mat4 Utils::sMat4Inverse(const s_mat4& mat)
+{
+    // cofactor expansion over the flat array, inverting the transpose gives the transposed inverse so it works for
+    // row and column major storage alike. The copy keeps it valid in constant evaluation, where rows can't be walked
+    // past their end
+    float m[16] = {};
+    for (int i = 0; i < 16; ++i)
+        m[i] = mat.m[i / 4][i % 4];
+    float inv[16] = {};
+
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (0.f == det)
+        return sMat4Identify();
+
+    float invDet = 1.f / det;
+    s_mat4 result = {};
+    for (int i = 0; i < 16; ++i)
+        result.m[i / 4][i % 4] = inv[i] * invDet;
+    return result;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+
+// color writes are masked while the boxes are drawn, the output only exists to make the program complete
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0);
+}
\ No newline at end of file
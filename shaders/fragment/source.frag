@@ -1,20 +1,50 @@
 #version 330 core
 
+// FEATURE_TEXTURED: only the texture is shown
+// FEATURE_BLEND: color and texture are mixed by uBlend, used while the blend animation runs
+// neither: only the light intensity is shown and the texture is never sampled
+// FEATURE_INSTANCED: the light intensity is tinted by the color of the instance
+// FEATURE_DEPTH_ONLY: the depth pre-pass, color writes are masked so nothing is shaded
+
 in float lightIntensity;
 in vec2 texCoord;
 
-uniform sampler2D uTexture;
-uniform float uBlend;
+#if defined(FEATURE_INSTANCED)
+in vec3 instanceColor;
+#endif
+
+#if defined(FEATURE_TEXTURED) || defined(FEATURE_BLEND)
+uniform sampler2DArray uTextures;
+#endif
+
+#include "../include/frame_data.glsl"
 
 out vec4 FragColor;
 
+vec4 shadedColor()
+{
+#if defined(FEATURE_INSTANCED)
+    return vec4(abs(lightIntensity) * instanceColor, 1.0);
+#else
+    return vec4(vec3(abs(lightIntensity)), 1.0);
+#endif
+}
+
 void main()
 {
-    vec4 colorVal = vec4(vec3(abs(lightIntensity)), 1.0);
+#if defined(FEATURE_DEPTH_ONLY)
+    FragColor = vec4(0.0);
+#elif defined(FEATURE_BLEND)
+    vec4 colorVal = shadedColor();
 
-    vec4 texVal = texture(uTexture, texCoord);
+    vec4 texVal = texture(uTextures, vec3(texCoord, uTexLayer));
 
     float smoothBlend = smoothstep(0.0, 1.0, uBlend);
 
     FragColor = mix(colorVal, texVal, smoothBlend);
+#elif defined(FEATURE_TEXTURED)
+    FragColor = texture(uTextures, vec3(texCoord, uTexLayer));
+#else
+    FragColor = shadedColor();
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+layout(std140, row_major) uniform FrameData
+{
+    mat4 uMVP;
+    mat4 uModel;
+    mat3 uNormalMatrix;
+    vec4 uLightDir;
+    float uBlend;
+    float uTexLayer;
+    vec4 uTexRect;
+    mat4 uViewProj;
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330
+
+// bounding boxes of the occlusion queries, only their depth test matters so nothing is passed on
+
+layout(location = 0) in vec3 aPos;
+
+#include "../include/frame_data.glsl"
+
+void main()
+{
+    gl_Position = uMVP * vec4(aPos, 1.0);
+}
\ No newline at end of file
@@ -1,22 +1,42 @@
 #version 330
 
+// FEATURE_INSTANCED: every instance places the model with its own transform and tints it with its own color
+
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 2) in vec3 aNormal;
 
+#if defined(FEATURE_INSTANCED)
+// the first three rows of a row major affine transform, the last row is always 0 0 0 1
+layout(location = 3) in vec4 aInstanceRow0;
+layout(location = 4) in vec4 aInstanceRow1;
+layout(location = 5) in vec4 aInstanceRow2;
+layout(location = 6) in vec4 aInstanceColor;
+
+out vec3 instanceColor;
+#endif
+
 out vec2 texCoord;
 out float lightIntensity;
 
-uniform mat4 uMVP;
-uniform mat4 uModel;
+// the depth pre-pass and the GL_EQUAL shading pass run different programs, both have to write the exact same depth
+invariant gl_Position;
+
+#include "../include/frame_data.glsl"
 
 void main()
 {
-    vec3 lightDir = normalize(vec3(0.5, 1.0, 0.3));
+#if defined(FEATURE_INSTANCED)
+    mat4 instance = transpose(mat4(aInstanceRow0, aInstanceRow1, aInstanceRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+    vec3 norm = normalize(mat3(instance) * (uNormalMatrix * aNormal));
 
-    vec3 norm = mat3(transpose(inverse(uModel))) * aNormal;
+    gl_Position = uViewProj * instance * uModel * vec4(aPos, 1.0);
+    instanceColor = aInstanceColor.rgb;
+#else
+    vec3 norm = uNormalMatrix * aNormal;
 
     gl_Position = uMVP * vec4(aPos, 1.0);
-    texCoord = aTexCoord;
-    lightIntensity = max(dot(norm, lightDir), 0.0);
+#endif
+    texCoord = uTexRect.xy + aTexCoord * uTexRect.zw;
+    lightIntensity = max(dot(norm, uLightDir.xyz), 0.0);
 }
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "Bounds.hpp"
+#include "Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// the directions EPOS looks for extremal points along: the axes, then the corner diagonals, then the edge diagonals.
+// Only comparisons along each direction matter, so they are not normalized
+static const float sEposNormals[13][3] = {
+    {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f},
+    {1.f, 1.f, 1.f}, {1.f, 1.f, -1.f}, {1.f, -1.f, 1.f}, {1.f, -1.f, -1.f},
+    {1.f, 1.f, 0.f}, {1.f, -1.f, 0.f}, {1.f, 0.f, 1.f}, {1.f, 0.f, -1.f}, {0.f, 1.f, 1.f}, {0.f, 1.f, -1.f}
+};
+
+static s_vec3 sSub(const s_vec3& a, const s_vec3& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+static float sDot(const s_vec3& a, const s_vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static s_vec3 sCross(const s_vec3& a, const s_vec3& b)
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static bool sContains(const s_Sphere& sphere, const s_vec3& point)
+{
+    if (sphere.radius < 0.f)
+        return false;
+    s_vec3 offset = sSub(point, sphere.center);
+    // a little slack so the points the sphere was built from count as inside despite rounding
+    return sDot(offset, offset) <= sphere.radius * sphere.radius * 1.0001f + 1e-12f;
+}
+
+// Arvo: the new center is the transformed center, the new extent is the extent through the absolute matrix
+static s_Aabb sTransformColumns(Simd::t_Float4 c0, Simd::t_Float4 c1, Simd::t_Float4 c2, Simd::t_Float4 c3, const s_Aabb& box)
+{
+    const Simd::t_Float4 half = Simd::sSplat(0.5f);
+    Simd::t_Float4 min = Simd::sSet(box.min.x, box.min.y, box.min.z, 0.f);
+    Simd::t_Float4 max = Simd::sSet(box.max.x, box.max.y, box.max.z, 0.f);
+    Simd::t_Float4 center = Simd::sMul(Simd::sAdd(min, max), half);
+    Simd::t_Float4 extent = Simd::sMul(Simd::sSub(max, min), half);
+
+    Simd::t_Float4 newCenter = Simd::sMulAdd(c0, Simd::sBroadcast<0>(center), c3);
+    newCenter = Simd::sMulAdd(c1, Simd::sBroadcast<1>(center), newCenter);
+    newCenter = Simd::sMulAdd(c2, Simd::sBroadcast<2>(center), newCenter);
+    Simd::t_Float4 newExtent = Simd::sMul(Simd::sAbs(c0), Simd::sBroadcast<0>(extent));
+    newExtent = Simd::sMulAdd(Simd::sAbs(c1), Simd::sBroadcast<1>(extent), newExtent);
+    newExtent = Simd::sMulAdd(Simd::sAbs(c2), Simd::sBroadcast<2>(extent), newExtent);
+
+    alignas(16) float lanes[2][4];
+    Simd::sStore(lanes[0], Simd::sSub(newCenter, newExtent));
+    Simd::sStore(lanes[1], Simd::sAdd(newCenter, newExtent));
+    return {{lanes[0][0], lanes[0][1], lanes[0][2]}, {lanes[1][0], lanes[1][1], lanes[1][2]}};
+}
+
+bool Bounds::sPoints(const s_vec3* points, std::size_t count, s_Aabb& box, JobSystem* jobs)
+{
+    if (!points || 0 == count)
+        return false;
+
+    // every range writes its own box, they are merged once all are done
+    std::vector<s_Aabb> ranges((count + sPointGrain - 1) / sPointGrain);
+    JobSystem::sParallelFor(jobs, count, sPointGrain, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t first = begin; first < end; first += sPointGrain)
+            ranges[first / sPointGrain] = sPointsRange(points + first, std::min(end, first + sPointGrain) - first);
+    });
+    box = ranges[0];
+    for (const s_Aabb& range : ranges)
+    {
+        box.min = {std::min(box.min.x, range.min.x), std::min(box.min.y, range.min.y), std::min(box.min.z, range.min.z)};
+        box.max = {std::max(box.max.x, range.max.x), std::max(box.max.y, range.max.y), std::max(box.max.z, range.max.z)};
+    }
+    return true;
+}
+
+s_Aabb Bounds::sPointsRange(const s_vec3* points, std::size_t count)
+{
+    static_assert(sizeof(s_vec3) == 3 * sizeof(float), "s_vec3 arrays are read as packed floats");
+
+    s_vec3 min = points[0];
+    s_vec3 max = points[0];
+    std::size_t i = 0;
+
+    // four points are twelve floats, read as three vectors whose lanes hold (x y z x) (y z x y) (z x y z), so the
+    // loop needs no shuffles and the lanes are folded into the three axes at the end
+    Simd::t_Float4 min0 = Simd::sSet(min.x, min.y, min.z, min.x);
+    Simd::t_Float4 min1 = Simd::sSet(min.y, min.z, min.x, min.y);
+    Simd::t_Float4 min2 = Simd::sSet(min.z, min.x, min.y, min.z);
+    Simd::t_Float4 max0 = min0;
+    Simd::t_Float4 max1 = min1;
+    Simd::t_Float4 max2 = min2;
+
+    const float* data = &points[0].x;
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* group = data + i * 3;
+        Simd::t_Float4 v0 = Simd::sLoadUnaligned(group);
+        Simd::t_Float4 v1 = Simd::sLoadUnaligned(group + 4);
+        Simd::t_Float4 v2 = Simd::sLoadUnaligned(group + 8);
+        min0 = Simd::sMin(min0, v0);
+        min1 = Simd::sMin(min1, v1);
+        min2 = Simd::sMin(min2, v2);
+        max0 = Simd::sMax(max0, v0);
+        max1 = Simd::sMax(max1, v1);
+        max2 = Simd::sMax(max2, v2);
+    }
+
+    alignas(16) float lanes[6][4];
+    Simd::sStore(lanes[0], min0);
+    Simd::sStore(lanes[1], min1);
+    Simd::sStore(lanes[2], min2);
+    Simd::sStore(lanes[3], max0);
+    Simd::sStore(lanes[4], max1);
+    Simd::sStore(lanes[5], max2);
+    min = {
+        std::min({lanes[0][0], lanes[0][3], lanes[1][2], lanes[2][1]}),
+        std::min({lanes[0][1], lanes[1][0], lanes[1][3], lanes[2][2]}),
+        std::min({lanes[0][2], lanes[1][1], lanes[2][0], lanes[2][3]})
+    };
+    max = {
+        std::max({lanes[3][0], lanes[3][3], lanes[4][2], lanes[5][1]}),
+        std::max({lanes[3][1], lanes[4][0], lanes[4][3], lanes[5][2]}),
+        std::max({lanes[3][2], lanes[4][1], lanes[5][0], lanes[5][3]})
+    };
+
+    for (; i < count; ++i)
+    {
+        const s_vec3& v = points[i];
+        min = {std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z)};
+        max = {std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z)};
+    }
+    return {min, max};
+}
+
+s_Aabb Bounds::sTransform(const s_mat4& mat, const s_Aabb& box)
+{
+    Simd::t_Float4 c0 = Simd::sLoad(mat.m[0]);
+    Simd::t_Float4 c1 = Simd::sLoad(mat.m[1]);
+    Simd::t_Float4 c2 = Simd::sLoad(mat.m[2]);
+    Simd::t_Float4 c3 = Simd::sLoad(mat.m[3]);
+    Simd::sTranspose(c0, c1, c2, c3);
+    return sTransformColumns(c0, c1, c2, c3, box);
+}
+
+void Bounds::sTransform(const s_mat4& mat, const s_Aabb* boxes, std::size_t count, s_Aabb* out, JobSystem* jobs)
+{
+    // the columns are set up once for the whole batch
+    Simd::t_Float4 c0 = Simd::sLoad(mat.m[0]);
+    Simd::t_Float4 c1 = Simd::sLoad(mat.m[1]);
+    Simd::t_Float4 c2 = Simd::sLoad(mat.m[2]);
+    Simd::t_Float4 c3 = Simd::sLoad(mat.m[3]);
+    Simd::sTranspose(c0, c1, c2, c3);
+
+    JobSystem::sParallelFor(jobs, count, sBoxGrain, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = sTransformColumns(c0, c1, c2, c3, boxes[i]);
+    });
+}
+
+void Bounds::sTransform(const s_mat4* mats, std::size_t count, const s_Aabb& box, s_Aabb* out, JobSystem* jobs)
+{
+    JobSystem::sParallelFor(jobs, count, sBoxGrain, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = sTransform(mats[i], box);
+    });
+}
+
+s_Sphere Bounds::sTransform(const s_mat4& mat, const s_Sphere& sphere)
+{
+    const s_vec3& c = sphere.center;
+    s_vec3 center = {
+        mat.m[0][0] * c.x + mat.m[0][1] * c.y + mat.m[0][2] * c.z + mat.m[0][3],
+        mat.m[1][0] * c.x + mat.m[1][1] * c.y + mat.m[1][2] * c.z + mat.m[1][3],
+        mat.m[2][0] * c.x + mat.m[2][1] * c.y + mat.m[2][2] * c.z + mat.m[2][3]
+    };
+
+    // the longest column is the largest scale the matrix applies, so the sphere still covers a non uniform scale
+    float scale = 0.f;
+    for (int col = 0; col < 3; ++col)
+    {
+        s_vec3 column = {mat.m[0][col], mat.m[1][col], mat.m[2][col]};
+        scale = std::max(scale, sDot(column, column));
+    }
+    return {center, sphere.radius * std::sqrt(scale)};
+}
+
+bool Bounds::sRitterSphere(const s_vec3* points, std::size_t count, s_Sphere& sphere)
+{
+    if (!points || 0 == count)
+        return false;
+
+    // the point furthest from any point, then the point furthest from that one, span the first guess
+    auto furthest = [&](const s_vec3& from)
+    {
+        std::size_t best = 0;
+        float bestDistance = -1.f;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            s_vec3 offset = sSub(points[i], from);
+            float distance = sDot(offset, offset);
+            if (bestDistance < distance)
+            {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return points[best];
+    };
+    s_vec3 a = furthest(points[0]);
+    s_vec3 b = furthest(a);
+    s_vec3 offset = sSub(b, a);
+
+    sphere.center = {0.5f * (a.x + b.x), 0.5f * (a.y + b.y), 0.5f * (a.z + b.z)};
+    sphere.radius = 0.5f * std::sqrt(sDot(offset, offset));
+    sGrow(sphere, points, count);
+    return true;
+}
+
+bool Bounds::sEposSphere(const s_vec3* points, std::size_t count, s_Sphere& sphere, unsigned int normalCount, JobSystem* jobs)
+{
+    if (!points || 0 == count)
+        return false;
+
+    normalCount = (normalCount <= 3) ? 3 : (normalCount <= 7) ? 7 : 13;
+    std::vector<s_vec3> extremes;
+    if (count <= 2 * normalCount)
+        extremes.assign(points, points + count);
+    else
+    {
+        // every range keeps the lowest and highest point along each normal, the ranges are merged afterwards
+        struct s_Range
+        {
+            float low[13];
+            float high[13];
+            std::size_t lowIndex[13];
+            std::size_t highIndex[13];
+        };
+        std::vector<s_Range> ranges((count + sPointGrain - 1) / sPointGrain);
+        JobSystem::sParallelFor(jobs, count, sPointGrain, [&](std::size_t begin, std::size_t end)
+        {
+            // without a job system the whole set comes as one call, it is still cut into the same ranges
+            for (std::size_t first = begin; first < end; first += sPointGrain)
+            {
+                std::size_t last = std::min(end, first + sPointGrain);
+                s_Range& range = ranges[first / sPointGrain];
+                for (unsigned int n = 0; n < normalCount; ++n)
+                {
+                    range.low[n] = sDot(points[first], {sEposNormals[n][0], sEposNormals[n][1], sEposNormals[n][2]});
+                    range.high[n] = range.low[n];
+                    range.lowIndex[n] = first;
+                    range.highIndex[n] = first;
+                }
+                for (std::size_t i = first + 1; i < last; ++i)
+                {
+                    const s_vec3& p = points[i];
+                    for (unsigned int n = 0; n < normalCount; ++n)
+                    {
+                        float projection = sEposNormals[n][0] * p.x + sEposNormals[n][1] * p.y + sEposNormals[n][2] * p.z;
+                        if (projection < range.low[n])
+                        {
+                            range.low[n] = projection;
+                            range.lowIndex[n] = i;
+                        }
+                        else if (range.high[n] < projection)
+                        {
+                            range.high[n] = projection;
+                            range.highIndex[n] = i;
+                        }
+                    }
+                }
+            }
+        });
+
+        for (unsigned int n = 0; n < normalCount; ++n)
+        {
+            std::size_t low = 0;
+            std::size_t high = 0;
+            for (std::size_t r = 1; r < ranges.size(); ++r)
+            {
+                if (ranges[r].low[n] < ranges[low].low[n])
+                    low = r;
+                if (ranges[high].high[n] < ranges[r].high[n])
+                    high = r;
+            }
+            extremes.push_back(points[ranges[low].lowIndex[n]]);
+            extremes.push_back(points[ranges[high].highIndex[n]]);
+        }
+    }
+
+    // the exact sphere of the extremal points is close to the final one, the pass over all points only fixes the few
+    // that still stick out
+    s_vec3 support[4];
+    sphere = sMinSphere(extremes.data(), extremes.size(), support, 0);
+    sGrow(sphere, points, count);
+    return true;
+}
+
+s_Sphere Bounds::sMinSphere(s_vec3* points, std::size_t count, s_vec3* support, unsigned int supportCount)
+{
+    // Welzl: the smallest sphere of the points with the support points on its surface
+    s_Sphere sphere = sSupportSphere(support, supportCount);
+    if (4 == supportCount)
+        return sphere;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (sContains(sphere, points[i]))
+            continue;
+        support[supportCount] = points[i];
+        sphere = sMinSphere(points, i, support, supportCount + 1);
+    }
+    return sphere;
+}
+
+s_Sphere Bounds::sSupportSphere(const s_vec3* support, unsigned int supportCount)
+{
+    if (0 == supportCount)
+        return {{0.f, 0.f, 0.f}, -1.f};
+    if (1 == supportCount)
+        return {support[0], 0.f};
+
+    const s_vec3& origin = support[0];
+    s_vec3 a = sSub(support[1], origin);
+    if (2 == supportCount)
+        return {{origin.x + 0.5f * a.x, origin.y + 0.5f * a.y, origin.z + 0.5f * a.z}, 0.5f * std::sqrt(sDot(a, a))};
+
+    // circumcenters relative to the first support point, degenerate triangles and tetrahedra fall back to a grown
+    // sphere of fewer points
+    s_vec3 b = sSub(support[2], origin);
+    s_vec3 ab = sCross(a, b);
+    s_vec3 offset;
+    if (3 == supportCount)
+    {
+        float denominator = 2.f * sDot(ab, ab);
+        if (denominator <= 1e-20f)
+        {
+            s_Sphere sphere = sSupportSphere(support, 2);
+            sGrow(sphere, support + 2, 1);
+            return sphere;
+        }
+        s_vec3 toA = sCross(ab, a);
+        s_vec3 toB = sCross(b, ab);
+        float aa = sDot(a, a);
+        float bb = sDot(b, b);
+        offset = {(aa * toB.x + bb * toA.x) / denominator, (aa * toB.y + bb * toA.y) / denominator, (aa * toB.z + bb * toA.z) / denominator};
+    }
+    else
+    {
+        s_vec3 c = sSub(support[3], origin);
+        float denominator = 2.f * sDot(a, sCross(b, c));
+        if (std::fabs(denominator) <= 1e-20f)
+        {
+            s_Sphere sphere = sSupportSphere(support, 3);
+            sGrow(sphere, support + 3, 1);
+            return sphere;
+        }
+        s_vec3 bc = sCross(b, c);
+        s_vec3 ca = sCross(c, a);
+        float aa = sDot(a, a);
+        float bb = sDot(b, b);
+        float cc = sDot(c, c);
+        offset = {
+            (aa * bc.x + bb * ca.x + cc * ab.x) / denominator,
+            (aa * bc.y + bb * ca.y + cc * ab.y) / denominator,
+            (aa * bc.z + bb * ca.z + cc * ab.z) / denominator
+        };
+    }
+    return {{origin.x + offset.x, origin.y + offset.y, origin.z + offset.z}, std::sqrt(sDot(offset, offset))};
+}
+
+void Bounds::sGrow(s_Sphere& sphere, const s_vec3* points, std::size_t count)
+{
+    // a point outside moves the sphere toward it just enough that the old sphere and the point are both covered
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        s_vec3 offset = sSub(points[i], sphere.center);
+        float distanceSquared = sDot(offset, offset);
+        if (distanceSquared <= sphere.radius * sphere.radius)
+            continue;
+
+        float distance = std::sqrt(distanceSquared);
+        float radius = 0.5f * (sphere.radius + distance);
+        float move = (radius - sphere.radius) / distance;
+        sphere.center = {sphere.center.x + offset.x * move, sphere.center.y + offset.y * move, sphere.center.z + offset.z * move};
+        sphere.radius = radius;
+    }
+}
\ No newline at end of file
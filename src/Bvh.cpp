@@ -0,0 +1,186 @@
+#include "Bvh.hpp"
+#include <algorithm>
+#include <limits>
+
+void Bvh::build(const std::vector<s_Aabb>& bounds, unsigned int maxLeafSize)
+{
+    clear();
+    if (bounds.empty())
+        return;
+    maxLeafSize = std::max(maxLeafSize, 1u);
+
+    std::vector<s_vec3> centroids(bounds.size());
+    m_indices.resize(bounds.size());
+    for (std::size_t i = 0; i < bounds.size(); ++i)
+    {
+        centroids[i] = {
+            0.5f * (bounds[i].min.x + bounds[i].max.x),
+            0.5f * (bounds[i].min.y + bounds[i].max.y),
+            0.5f * (bounds[i].min.z + bounds[i].max.z)
+        };
+        m_indices[i] = static_cast<unsigned int>(i);
+    }
+
+    // only a hint, leaves usually end up close to full
+    m_nodes.reserve(2 * (bounds.size() / maxLeafSize) + 1);
+    m_nodes.push_back({{}, 0, {}, static_cast<unsigned int>(bounds.size())});
+    fitNode(m_nodes[0], bounds);
+
+    std::vector<unsigned int> stack = {0};
+    while (!stack.empty())
+    {
+        unsigned int nodeIndex = stack.back();
+        stack.pop_back();
+        s_Node node = m_nodes[nodeIndex];
+        if (node.count <= maxLeafSize)
+            continue;
+
+        int axis = 0;
+        float position = 0.f;
+        if (!findSplit(node, centroids, bounds, axis, position))
+            continue;
+
+        // partition the index run of the node around the split plane
+        unsigned int* first = m_indices.data() + node.leftFirst;
+        unsigned int* last = first + node.count;
+        unsigned int* middle = std::partition(first, last, [&centroids, axis, position](unsigned int id)
+        {
+            return (&centroids[id].x)[axis] < position;
+        });
+        unsigned int leftCount = static_cast<unsigned int>(middle - first);
+        if (0 == leftCount || node.count == leftCount)
+            continue;
+
+        unsigned int leftIndex = static_cast<unsigned int>(m_nodes.size());
+        s_Node left = {{}, node.leftFirst, {}, leftCount};
+        s_Node right = {{}, node.leftFirst + leftCount, {}, node.count - leftCount};
+        fitNode(left, bounds);
+        fitNode(right, bounds);
+
+        // pushing may reallocate, so the parent is written through its index
+        m_nodes[nodeIndex].leftFirst = leftIndex;
+        m_nodes[nodeIndex].count = 0;
+        m_nodes.push_back(left);
+        m_nodes.push_back(right);
+        stack.push_back(leftIndex + 1);
+        stack.push_back(leftIndex);
+    }
+}
+
+void Bvh::clear()
+{
+    m_nodes.clear();
+    m_indices.clear();
+}
+
+const std::vector<Bvh::s_Node>& Bvh::getNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<unsigned int>& Bvh::getIndices() const
+{
+    return m_indices;
+}
+
+bool Bvh::empty() const
+{
+    return m_nodes.empty();
+}
+
+void Bvh::fitNode(s_Node& node, const std::vector<s_Aabb>& bounds) const
+{
+    const float inf = std::numeric_limits<float>::max();
+    node.min = {inf, inf, inf};
+    node.max = {-inf, -inf, -inf};
+    for (unsigned int i = 0; i < node.count; ++i)
+    {
+        const s_Aabb& box = bounds[m_indices[node.leftFirst + i]];
+        node.min = {std::min(node.min.x, box.min.x), std::min(node.min.y, box.min.y), std::min(node.min.z, box.min.z)};
+        node.max = {std::max(node.max.x, box.max.x), std::max(node.max.y, box.max.y), std::max(node.max.z, box.max.z)};
+    }
+}
+
+bool Bvh::findSplit(const s_Node& node, const std::vector<s_vec3>& centroids, const std::vector<s_Aabb>& bounds, int& axis, float& position) const
+{
+    const int binCount = 12;
+    const float inf = std::numeric_limits<float>::max();
+
+    struct s_Bin
+    {
+        s_vec3 min;
+        s_vec3 max;
+        unsigned int count;
+    };
+
+    float bestCost = inf;
+    for (int a = 0; a < 3; ++a)
+    {
+        // bins are spread over the centroid bounds, the box bounds can be much wider than where the centroids are
+        float low = inf;
+        float high = -inf;
+        for (unsigned int i = 0; i < node.count; ++i)
+        {
+            float c = (&centroids[m_indices[node.leftFirst + i]].x)[a];
+            low = std::min(low, c);
+            high = std::max(high, c);
+        }
+        if (low == high)
+            continue;
+
+        s_Bin bins[binCount];
+        for (s_Bin& bin : bins)
+            bin = {{inf, inf, inf}, {-inf, -inf, -inf}, 0};
+
+        float scale = binCount / (high - low);
+        for (unsigned int i = 0; i < node.count; ++i)
+        {
+            unsigned int id = m_indices[node.leftFirst + i];
+            int b = std::min(binCount - 1, static_cast<int>(((&centroids[id].x)[a] - low) * scale));
+            s_Bin& bin = bins[b];
+            bin.count++;
+            bin.min = {std::min(bin.min.x, bounds[id].min.x), std::min(bin.min.y, bounds[id].min.y), std::min(bin.min.z, bounds[id].min.z)};
+            bin.max = {std::max(bin.max.x, bounds[id].max.x), std::max(bin.max.y, bounds[id].max.y), std::max(bin.max.z, bounds[id].max.z)};
+        }
+
+        // sweep from both sides so every plane between two bins is evaluated in linear time
+        float leftArea[binCount - 1];
+        unsigned int leftCount[binCount - 1];
+        s_Bin sweep = {{inf, inf, inf}, {-inf, -inf, -inf}, 0};
+        for (int b = 0; b < binCount - 1; ++b)
+        {
+            sweep.count += bins[b].count;
+            sweep.min = {std::min(sweep.min.x, bins[b].min.x), std::min(sweep.min.y, bins[b].min.y), std::min(sweep.min.z, bins[b].min.z)};
+            sweep.max = {std::max(sweep.max.x, bins[b].max.x), std::max(sweep.max.y, bins[b].max.y), std::max(sweep.max.z, bins[b].max.z)};
+            leftCount[b] = sweep.count;
+            leftArea[b] = sweep.count ? sArea(sweep.min, sweep.max) : 0.f;
+        }
+
+        sweep = {{inf, inf, inf}, {-inf, -inf, -inf}, 0};
+        for (int b = binCount - 1; b > 0; --b)
+        {
+            sweep.count += bins[b].count;
+            sweep.min = {std::min(sweep.min.x, bins[b].min.x), std::min(sweep.min.y, bins[b].min.y), std::min(sweep.min.z, bins[b].min.z)};
+            sweep.max = {std::max(sweep.max.x, bins[b].max.x), std::max(sweep.max.y, bins[b].max.y), std::max(sweep.max.z, bins[b].max.z)};
+            if (0 == leftCount[b - 1] || 0 == sweep.count)
+                continue;
+
+            float cost = leftCount[b - 1] * leftArea[b - 1] + sweep.count * sArea(sweep.min, sweep.max);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                position = low + b / scale;
+            }
+        }
+    }
+    return bestCost < inf;
+}
+
+float Bvh::sArea(const s_vec3& min, const s_vec3& max)
+{
+    float x = max.x - min.x;
+    float y = max.y - min.y;
+    float z = max.z - min.z;
+    return x * y + y * z + z * x;
+}
\ No newline at end of file
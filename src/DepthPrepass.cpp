@@ -0,0 +1,154 @@
+#include "DepthPrepass.hpp"
+
+// overdraw of the plain mode, measured as its shaded fragments over those of the pre-pass mode, above which the
+// pre-pass pays for its extra geometry pass. Switching back needs a clear drop so the mode doesn't flip every probe
+static const float sEnableAbove = 1.5f;
+static const float sDisableBelow = 1.25f;
+// weight of a new measurement in the running averages
+static const double sSmoothing = 0.2;
+
+DepthPrepass::DepthPrepass():
+m_frame(0),
+m_measuring(false),
+m_autoPrepass(false),
+m_overdraw(0.f)
+{}
+
+bool DepthPrepass::setup()
+{
+    // ARB_pipeline_statistics_query counts fragment shader invocations, without it the samples that passed the depth test
+    // are the closest count, which is what gets shaded once early depth testing runs
+    GLenum target = countsInvocations() ? GL_FRAGMENT_SHADER_INVOCATIONS_ARB : GL_SAMPLES_PASSED;
+    return m_fragments.setup(sFramesInFlight * sSlotsPerFrame, target) && m_times.setup(sFramesInFlight, GL_TIME_ELAPSED);
+}
+
+bool DepthPrepass::beginFrame(e_PrepassMode mode)
+{
+    collect();
+
+    bool prepass = m_autoPrepass;
+    if (e_PrepassMode::On == mode)
+        prepass = true;
+    else if (e_PrepassMode::Off == mode)
+        prepass = false;
+    else if (0 == m_stats[0].frames || 0 == m_stats[1].frames || 0 == m_frame % sProbeInterval)
+    {
+        // a probe frame draws the same image in the other mode, until both modes have numbers the missing one is drawn
+        prepass = (0 == m_stats[0].frames) ? false : (0 == m_stats[1].frames) ? true : !m_autoPrepass;
+    }
+
+    // a ring entry whose results haven't arrived yet is never reused, that frame simply isn't measured
+    s_Frame& frame = m_frames[m_frame % sFramesInFlight];
+    m_measuring = 0 == frame.remaining;
+    if (m_measuring)
+    {
+        frame = s_Frame();
+        frame.prepass = prepass;
+        m_times.begin(m_frame % sFramesInFlight);
+    }
+    return prepass;
+}
+
+void DepthPrepass::begin(e_Pass pass)
+{
+    s_Frame& frame = m_frames[m_frame % sFramesInFlight];
+    if (!m_measuring || sSlotsPerFrame <= frame.slots)
+        return;
+
+    frame.passes[frame.slots] = pass;
+    m_fragments.begin((m_frame % sFramesInFlight) * sSlotsPerFrame + frame.slots);
+}
+
+void DepthPrepass::end()
+{
+    s_Frame& frame = m_frames[m_frame % sFramesInFlight];
+    if (!m_measuring || sSlotsPerFrame <= frame.slots)
+        return;
+
+    m_fragments.end();
+    ++frame.slots;
+}
+
+void DepthPrepass::endFrame()
+{
+    if (m_measuring)
+    {
+        s_Frame& frame = m_frames[m_frame % sFramesInFlight];
+        m_times.end();
+        frame.remaining = frame.slots + 1;
+    }
+    m_measuring = false;
+    ++m_frame;
+}
+
+bool DepthPrepass::isAutoEnabled() const
+{
+    return m_autoPrepass;
+}
+
+float DepthPrepass::getOverdraw() const
+{
+    return m_overdraw;
+}
+
+const DepthPrepass::s_ModeStats& DepthPrepass::getStats(bool prepass) const
+{
+    return m_stats[prepass ? 1 : 0];
+}
+
+bool DepthPrepass::countsInvocations() const
+{
+    return GLAD_GL_ARB_pipeline_statistics_query;
+}
+
+void DepthPrepass::collect()
+{
+    // results are only read once available, a frame counts when its last query came in
+    for (unsigned int ring = 0; ring < sFramesInFlight; ++ring)
+    {
+        s_Frame& frame = m_frames[ring];
+        if (0 == frame.remaining)
+            continue;
+
+        for (unsigned int slot = 0; slot < frame.slots; ++slot)
+        {
+            GLuint result = 0;
+            if (!m_fragments.poll(ring * sSlotsPerFrame + slot, result))
+                continue;
+            if (e_Pass::Depth == frame.passes[slot])
+                frame.depthFragments += result;
+            else
+                frame.shadeFragments += result;
+            --frame.remaining;
+        }
+
+        GLuint nanoseconds = 0;
+        if (m_times.poll(ring, nanoseconds))
+        {
+            frame.gpuMs = nanoseconds * 1e-6;
+            --frame.remaining;
+        }
+
+        if (0 == frame.remaining)
+            record(frame);
+    }
+}
+
+void DepthPrepass::record(const s_Frame& frame)
+{
+    s_ModeStats& stats = m_stats[frame.prepass ? 1 : 0];
+    double weight = (0 == stats.frames) ? 1.0 : sSmoothing;
+    stats.depthFragments += (frame.depthFragments - stats.depthFragments) * weight;
+    stats.shadeFragments += (frame.shadeFragments - stats.shadeFragments) * weight;
+    stats.gpuMs += (frame.gpuMs - stats.gpuMs) * weight;
+    ++stats.frames;
+
+    // with the pre-pass every covered pixel is shaded once, so that count is the baseline the plain mode is divided by
+    if (0 == m_stats[0].frames || 0 == m_stats[1].frames || 0.0 >= m_stats[1].shadeFragments)
+        return;
+    m_overdraw = static_cast<float>(m_stats[0].shadeFragments / m_stats[1].shadeFragments);
+    if (!m_autoPrepass && sEnableAbove < m_overdraw)
+        m_autoPrepass = true;
+    else if (m_autoPrepass && sDisableBelow > m_overdraw)
+        m_autoPrepass = false;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "Frustum.hpp"
+#include "Simd.hpp"
+#include <cmath>
+
+void Frustum::setup(const s_mat4& mvp)
+{
+    // Gribb and Hartmann: each plane is the last row of the matrix plus or minus one of the others
+    const float sign[6] = {1.f, -1.f, 1.f, -1.f, 1.f, -1.f};
+    for (int i = 0; i < 6; ++i)
+    {
+        int row = i / 2;
+        float x = mvp.m[3][0] + sign[i] * mvp.m[row][0];
+        float y = mvp.m[3][1] + sign[i] * mvp.m[row][1];
+        float z = mvp.m[3][2] + sign[i] * mvp.m[row][2];
+        float w = mvp.m[3][3] + sign[i] * mvp.m[row][3];
+
+        float length = std::sqrt(x * x + y * y + z * z);
+        float inverse = (0.f < length) ? 1.f / length : 0.f;
+        m_x[i] = x * inverse;
+        m_y[i] = y * inverse;
+        m_z[i] = z * inverse;
+        m_w[i] = w * inverse;
+    }
+    for (int i = 6; i < 8; ++i)
+    {
+        m_x[i] = 0.f;
+        m_y[i] = 0.f;
+        m_z[i] = 0.f;
+        m_w[i] = 1.f;
+    }
+}
+
+Frustum::e_Result Frustum::test(const s_vec3& min, const s_vec3& max) const
+{
+    // a box is outside when its corner furthest along the plane normal is behind it, that distance is the distance
+    // of the center plus the extents projected onto the absolute normal
+    const Simd::t_Float4 half = Simd::sSplat(0.5f);
+    const Simd::t_Float4 zero = Simd::sSplat(0.f);
+    Simd::t_Float4 cx = Simd::sMul(Simd::sAdd(Simd::sSplat(min.x), Simd::sSplat(max.x)), half);
+    Simd::t_Float4 cy = Simd::sMul(Simd::sAdd(Simd::sSplat(min.y), Simd::sSplat(max.y)), half);
+    Simd::t_Float4 cz = Simd::sMul(Simd::sAdd(Simd::sSplat(min.z), Simd::sSplat(max.z)), half);
+    Simd::t_Float4 ex = Simd::sMul(Simd::sSub(Simd::sSplat(max.x), Simd::sSplat(min.x)), half);
+    Simd::t_Float4 ey = Simd::sMul(Simd::sSub(Simd::sSplat(max.y), Simd::sSplat(min.y)), half);
+    Simd::t_Float4 ez = Simd::sMul(Simd::sSub(Simd::sSplat(max.z), Simd::sSplat(min.z)), half);
+
+    // the two planes past the sixth always pass, so both batches of four run without a tail
+    int intersecting = 0;
+    for (int batch = 0; batch < 8; batch += 4)
+    {
+        Simd::t_Float4 nx = Simd::sLoad(m_x + batch);
+        Simd::t_Float4 ny = Simd::sLoad(m_y + batch);
+        Simd::t_Float4 nz = Simd::sLoad(m_z + batch);
+        Simd::t_Float4 nw = Simd::sLoad(m_w + batch);
+
+        Simd::t_Float4 distance = Simd::sMulAdd(nx, cx, Simd::sMulAdd(ny, cy, Simd::sMulAdd(nz, cz, nw)));
+        Simd::t_Float4 radius = Simd::sMulAdd(Simd::sAbs(nx), ex, Simd::sMulAdd(Simd::sAbs(ny), ey, Simd::sMul(Simd::sAbs(nz), ez)));
+
+        if (Simd::sLessMask(Simd::sAdd(distance, radius), zero))
+            return e_Result::Outside;
+        intersecting |= Simd::sLessMask(Simd::sSub(distance, radius), zero);
+    }
+    return intersecting ? e_Result::Intersect : e_Result::Inside;
+}
+
+Frustum::e_Result Frustum::test(const s_Sphere& sphere) const
+{
+    // the planes are normalized, so the signed distance of the center is compared with the radius directly
+    Simd::t_Float4 cx = Simd::sSplat(sphere.center.x);
+    Simd::t_Float4 cy = Simd::sSplat(sphere.center.y);
+    Simd::t_Float4 cz = Simd::sSplat(sphere.center.z);
+    Simd::t_Float4 radius = Simd::sSplat(sphere.radius);
+    const Simd::t_Float4 zero = Simd::sSplat(0.f);
+
+    int intersecting = 0;
+    for (int batch = 0; batch < 8; batch += 4)
+    {
+        Simd::t_Float4 distance = Simd::sMulAdd(Simd::sLoad(m_x + batch), cx,
+            Simd::sMulAdd(Simd::sLoad(m_y + batch), cy, Simd::sMulAdd(Simd::sLoad(m_z + batch), cz, Simd::sLoad(m_w + batch))));
+
+        if (Simd::sLessMask(Simd::sAdd(distance, radius), zero))
+            return e_Result::Outside;
+        intersecting |= Simd::sLessMask(Simd::sSub(distance, radius), zero);
+    }
+    return intersecting ? e_Result::Intersect : e_Result::Inside;
+}
+
+void Frustum::cull(const Bvh& bvh, std::vector<unsigned int>& visible) const
+{
+    visible.clear();
+    if (bvh.empty())
+        return;
+
+    const std::vector<Bvh::s_Node>& nodes = bvh.getNodes();
+    const std::vector<unsigned int>& indices = bvh.getIndices();
+
+    // the second value marks subtrees whose parent was fully inside, they are taken without another test
+    std::vector<std::pair<unsigned int, bool>> stack;
+    stack.reserve(64);
+    stack.push_back({0, false});
+    while (!stack.empty())
+    {
+        auto [nodeIndex, inside] = stack.back();
+        stack.pop_back();
+        const Bvh::s_Node& node = nodes[nodeIndex];
+
+        if (!inside)
+        {
+            e_Result result = test(node.min, node.max);
+            if (e_Result::Outside == result)
+                continue;
+            inside = e_Result::Inside == result;
+        }
+
+        if (0 < node.count)
+        {
+            visible.insert(visible.end(), indices.begin() + node.leftFirst, indices.begin() + node.leftFirst + node.count);
+            continue;
+        }
+        stack.push_back({node.leftFirst + 1, inside});
+        stack.push_back({node.leftFirst, inside});
+    }
+}
\ No newline at end of file
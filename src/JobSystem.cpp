@@ -0,0 +1,318 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <exception>
+
+struct JobSystem::s_Task
+{
+    std::function<void()> work;
+    std::atomic<unsigned int> blockers{1}; // unfinished dependencies, plus one held by add until it is done wiring
+    std::atomic<bool> done{false};
+    std::thread::id owner; // the thread that added it, the only one outside the pool that may run it
+    std::mutex mutex; // guards finished, error and continuations
+    bool finished = false;
+    std::exception_ptr error;
+    std::vector<t_Task> continuations;
+};
+
+// which system and deque the calling thread works for, threads outside every pool use the shared deque 0
+static thread_local const JobSystem* sCurrentSystem = nullptr;
+static thread_local std::size_t sCurrentQueue = 0;
+
+JobSystem::JobSystem(unsigned int threads):
+m_queued(0),
+m_scheduled(0),
+m_waiting(0),
+m_stop(false)
+{
+    if (0 == threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threads; ++i)
+        m_queues.push_back(std::make_unique<s_Queue>());
+    for (unsigned int i = 1; i < threads; ++i)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+JobSystem::t_Task JobSystem::add(std::function<void()> work, const std::vector<t_Task>& dependencies)
+{
+    t_Task task = std::make_shared<s_Task>();
+    task->work = std::move(work);
+    task->owner = std::this_thread::get_id();
+
+    // a dependency that already finished is skipped, the others queue the task when they are done
+    for (const t_Task& dependency : dependencies)
+    {
+        if (!dependency)
+            continue;
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->finished)
+        {
+            ++task->blockers;
+            dependency->continuations.push_back(task);
+        }
+        else if (dependency->error)
+        {
+            std::lock_guard<std::mutex> taskLock(task->mutex);
+            if (!task->error)
+                task->error = dependency->error;
+        }
+    }
+    release(task);
+    return task;
+}
+
+void JobSystem::wait(const t_Task& task)
+{
+    if (!task)
+        return;
+
+    // a worker helps with anything, a thread outside the pool only with its own tasks
+    bool worker = this == sCurrentSystem;
+    while (!task->done)
+    {
+        unsigned long scheduled = m_scheduled;
+        if (worker ? runOne(sCurrentQueue) : runOwn())
+            continue;
+
+        // nothing to help with, the task is running somewhere else
+        ++m_waiting;
+        {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this, &task, worker, scheduled]()
+            {
+                return task->done || (worker ? 0 < m_queued : scheduled != m_scheduled);
+            });
+        }
+        --m_waiting;
+    }
+    if (task->error)
+        std::rethrow_exception(task->error);
+}
+
+void JobSystem::wait(const std::vector<t_Task>& tasks)
+{
+    // every task is waited for even after one threw, they may still reference the caller's data
+    std::exception_ptr error;
+    for (const t_Task& task : tasks)
+    {
+        try
+        {
+            wait(task);
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void JobSystem::parallelFor(std::size_t count, std::size_t grain, const t_RangeWork& work)
+{
+    grain = std::max<std::size_t>(grain, 1);
+    if (count <= grain || m_workers.empty())
+    {
+        if (0 < count)
+            work(0, count);
+        return;
+    }
+
+    // the first range runs on the calling thread, the others are up for grabs
+    std::vector<t_Task> ranges;
+    ranges.reserve(count / grain);
+    for (std::size_t begin = grain; begin < count; begin += grain)
+    {
+        std::size_t end = std::min(count, begin + grain);
+        ranges.push_back(add([&work, begin, end]() { work(begin, end); }));
+    }
+
+    std::exception_ptr error;
+    try
+    {
+        work(0, grain);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    try
+    {
+        wait(ranges);
+    }
+    catch (...)
+    {
+        if (!error)
+            error = std::current_exception();
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+unsigned int JobSystem::getThreadCount() const
+{
+    return static_cast<unsigned int>(m_queues.size());
+}
+
+void JobSystem::sParallelFor(JobSystem* jobs, std::size_t count, std::size_t grain, const t_RangeWork& work)
+{
+    if (jobs)
+        jobs->parallelFor(count, grain, work);
+    else if (0 < count)
+        work(0, count);
+}
+
+void JobSystem::workerLoop(std::size_t queue)
+{
+    sCurrentSystem = this;
+    sCurrentQueue = queue;
+    while (true)
+    {
+        if (runOne(queue))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stop || 0 < m_queued; });
+        if (m_stop)
+            return;
+    }
+}
+
+std::size_t JobSystem::currentQueue() const
+{
+    return (this == sCurrentSystem) ? sCurrentQueue : 0;
+}
+
+void JobSystem::schedule(const t_Task& task)
+{
+    s_Queue& queue = *m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    ++m_queued;
+    ++m_scheduled;
+
+    // taking the lock once orders the counts before a sleeper's check, so the wake up can not slip in between. A waiting
+    // thread outside the pool may be the only one allowed to run the task, so waiters get woken all at once
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    if (0 < m_waiting)
+        m_wake.notify_all();
+    else
+        m_wake.notify_one();
+}
+
+void JobSystem::release(const t_Task& task)
+{
+    if (1 == task->blockers--)
+        schedule(task);
+}
+
+bool JobSystem::runOne(std::size_t queue)
+{
+    // the newest own task is still warm in the cache, stolen tasks are the oldest ones of their deque
+    t_Task task;
+    for (std::size_t i = 0; i < m_queues.size() && !task; ++i)
+    {
+        s_Queue& victim = *m_queues[(queue + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        if (0 == i)
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+
+    --m_queued;
+    run(task);
+    return true;
+}
+
+bool JobSystem::runOwn()
+{
+    // the own tasks may sit in any deque, a worker that finished a dependency queued the continuation in its own
+    std::thread::id self = std::this_thread::get_id();
+    t_Task task;
+    for (std::size_t i = 0; i < m_queues.size() && !task; ++i)
+    {
+        s_Queue& queue = *m_queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        std::deque<t_Task>::iterator own = std::find_if(queue.tasks.begin(), queue.tasks.end(),
+            [&self](const t_Task& queued) { return queued->owner == self; });
+        if (queue.tasks.end() == own)
+            continue;
+        task = std::move(*own);
+        queue.tasks.erase(own);
+    }
+    if (!task)
+        return false;
+
+    --m_queued;
+    run(task);
+    return true;
+}
+
+void JobSystem::run(const t_Task& task)
+{
+    if (!task->error)
+    {
+        try
+        {
+            task->work();
+        }
+        catch (...)
+        {
+            task->error = std::current_exception();
+        }
+    }
+    task->work = nullptr;
+
+    std::vector<t_Task> continuations;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->finished = true;
+        continuations.swap(task->continuations);
+    }
+    for (const t_Task& continuation : continuations)
+    {
+        if (task->error)
+        {
+            std::lock_guard<std::mutex> lock(continuation->mutex);
+            if (!continuation->error)
+                continuation->error = task->error;
+        }
+        release(continuation);
+    }
+
+    task->done = true;
+    if (0 < m_waiting)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_all();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "MeshLoader.hpp"
+#include "Utils.hpp"
+#include "TriangleOrder.hpp"
+#include "GLTexture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// wraps a stage so it writes its own wall time, every stage has its own slot so the tasks never share one
+template <typename Work>
+static std::function<void()> sTimed(double& ms, Work work)
+{
+    return [&ms, work]()
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        work();
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+}
+
+s_MeshData MeshLoader::sLoad(const std::string& path, JobSystem& jobs, s_Times* times, const s_Order* previous)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    s_Times local;
+    s_Times& t = times ? *times : local;
+
+    s_MeshData mesh;
+    s_InputFileLines& info = mesh.info;
+    std::vector<s_vec2> texCoords;
+    std::vector<s_vec3> normals;
+    std::vector<s_vec2> texCoordsPerFace;
+    std::vector<s_vec3> normalsPerFace;
+
+    // the stages only read what their dependencies wrote, and the ones running side by side write different members
+    JobSystem::t_Task read = jobs.add(sTimed(t.read, [&]() { info = Utils::sReadObj(path.c_str(), &jobs); }));
+    JobSystem::t_Task bounds = jobs.add(sTimed(t.bounds, [&]()
+    {
+        mesh.bbox = Utils::sComputeBoundingBoxAndScale(info.vertices, &jobs);
+        if (!Bounds::sEposSphere(info.vertices.data(), info.vertices.size(), mesh.sphere, 7, &jobs))
+            mesh.sphere = {mesh.bbox.center, 0.f};
+#ifdef DEBUG
+        std::cout << "[Bounds] sphere radius " << mesh.sphere.radius << " against a box half diagonal of "
+            << Utils::sBoundingBoxRadius(mesh.bbox) / mesh.bbox.scale << std::endl;
+#endif
+        float boundingRadius = Utils::sBoundingBoxRadius(mesh.bbox);
+        if (0.f < boundingRadius)
+            mesh.bbox.scale = 1.f / (2.f * boundingRadius);
+    }), {read});
+    // the chunks and the order depend on the positions, so with the same faces the earlier ones are kept and only their bounds follow
+    bool keepOrder = false;
+    JobSystem::t_Task chunks = jobs.add(sTimed(t.chunks, [&]()
+    {
+        mesh.fileFaces = info.faces;
+        keepOrder = previous && sSameFaces(*previous, info);
+        if (!keepOrder)
+        {
+            Utils::sBuildChunks(info);
+            return;
+        }
+        info.faces = previous->faces;
+        info.chunks = previous->chunks;
+        sUpdateChunkBounds(info);
+    }), {read});
+    JobSystem::t_Task order = jobs.add(sTimed(t.order, [&]()
+    {
+        if (!keepOrder)
+            TriangleOrder::sOptimize(info, 16, 0.75f, &jobs);
+    }), {chunks});
+
+    JobSystem::t_Task chunkBvh = jobs.add(sTimed(t.chunkBvh, [&]()
+    {
+        std::vector<s_Aabb> chunkBounds;
+        chunkBounds.reserve(info.chunks.size());
+        for (const s_Chunk& chunk : info.chunks)
+            chunkBounds.push_back(chunk.bounds);
+        mesh.chunkBvh.build(chunkBounds);
+    }), {order});
+
+    JobSystem::t_Task texCoordTask = jobs.add(sTimed(t.texCoords, [&]() { GLTexture::sGenerateTexCoordGlobal(info.vertices, info.faces, texCoords); }), {order});
+    JobSystem::t_Task normalTask = jobs.add(sTimed(t.normals, [&]() { normals = Utils::sComputeVertexNormals(info.vertices, info.faces, &jobs); }), {order});
+    JobSystem::t_Task interleave = jobs.add(sTimed(t.interleave, [&]() { sInterleave(info.vertices, texCoords, normals, mesh.vertices, jobs); }),
+        {texCoordTask, normalTask});
+
+    // the per face layout repeats every corner, so its vertices follow the ordered faces
+    JobSystem::t_Task layout = jobs.add(sTimed(t.layout, [&]() { Utils::sLayoutPerFace(info); }), {order});
+    JobSystem::t_Task texCoordPerFaceTask = jobs.add(sTimed(t.texCoordsPerFace, [&]()
+    {
+        GLTexture::sGenerateTexCoordPerFace(info.facesPerFace, texCoordsPerFace);
+    }), {layout});
+    JobSystem::t_Task normalPerFaceTask = jobs.add(sTimed(t.normalsPerFace, [&]()
+    {
+        normalsPerFace = Utils::sComputeVertexNormals(info.verticesPerFace, info.facesPerFace, &jobs);
+    }), {layout});
+    JobSystem::t_Task interleavePerFace = jobs.add(sTimed(t.interleavePerFace, [&]()
+    {
+        sInterleave(info.verticesPerFace, texCoordsPerFace, normalsPerFace, mesh.verticesPerFace, jobs);
+    }), {texCoordPerFaceTask, normalPerFaceTask});
+
+    // waits on every leaf even when the read threw, the tasks still hold references to the locals above
+    jobs.wait({bounds, chunkBvh, interleave, interleavePerFace});
+    t.total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return mesh;
+}
+
+void MeshLoader::sPrintTimes(const s_Times& times, unsigned int threads)
+{
+    std::cout << "[Load] " << threads << " threads, " << times.total << " ms | read " << times.read << ", bounds " << times.bounds
+        << ", chunks " << times.chunks << ", order " << times.order << ", chunk bvh " << times.chunkBvh << " | uvs " << times.texCoords
+        << ", normals " << times.normals << ", interleave " << times.interleave << " | per face layout " << times.layout << ", uvs "
+        << times.texCoordsPerFace << ", normals " << times.normalsPerFace << ", interleave " << times.interleavePerFace << std::endl;
+}
+
+bool MeshLoader::sSameFaces(const s_Order& previous, const s_InputFileLines& info)
+{
+    if (previous.fileFaces != info.faces || previous.objects.size() != info.objects.size())
+        return false;
+    for (std::size_t i = 0; i < info.objects.size(); ++i)
+    {
+        if (previous.objects[i].firstIndex != info.objects[i].firstIndex || previous.objects[i].indexCount != info.objects[i].indexCount)
+            return false;
+    }
+    return true;
+}
+
+void MeshLoader::sUpdateChunkBounds(s_InputFileLines& info)
+{
+    for (s_Chunk& chunk : info.chunks)
+    {
+        chunk.bounds.min = info.vertices[info.faces[chunk.firstIndex]];
+        chunk.bounds.max = chunk.bounds.min;
+        for (unsigned int i = chunk.firstIndex; i < chunk.firstIndex + chunk.indexCount; ++i)
+        {
+            const s_vec3& v = info.vertices[info.faces[i]];
+            chunk.bounds.min = {std::min(chunk.bounds.min.x, v.x), std::min(chunk.bounds.min.y, v.y), std::min(chunk.bounds.min.z, v.z)};
+            chunk.bounds.max = {std::max(chunk.bounds.max.x, v.x), std::max(chunk.bounds.max.y, v.y), std::max(chunk.bounds.max.z, v.z)};
+        }
+    }
+}
+
+void MeshLoader::sInterleave(const std::vector<s_vec3>& positions, const std::vector<s_vec2>& texCoords, const std::vector<s_vec3>& normals,
+    std::vector<s_Vertex>& out, JobSystem& jobs)
+{
+    out.resize(positions.size());
+    jobs.parallelFor(positions.size(), sVertexGrain, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = {positions[i], texCoords[i], normals[i]};
+    });
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "OcclusionCuller.hpp"
+#include "GLState.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// corners are numbered by bits, 1 is max x, 2 is max y, 4 is max z. Two counter clockwise triangles per side
+static const unsigned int sBoxIndices[36] = {
+    0, 4, 6, 0, 6, 2, // -x
+    5, 1, 3, 5, 3, 7, // +x
+    0, 1, 5, 0, 5, 4, // -y
+    6, 7, 3, 6, 3, 2, // +y
+    1, 0, 2, 1, 2, 3, // -z
+    4, 5, 7, 4, 7, 6 // +z
+};
+
+OcclusionCuller::OcclusionCuller():
+m_vbo(GLBuffer::e_Type::Array),
+m_ebo(GLBuffer::e_Type::Element),
+m_tested(false),
+m_testedMvp()
+{}
+
+bool OcclusionCuller::setup(GLuint frameBlockBinding)
+{
+    // the boxes go through the same FrameData block as the mesh so they share its mvp
+    m_shaders.setBinaryCacheDir(".cache/shaders");
+    if (!m_shaders.setup("shaders/vertex/bounds.vert", "shaders/fragment/bounds.frag", {}))
+        return false;
+    m_shaders.addUniformBlock("FrameData", frameBlockBinding);
+    if (!m_shaders.prebuild({0}))
+        return false;
+
+    return m_vbo.setup() && m_ebo.setup() && m_boxes.setup();
+}
+
+bool OcclusionCuller::setChunks(const std::vector<s_Chunk>& chunks)
+{
+    m_tested = false;
+    m_bounds.clear();
+    m_occluded.assign(chunks.size(), 0);
+    if (chunks.empty())
+        return m_queries.setup(0, GLQuery::sOcclusionTarget());
+
+    // 8 corners and 36 indices per chunk, box i starts at index 36 * i so it is drawn like a chunk range
+    std::vector<s_vec3> corners;
+    std::vector<unsigned int> indices;
+    corners.reserve(chunks.size() * 8);
+    indices.reserve(chunks.size() * 36);
+    m_bounds.reserve(chunks.size());
+    for (const s_Chunk& chunk : chunks)
+    {
+        const s_Aabb& box = chunk.bounds;
+        unsigned int base = static_cast<unsigned int>(corners.size());
+        for (unsigned int corner = 0; corner < 8; ++corner)
+        {
+            corners.push_back({(corner & 1) ? box.max.x : box.min.x,
+                (corner & 2) ? box.max.y : box.min.y,
+                (corner & 4) ? box.max.z : box.min.z});
+        }
+        for (unsigned int index : sBoxIndices)
+            indices.push_back(base + index);
+        m_bounds.push_back(box);
+    }
+
+    std::vector<s_VertexAttribute> attributes = {{0, 3, GL_FLOAT, GL_FALSE, sizeof(s_vec3), 0}};
+    if (!m_vbo.setData(corners, GL_STATIC_DRAW) || !m_boxes.attachVertexBuffer(m_vbo, attributes)
+        || !m_ebo.setData(indices, GL_STATIC_DRAW) || !m_boxes.attachElementBuffer(m_ebo))
+    {
+        std::cerr << "failed to upload occlusion boxes" << std::endl;
+        return false;
+    }
+
+    // the old queries counted other boxes, new ones start out visible until their first result comes in
+    return m_queries.setup(chunks.size(), GLQuery::sOcclusionTarget());
+}
+
+void OcclusionCuller::reset()
+{
+    // every chunk counts as visible again and the next test runs whatever the view
+    m_tested = false;
+    std::fill(m_occluded.begin(), m_occluded.end(), 0);
+}
+
+bool OcclusionCuller::collect()
+{
+    // only results the gpu already has are read, the rest keep their last state and are asked for again next frame
+    bool changed = false;
+    for (std::size_t chunk = 0; chunk < m_occluded.size(); ++chunk)
+    {
+        GLuint samples = 0;
+        if (!m_queries.poll(chunk, samples))
+            continue;
+
+        unsigned char occluded = (0 == samples) ? 1 : 0;
+        changed = changed || occluded != m_occluded[chunk];
+        m_occluded[chunk] = occluded;
+    }
+    return changed;
+}
+
+void OcclusionCuller::split(const std::vector<unsigned int>& inFrustum, std::vector<unsigned int>& visible, std::vector<unsigned int>& occluded) const
+{
+    visible.clear();
+    occluded.clear();
+    for (unsigned int chunk : inFrustum)
+    {
+        if (chunk < m_occluded.size() && m_occluded[chunk])
+            occluded.push_back(chunk);
+        else
+            visible.push_back(chunk);
+    }
+}
+
+unsigned int OcclusionCuller::test(const s_mat4& mvp, const std::vector<unsigned int>& inFrustum)
+{
+    // the same view over the same depth gives the same answers, the last results stay valid
+    if (m_tested && 0 == std::memcmp(&m_testedMvp, &mvp, sizeof(s_mat4)))
+        return 0;
+
+    GLShader* shader = m_shaders.get(0);
+    if (!shader || inFrustum.empty())
+        return 0;
+
+    // the boxes only count samples: no color, no depth, and equal depth passes so a box touching its own surface counts
+    shader->bind();
+    GLState::sColorMask(false);
+    GLState::sDepthMask(false);
+    GLState::sDepthFunc(GL_LEQUAL);
+
+    unsigned int issued = 0;
+    bool dropped = false;
+    for (unsigned int chunk : inFrustum)
+    {
+        if (chunk >= m_bounds.size())
+            continue;
+
+        // the near plane would clip away the front of a box around the camera, those chunks are just visible
+        if (sCrossesNearPlane(mvp, m_bounds[chunk]))
+        {
+            m_occluded[chunk] = 0;
+            continue;
+        }
+
+        // a result still on its way is waited for instead of thrown away by restarting the query
+        if (m_queries.isPending(chunk))
+        {
+            dropped = true;
+            continue;
+        }
+
+        m_queries.begin(chunk);
+        m_boxes.drawRange(chunk * 36, 36, GL_TRIANGLES, GL_UNSIGNED_INT);
+        m_queries.end();
+        ++issued;
+    }
+
+    GLState::sDepthFunc(GL_LESS);
+    GLState::sDepthMask(true);
+    GLState::sColorMask(true);
+
+    m_tested = !dropped;
+    m_testedMvp = mvp;
+    return issued;
+}
+
+void OcclusionCuller::drawOccluded(const GLMesh& mesh, const std::vector<s_Chunk>& chunks, const std::vector<unsigned int>& occluded) const
+{
+    // hidden last time, the gpu skips the draw when this frame's box still counted no samples
+    for (unsigned int chunk : occluded)
+    {
+        if (chunk >= chunks.size() || !m_queries.wasIssued(chunk))
+            continue;
+
+        m_queries.beginConditionalRender(chunk, GL_QUERY_NO_WAIT);
+        mesh.drawRange(chunks[chunk].firstIndex, static_cast<GLsizei>(chunks[chunk].indexCount), GL_TRIANGLES, GL_UNSIGNED_INT);
+        m_queries.endConditionalRender();
+    }
+}
+
+bool OcclusionCuller::sCrossesNearPlane(const s_mat4& mvp, const s_Aabb& box)
+{
+    // a corner is in front of the near plane when its clip z is above -w
+    s_vec3 corners[8];
+    for (unsigned int corner = 0; corner < 8; ++corner)
+    {
+        corners[corner] = {
+            (corner & 1) ? box.max.x : box.min.x,
+            (corner & 2) ? box.max.y : box.min.y,
+            (corner & 4) ? box.max.z : box.min.z
+        };
+    }
+    s_vec4 clip[8];
+    Utils::sMat4TransformPoints(mvp, corners, 8, clip);
+    for (const s_vec4& c : clip)
+    {
+        if (c.z < -c.w)
+            return true;
+    }
+    return false;
+}
\ No newline at end of file
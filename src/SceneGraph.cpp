@@ -0,0 +1,132 @@
+#include "SceneGraph.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+int SceneGraph::createNode(int parent)
+{
+    if (sNoParent != parent && (0 > parent || static_cast<std::size_t>(parent) >= m_parents.size()))
+        throw std::runtime_error("scene graph parent does not exist");
+
+    int node = static_cast<int>(m_parents.size());
+    m_translations.push_back({0.f, 0.f, 0.f});
+    m_rotations.push_back(Utils::sQuatIdentify());
+    m_scales.push_back(1.f);
+    m_parents.push_back(parent);
+    m_worlds.push_back(Utils::sMat4Identify());
+    m_dirty.push_back(1);
+    markDirty(node);
+    return node;
+}
+
+void SceneGraph::reserve(std::size_t count)
+{
+    m_translations.reserve(count);
+    m_rotations.reserve(count);
+    m_scales.reserve(count);
+    m_parents.reserve(count);
+    m_worlds.reserve(count);
+    m_dirty.reserve(count);
+}
+
+void SceneGraph::clear()
+{
+    m_translations.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_parents.clear();
+    m_worlds.clear();
+    m_dirty.clear();
+    m_firstDirty = 0;
+}
+
+void SceneGraph::setTranslation(int node, const s_vec3& translation)
+{
+    s_vec3& current = m_translations[node];
+    if (current.x == translation.x && current.y == translation.y && current.z == translation.z)
+        return;
+    current = translation;
+    markDirty(node);
+}
+
+void SceneGraph::setRotation(int node, const s_quat& rotation)
+{
+    s_quat& current = m_rotations[node];
+    if (current.w == rotation.w && current.x == rotation.x && current.y == rotation.y && current.z == rotation.z)
+        return;
+    current = rotation;
+    markDirty(node);
+}
+
+void SceneGraph::setScale(int node, float scale)
+{
+    if (m_scales[node] == scale)
+        return;
+    m_scales[node] = scale;
+    markDirty(node);
+}
+
+std::size_t SceneGraph::update()
+{
+    std::size_t recomputed = 0;
+    std::size_t count = m_parents.size();
+
+    // parents come first, so a dirty parent has its new world matrix before any child reads it
+    for (std::size_t i = m_firstDirty; i < count; ++i)
+    {
+        int parent = m_parents[i];
+        if (sNoParent != parent && m_dirty[parent])
+            m_dirty[i] = 1;
+        if (!m_dirty[i])
+            continue;
+
+        s_mat4 local = localMatrix(static_cast<int>(i));
+        m_worlds[i] = (sNoParent == parent) ? local : Utils::sMat4Multiply(m_worlds[parent], local);
+        ++recomputed;
+    }
+
+    // the flags are only cleared after the pass, children further down still have to see their parent as dirty
+    if (m_firstDirty < count)
+        std::fill(m_dirty.begin() + m_firstDirty, m_dirty.end(), 0);
+    m_firstDirty = count;
+    return recomputed;
+}
+
+const s_mat4& SceneGraph::getWorld(int node) const
+{
+    return m_worlds[node];
+}
+
+int SceneGraph::getParent(int node) const
+{
+    return m_parents[node];
+}
+
+std::size_t SceneGraph::size() const
+{
+    return m_parents.size();
+}
+
+void SceneGraph::markDirty(int node)
+{
+    m_dirty[node] = 1;
+    m_firstDirty = std::min(m_firstDirty, static_cast<std::size_t>(node));
+}
+
+s_mat4 SceneGraph::localMatrix(int node) const
+{
+    // T * R * S written out directly, the scale multiplies the rotation columns and the translation fills the last one
+    s_mat4 local = Utils::sQuatToMat4(m_rotations[node]);
+    float scale = m_scales[node];
+    const s_vec3& translation = m_translations[node];
+    for (int row = 0; row < 3; ++row)
+    {
+        local.m[row][0] *= scale;
+        local.m[row][1] *= scale;
+        local.m[row][2] *= scale;
+    }
+    local.m[0][3] = translation.x;
+    local.m[1][3] = translation.y;
+    local.m[2][3] = translation.z;
+    return local;
+}
\ No newline at end of file
@@ -1,30 +1,99 @@
 #include "Scop.hpp"
+#include "MeshLoader.hpp"
 #include "Utils.hpp"
+#include "GLState.hpp"
+#include "GLDebug.hpp"
 #include "stdexcept"
 #include <algorithm>
-
-Scop::Scop(char* objectFilePath):
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+// a key press turns the model by a fixed step, so its rotations are built while compiling
+static constexpr float sAngleStep = 0.01f;
+static constexpr struct
+{
+    int key;
+    s_quat rotation;
+} sKeyRotations[] = {
+    {GLFW_KEY_W, Utils::sQuatFromAxisAngle({1.f, 0.f, 0.f}, sAngleStep)}, // up
+    {GLFW_KEY_S, Utils::sQuatFromAxisAngle({1.f, 0.f, 0.f}, -sAngleStep)}, // down
+    {GLFW_KEY_D, Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, sAngleStep)}, // right
+    {GLFW_KEY_A, Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, -sAngleStep)}, // left
+    {GLFW_KEY_Q, Utils::sQuatFromAxisAngle({0.f, 0.f, 1.f}, -sAngleStep)}, // rotate left
+    {GLFW_KEY_E, Utils::sQuatFromAxisAngle({0.f, 0.f, 1.f}, sAngleStep)} // rotate right
+};
+static constexpr s_vec3 sLightDir = Utils::sVec3Normalize({0.5f, 1.f, 0.3f});
+
+Scop::Scop(char* objectFilePath, unsigned int instanceCount, unsigned int threadCount):
+m_jobs(threadCount),
 m_context(4, 1),
 m_window(800, 800, "scop"),
-m_shader(),
-m_texture(),
-m_buffers()
+m_shaders(),
+m_textures(),
+m_sampler(),
+m_frameBlock(0),
+m_buffers(),
+m_instanceCount(std::max(instanceCount, 1u))
 {
-    m_info = Utils::sParseInput(objectFilePath);
-    m_bbox = Utils::sComputeBoundingBoxAndScale(m_info.vertices);
-    float boundingRadius = Utils::sBoundingBoxRadius(m_bbox);
-    m_bbox.scale = 1.f / (2.f * boundingRadius);
+    m_objectPath = Utils::sResolveInputPath(objectFilePath);
+    MeshLoader::s_Times loadTimes;
+    s_MeshData mesh = MeshLoader::sLoad(m_objectPath, m_jobs, &loadTimes);
+    MeshLoader::sPrintTimes(loadTimes, m_jobs.getThreadCount());
+    m_info = std::move(mesh.info);
+    m_fileFaces = std::move(mesh.fileFaces);
+    m_chunkBvh = std::move(mesh.chunkBvh);
+    m_bbox = mesh.bbox;
+    m_sphere = mesh.sphere;
+    m_vertices = std::move(mesh.vertices);
+    m_verticesPerFace = std::move(mesh.verticesPerFace);
 
     if (!GLContext::sInitGlad())
         throw std::runtime_error("failed to initialize glad");
-
-    if (!m_shader.setup("shaders/vertex/source.vert", "shaders/fragment/source.frag"))
+#ifdef DEBUG
+    // 131185 is the nvidia note about where a buffer lives, it comes with every upload
+    if (GLDebug::sEnable(GL_DEBUG_SEVERITY_LOW, 128))
+        GLDebug::sIgnore({131185});
+#endif
+
+    m_shaders.setBinaryCacheDir(".cache/shaders");
+    m_shaders.addUniformBlock("FrameData", m_frameBlock.getBindingPoint());
+    m_shaders.addSampler("uTextures", 0);
+    if (!m_shaders.setup("shaders/vertex/source.vert", "shaders/fragment/source.frag", {"FEATURE_TEXTURED", "FEATURE_BLEND", "FEATURE_INSTANCED", "FEATURE_DEPTH_ONLY"}))
         throw std::runtime_error("failed to setup shaders");
 
-    if (!m_texture.setup("textures/nyan.bmp"))
-        throw std::runtime_error("failed to setup texture");
-
-    std::vector<s_Vertex>verticesInterLeaved = setupShaderBufferData();
+    // only the variants of the current draw mode are ever selected
+    std::uint32_t instanced = (1 < m_instanceCount) ? static_cast<std::uint32_t>(e_ShaderFeature::Instanced) : 0;
+    std::vector<std::uint32_t> variants = {
+        static_cast<std::uint32_t>(e_ShaderFeature::None) | instanced,
+        static_cast<std::uint32_t>(e_ShaderFeature::Textured) | instanced,
+        static_cast<std::uint32_t>(e_ShaderFeature::Blend) | instanced,
+        static_cast<std::uint32_t>(e_ShaderFeature::DepthOnly) | instanced
+    };
+    if (!m_shaders.prebuild(variants))
+        throw std::runtime_error("failed to build shader variants");
+
+    if (!m_textures.setup(1024, 4))
+        throw std::runtime_error("failed to setup texture array");
+
+    // a baked container skips the bmp decode, both are loaded on a worker and packed into the array when ready
+    std::string material = std::filesystem::exists("textures/nyan.stex") ? "textures/nyan.stex" : "textures/nyan.bmp";
+    m_material = m_textures.load(material);
+    if (0 > m_material)
+        throw std::runtime_error("failed to load texture");
+
+    // sampling state lives in one sampler object on unit 0, every texture bound there is filtered the same way.
+    // materials are packed in an array so uvs are clamped, the array only has the mips its padding keeps a border on so minifying further aliases instead of bleeding
+    if (!m_sampler.setup(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE))
+        throw std::runtime_error("failed to setup sampler");
+    m_sampler.bind(0);
+
+    if (!m_frameBlock.setup(sizeof(s_FrameUniforms)))
+        throw std::runtime_error("failed to setup frame uniform block");
+
+    if (!m_depthPrepass.setup())
+        throw std::runtime_error("failed to setup depth pre-pass queries");
 
     std::vector<s_VertexAttribute> attributes;
     s_VertexAttribute vertA{0, 3, GL_FLOAT, GL_FALSE, sizeof(s_Vertex), offsetof(s_Vertex, position)};
@@ -35,38 +104,62 @@ m_buffers()
     attributes.push_back(vertB);
     attributes.push_back(vertC);
 
-    if (!setupBuffersGlobal(verticesInterLeaved, attributes))
+    if (!setupBuffersGlobal(m_vertices, attributes))
         throw std::runtime_error("failed to setup buffers with global shaders");
 
-    std::vector<s_Vertex> verticesInterLeavedFace = setupShaderBufferDataPerFace();
-
-    if (!setupBuffersPerFace(verticesInterLeavedFace, attributes))
+    if (!setupBuffersPerFace(m_verticesPerFace, attributes))
         throw std::runtime_error("failed to setup buffers with per face shader");
 
+    if (1 < m_instanceCount && !setupInstances())
+        throw std::runtime_error("failed to setup instance buffer");
+
+    if (!m_multiDraw.setup() || !setupDrawCommands())
+        throw std::runtime_error("failed to setup draw commands");
+
+    // the chunk boxes only cover the single model, instances are never occlusion tested
+    if (1 == m_instanceCount && (!m_occlusion.setup(m_frameBlock.getBindingPoint()) || !m_occlusion.setChunks(m_info.chunks)))
+        throw std::runtime_error("failed to setup occlusion culling");
+
+    if (m_watcher.setup())
+    {
+        watchShaderFiles();
+        m_watcher.watch(m_objectPath);
+    }
+
     m_displayInfo.transform.orientation = Utils::sQuatIdentify();
+    setupSceneNodes();
 
     m_window.setKeyCallback(smKeyCallback);
+    m_window.setCursorCallback(smCursorCallback);
+    m_window.setMouseButtonCallback(smMouseButtonCallback);
+    startPickBuild();
     m_window.setWindowPointer(&m_displayInfo);
     m_window.enable(false, true);
 }
 
 void Scop::start()
 {
-    float fovRadians = Utils::sRadiance();
+    constexpr float fovRadians = Utils::sRadiance();
     float boundingRadius = Utils::sBoundingBoxRadius(m_bbox);
+    // the camera backs off until the whole instance grid fits
+    if (1 < m_instanceCount)
+        boundingRadius = std::max(boundingRadius, 0.5f * std::sqrt(3.f) * instanceGridSide() * instanceSpacing());
     float distance = Utils::sDistance(boundingRadius, fovRadians) * 0.5f;
 
     s_vec3 up = {0.f, 1.f, 0.f};
     float near = 0.01f;
-    float far = 100.f;
+    float far = std::max(100.f, distance * 4.f);
 
     m_window.setClearColor(0.4f, 0.2f, 0.8f, 1.f);
     while (!m_window.shoulClose())
     {
         m_timer.update();
+        std::vector<std::string> changedFiles = m_watcher.poll();
+        updateShaderReload(changedFiles);
+        updateModelReload(changedFiles);
+        updatePicking();
         m_window.clear();
         m_window.enable(false, true);
-        m_shader.bind();
 
         m_displayInfo.transform.mvp = setupModelViewProjection(fovRadians, near, far, distance, up);
 
@@ -77,66 +170,75 @@ void Scop::start()
         
         m_displayInfo.render.blendValue = std::clamp(m_displayInfo.render.blendValue, 0.f, 1.f);
 
-        m_texture.bind();
-        m_shader.setUniform("uTexture", 0);
-        m_shader.setUniform("uMVP", m_displayInfo.transform.mvp);
-        m_shader.setUniform("uModel", m_displayInfo.transform.model);
-        m_shader.setUniform("uBlend", m_displayInfo.render.blendValue);
+        GLShader* shader = m_shaders.get(selectShaderVariant());
+        if (shader)
+            shader->bind();
+
+        m_textures.update();
+        m_textures.bind(0);
+        m_frameBlock.update(setupFrameUniforms());
+
+        updateVisibleCommands();
+        const GLMesh& mesh = m_displayInfo.render.perFace ? m_buffers.vaoFace : m_buffers.vao;
+        bool occlusion = 1 == m_instanceCount && m_displayInfo.render.occlusion;
+        // the pre-pass fills the depth buffer first, so the shading pass only runs the fragment shader once per pixel
+        GLShader* depthShader = m_shaders.get(selectShaderVariant(true));
+        bool prepass = m_depthPrepass.beginFrame(depthShader ? m_displayInfo.render.prepass : e_PrepassMode::Off);
+        GLShader* firstShader = prepass ? depthShader : shader;
+        DepthPrepass::e_Pass firstPass = prepass ? DepthPrepass::e_Pass::Depth : DepthPrepass::e_Pass::Shade;
+
+        if (firstShader)
+            firstShader->bind();
+        GLState::sColorMask(!prepass);
+        m_depthPrepass.begin(firstPass);
+        drawVisibleChunks(mesh);
+        m_depthPrepass.end();
+
+        // the boxes are tested against the depth of what was just drawn, chunks hidden last time are left to the gpu
+        if (occlusion)
+        {
+            m_occlusion.test(m_displayInfo.transform.mvp, m_visibleChunks);
+            if (firstShader)
+                firstShader->bind();
+            GLState::sColorMask(!prepass);
+            m_depthPrepass.begin(firstPass);
+            m_occlusion.drawOccluded(mesh, m_info.chunks, m_occludedChunks);
+            m_depthPrepass.end();
+        }
+
+        if (prepass)
+        {
+            // only the front most fragment of a pixel matches the pre-pass depth, everything behind it is rejected before shading
+            if (shader)
+                shader->bind();
+            GLState::sColorMask(true);
+            GLState::sDepthMask(false);
+            GLState::sDepthFunc(GL_EQUAL);
+            m_depthPrepass.begin(DepthPrepass::e_Pass::Shade);
+            drawVisibleChunks(mesh);
+            if (occlusion)
+                m_occlusion.drawOccluded(mesh, m_info.chunks, m_occludedChunks);
+            m_depthPrepass.end();
+            GLState::sDepthFunc(GL_LESS);
+            GLState::sDepthMask(true);
+        }
+        m_depthPrepass.endFrame();
+        m_frameBlock.finishFrame();
+
+#ifdef DEBUG
+        // a no-op once debug output is running, release builds never query errors per frame
+        GLDebug::sCheckErrors("frame");
+#endif
+
+        // the call counters cover one frame, glbench reads them around its own draw loops
+        GLState::sEndFrame();
 
-        if (m_displayInfo.render.perFace)
-            m_buffers.vaoFace.draw(GL_TRIANGLES, m_info.facesPerFace.size(), GL_UNSIGNED_INT);
-        else
-            m_buffers.vao.draw(GL_TRIANGLES, m_info.faces.size(), GL_UNSIGNED_INT);
-
-        GLenum err = GL_NO_ERROR;
-        while ((err = glGetError()) != GL_NO_ERROR)
-            std::cerr << "GL error: " << err << std::endl;
-        
         m_window.swapBuffers();
         GLContext::sPollEvents();
     }
-}
-
-std::vector<s_Vertex> Scop::setupShaderBufferData()
-{
-    std::vector<s_vec2> textureCoords;
-    m_texture.generateTexCoordGlobal(m_info.vertices, m_info.faces, textureCoords);
-
-    std::vector<s_vec3> normals = Utils::sComputeVertexNormals(m_info.vertices, m_info.faces);
-    
-    std::vector <s_Vertex> verticesInterLeaved;
-    verticesInterLeaved.reserve(m_info.vertices.size());
-    for (std::size_t i = 0; i < m_info.vertices.size(); ++i)
-    {
-        s_Vertex vertex;
-        vertex.position = m_info.vertices[i];
-        vertex.texCoord = textureCoords[i];
-        vertex.normal = normals[i];
-        verticesInterLeaved.push_back(vertex);
-    }
-
-    return verticesInterLeaved;
-}
-
-std::vector<s_Vertex> Scop::setupShaderBufferDataPerFace()
-{
-    std::vector<s_vec2> textCoordFace;
-    m_texture.generateTexCoordPerFace(m_info.facesPerFace, textCoordFace);
-
-    std::vector<s_vec3> normalsFace = Utils::sComputeVertexNormals(m_info.verticesPerFace, m_info.facesPerFace);
-    
-    std::vector<s_Vertex> verticesInterLeavedFace;
-    verticesInterLeavedFace.reserve(m_info.verticesPerFace.size());
-    for (std::size_t i = 0; i < m_info.verticesPerFace.size(); ++i)
-    {
-        s_Vertex vertex;
-        vertex.position = m_info.verticesPerFace[i];
-        vertex.texCoord = textCoordFace[i];
-        vertex.normal = normalsFace[i];
-        verticesInterLeavedFace.push_back(vertex);
-    }
-
-    return verticesInterLeavedFace;
+#ifdef DEBUG
+    GLDebug::sDump(std::cout);
+#endif
 }
 
 bool Scop::setupBuffersGlobal(const std::vector<s_Vertex>& vertices, const std::vector<s_VertexAttribute>& attributes)
@@ -221,6 +323,363 @@ bool Scop::setupBuffersPerFace(const std::vector<s_Vertex>& vertices, const std:
     return true;
 }
 
+bool Scop::setupInstances()
+{
+    if (!m_buffers.instances.setup())
+    {
+        std::cerr << "failed to setup instance buffer" << std::endl;
+        return false;
+    }
+    if (!uploadInstances())
+    {
+        std::cerr << "failed to set instance data" << std::endl;
+        return false;
+    }
+
+    // locations 3 to 6 advance once per instance, the same buffer feeds both meshes
+    std::vector<s_VertexAttribute> attributes;
+    for (GLuint row = 0; row < 3; ++row)
+        attributes.push_back({3 + row, 4, GL_FLOAT, GL_FALSE, sizeof(s_Instance), offsetof(s_Instance, rows) + row * sizeof(s_vec4), 1});
+    attributes.push_back({6, 4, GL_FLOAT, GL_FALSE, sizeof(s_Instance), offsetof(s_Instance, color), 1});
+
+    if (!m_buffers.vao.attachVertexBuffer(m_buffers.instances, attributes)
+        || !m_buffers.vaoFace.attachVertexBuffer(m_buffers.instances, attributes))
+    {
+        std::cerr << "failed to attach instance buffer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Scop::uploadInstances()
+{
+    // the buffer is sized for every instance, culling rewrites its front with the visible ones
+    m_instances = setupInstanceData();
+    m_instanceMatrices.resize(m_instances.size());
+    for (std::size_t i = 0; i < m_instances.size(); ++i)
+    {
+        const s_vec4* rows = m_instances[i].rows;
+        m_instanceMatrices[i] = {{
+            {rows[0].x, rows[0].y, rows[0].z, rows[0].w},
+            {rows[1].x, rows[1].y, rows[1].z, rows[1].w},
+            {rows[2].x, rows[2].y, rows[2].z, rows[2].w},
+            {0.f, 0.f, 0.f, 1.f}
+        }};
+    }
+    m_instanceBounds.resize(m_instances.size());
+    m_visibleInstances.clear();
+    m_cullStats.valid = false;
+    return m_buffers.instances.setData(m_instances, GL_DYNAMIC_DRAW);
+}
+
+bool Scop::setupDrawCommands()
+{
+    // without instances the commands come from the culling, the next updateVisibleCommands has to rebuild them
+    m_cullStats.valid = false;
+
+    // one command per object, both meshes index in the same order so they share the command list
+    std::vector<GLMultiDraw::s_Command> commands;
+    commands.reserve(m_info.objects.size());
+    for (const s_ObjectRange& object : m_info.objects)
+        commands.push_back({object.indexCount, m_instanceCount, object.firstIndex, 0, 0});
+    return m_multiDraw.setCommands(commands, GL_UNSIGNED_INT);
+}
+
+void Scop::updateVisibleCommands()
+{
+    // instances are spread around the model, the chunk bounds don't cover them so whole instances are culled instead
+    if (1 < m_instanceCount)
+    {
+        updateVisibleInstances();
+        return;
+    }
+
+    const s_mat4& mvp = m_displayInfo.transform.mvp;
+    bool occlusion = m_displayInfo.render.occlusion;
+    bool viewChanged = !m_cullStats.valid || 0 != std::memcmp(&m_cullStats.mvp, &mvp, sizeof(s_mat4));
+    if (viewChanged)
+    {
+        m_frustum.setup(mvp);
+        m_frustum.cull(m_chunkBvh, m_visibleChunks);
+        // chunks are stored in index buffer order, sorted ids give ranges that can be merged with their neighbours
+        std::sort(m_visibleChunks.begin(), m_visibleChunks.end());
+    }
+
+    // query results come in whenever the gpu is done with them, so the drawn set can change while the view stands still
+    bool resultsChanged = m_occlusion.collect();
+    if (m_cullStats.valid && occlusion != m_cullStats.occlusion)
+        m_occlusion.reset();
+    if (!viewChanged && !resultsChanged && occlusion == m_cullStats.occlusion)
+        return;
+
+    if (occlusion)
+        m_occlusion.split(m_visibleChunks, m_drawnChunks, m_occludedChunks);
+    else
+    {
+        m_drawnChunks = m_visibleChunks;
+        m_occludedChunks.clear();
+    }
+
+    std::vector<GLMultiDraw::s_Command> commands;
+    std::vector<bool> objectVisible(m_info.objects.size(), false);
+    for (unsigned int id : m_drawnChunks)
+    {
+        const s_Chunk& chunk = m_info.chunks[id];
+        objectVisible[chunk.object] = true;
+        if (!commands.empty() && commands.back().firstIndex + commands.back().count == chunk.firstIndex)
+            commands.back().count += chunk.indexCount;
+        else
+            commands.push_back({chunk.indexCount, 1, chunk.firstIndex, 0, 0});
+    }
+
+    // the command buffer is only rewritten when the set of visible ranges changed
+    bool changed = !m_cullStats.valid || commands.size() != static_cast<std::size_t>(m_multiDraw.getCommandCount())
+        || 0 != std::memcmp(commands.data(), m_cullStats.commands.data(), commands.size() * sizeof(GLMultiDraw::s_Command));
+    if (changed && !m_multiDraw.setCommands(commands, GL_UNSIGNED_INT))
+        std::cerr << "failed to update visible draw commands" << std::endl;
+
+    unsigned int visibleObjects = static_cast<unsigned int>(std::count(objectVisible.begin(), objectVisible.end(), true));
+    unsigned int visibleChunks = static_cast<unsigned int>(m_drawnChunks.size());
+    unsigned int occludedChunks = static_cast<unsigned int>(m_occludedChunks.size());
+    if (!m_cullStats.valid || visibleChunks != m_cullStats.visibleChunks || visibleObjects != m_cullStats.visibleObjects
+        || occludedChunks != m_cullStats.occludedChunks)
+    {
+        std::size_t culled = m_info.chunks.size() - m_visibleChunks.size();
+        m_window.setTitle("scop | " + std::to_string(visibleChunks) + " chunks visible, " + std::to_string(culled) + " culled, "
+            + std::to_string(occludedChunks) + " occluded | " + std::to_string(visibleObjects) + "/" + std::to_string(m_info.objects.size()) + " objects");
+    }
+
+    m_cullStats.valid = true;
+    m_cullStats.mvp = mvp;
+    m_cullStats.visibleChunks = visibleChunks;
+    m_cullStats.visibleObjects = visibleObjects;
+    m_cullStats.occlusion = occlusion;
+    m_cullStats.occludedChunks = occludedChunks;
+    m_cullStats.commands = std::move(commands);
+}
+
+void Scop::updateVisibleInstances()
+{
+    const s_mat4& mvp = m_displayInfo.transform.mvp;
+    if (m_cullStats.valid && 0 == std::memcmp(&m_cullStats.mvp, &mvp, sizeof(s_mat4)))
+        return;
+
+    // the model matrix is applied to the loaded bounds once, every instance then only adds its own matrix
+    const s_mat4& model = m_displayInfo.transform.model;
+    s_Aabb modelBox = Bounds::sTransform(model, s_Aabb{m_bbox.min, m_bbox.max});
+    s_Sphere modelSphere = Bounds::sTransform(model, m_sphere);
+    Bounds::sTransform(m_instanceMatrices.data(), m_instanceMatrices.size(), modelBox, m_instanceBounds.data(), &m_jobs);
+
+    // the sphere settles most instances with one distance per plane, only the ones it straddles are tested by box
+    m_frustum.setup(m_displayInfo.transform.viewProj);
+    std::vector<unsigned int> visible;
+    visible.reserve(m_instances.size());
+    for (unsigned int i = 0; i < m_instances.size(); ++i)
+    {
+        Frustum::e_Result result = m_frustum.test(Bounds::sTransform(m_instanceMatrices[i], modelSphere));
+        if (Frustum::e_Result::Intersect == result)
+            result = m_frustum.test(m_instanceBounds[i].min, m_instanceBounds[i].max);
+        if (Frustum::e_Result::Outside != result)
+            visible.push_back(i);
+    }
+
+    // the visible instances are packed at the front of the buffer, which only happens when the set changed
+    bool changed = !m_cullStats.valid || visible != m_visibleInstances;
+    m_cullStats.valid = true;
+    m_cullStats.mvp = mvp;
+    if (!changed)
+        return;
+
+    m_visibleInstances = std::move(visible);
+    std::vector<s_Instance> packed;
+    packed.reserve(m_visibleInstances.size());
+    for (unsigned int id : m_visibleInstances)
+        packed.push_back(m_instances[id]);
+    if (!packed.empty() && !m_buffers.instances.setSubData(packed.data(), 0, packed.size()))
+        std::cerr << "failed to update visible instances" << std::endl;
+
+    unsigned int visibleInstances = static_cast<unsigned int>(m_visibleInstances.size());
+    std::vector<GLMultiDraw::s_Command> commands;
+    commands.reserve(m_info.objects.size());
+    for (const s_ObjectRange& object : m_info.objects)
+        commands.push_back({object.indexCount, visibleInstances, object.firstIndex, 0, 0});
+    if (!m_multiDraw.setCommands(commands, GL_UNSIGNED_INT))
+        std::cerr << "failed to update instanced draw commands" << std::endl;
+
+    m_cullStats.visibleInstances = visibleInstances;
+    m_window.setTitle("scop | " + std::to_string(visibleInstances) + " of " + std::to_string(m_instanceCount) + " instances visible");
+}
+
+void Scop::drawVisibleChunks(const GLMesh& mesh) const
+{
+    // both meshes share one vertex and element buffer, the visible chunks are ranges of it drawn with one multi draw call
+    if (1 < m_instanceCount && 1 == m_multiDraw.getCommandCount())
+    {
+        GLsizei indexCount = static_cast<GLsizei>(m_displayInfo.render.perFace ? m_info.facesPerFace.size() : m_info.faces.size());
+        mesh.drawInstanced(static_cast<GLsizei>(m_cullStats.visibleInstances), GL_TRIANGLES, indexCount, GL_UNSIGNED_INT);
+    }
+    else
+        m_multiDraw.draw(mesh, GL_TRIANGLES);
+}
+
+void Scop::startPickBuild()
+{
+    // the old tree indexes the old faces, picks are refused until the new one is ready
+    m_pickBvh.reset();
+
+    // replacing a running std::async future would block until it finished, so the rebuild waits for it instead
+    if (m_pickBuild.valid())
+    {
+        m_pickBuildQueued = true;
+        return;
+    }
+
+    m_pickBuild = std::async(std::launch::async, [vertices = m_info.vertices, faces = m_info.faces]()
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_ptr<TriangleBvh> bvh = std::make_unique<TriangleBvh>();
+        if (!bvh->build(vertices, faces))
+            return std::unique_ptr<TriangleBvh>();
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[Pick] triangle bvh over " << bvh->getTriangleCount() << " triangles built in " << ms << " ms, "
+            << bvh->getNodeCount() << " nodes" << std::endl;
+        return bvh;
+    });
+}
+
+void Scop::updatePicking()
+{
+    if (m_pickBuild.valid() && std::future_status::ready == m_pickBuild.wait_for(std::chrono::seconds(0)))
+    {
+        std::unique_ptr<TriangleBvh> bvh = m_pickBuild.get();
+        if (m_pickBuildQueued)
+        {
+            m_pickBuildQueued = false;
+            startPickBuild();
+        }
+        else
+            m_pickBvh = std::move(bvh);
+    }
+
+    if (!m_displayInfo.pick.requested)
+        return;
+    m_displayInfo.pick.requested = false;
+
+    if (1 < m_instanceCount)
+    {
+        std::cout << "[Pick] picking only works without --instances" << std::endl;
+        return;
+    }
+    if (!m_pickBvh)
+    {
+        std::cout << "[Pick] the triangle bvh is still being built" << std::endl;
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // the cursor is unprojected with the inverse mvp, so the ray is already in the space the mesh was loaded in
+    int width;
+    int height;
+    m_window.getSize(width, height);
+    float x = 2.f * static_cast<float>(m_displayInfo.pick.cursorX) / std::max(width, 1) - 1.f;
+    float y = 1.f - 2.f * static_cast<float>(m_displayInfo.pick.cursorY) / std::max(height, 1);
+
+    const s_vec3 ndc[2] = {{x, y, -1.f}, {x, y, 1.f}};
+    s_vec4 unprojected[2];
+    Utils::sMat4TransformPoints(Utils::sMat4Inverse(m_displayInfo.transform.mvp), ndc, 2, unprojected);
+    s_vec3 ends[2];
+    for (int i = 0; i < 2; ++i)
+        ends[i] = {unprojected[i].x / unprojected[i].w, unprojected[i].y / unprojected[i].w, unprojected[i].z / unprojected[i].w};
+    s_vec3 origin = ends[0];
+    s_vec3 direction = Utils::sVec3Subtract(ends[1], origin);
+
+    TriangleBvh::s_Hit hit;
+    bool found = m_pickBvh->intersect(origin, direction, hit);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (!found)
+    {
+        std::cout << "[Pick] nothing under the cursor, query took " << us << " us" << std::endl;
+        return;
+    }
+
+    // the vertex with the largest barycentric weight is the one closest to the hit
+    const unsigned int* face = &m_info.faces[hit.triangle * 3];
+    float weights[3] = {1.f - hit.u - hit.v, hit.u, hit.v};
+    int nearest = static_cast<int>(std::max_element(weights, weights + 3) - weights);
+    const s_vec3& vertex = m_info.vertices[face[nearest]];
+
+    std::vector<s_ObjectRange>::const_iterator object = std::upper_bound(m_info.objects.begin(), m_info.objects.end(), hit.triangle * 3,
+        [](unsigned int index, const s_ObjectRange& range) { return index < range.firstIndex; });
+    std::string objectName = (object != m_info.objects.begin()) ? std::prev(object)->name : "";
+
+    std::cout << "[Pick] triangle " << hit.triangle << " of object '" << objectName << "', vertices "
+        << face[0] + 1 << " " << face[1] + 1 << " " << face[2] + 1 << ", nearest vertex " << face[nearest] + 1
+        << " at (" << vertex.x << ", " << vertex.y << ", " << vertex.z << "), query took " << us << " us" << std::endl;
+}
+
+std::vector<s_Instance> Scop::setupInstanceData() const
+{
+    unsigned int side = instanceGridSide();
+    float spacing = instanceSpacing();
+    float half = 0.5f * static_cast<float>(side - 1);
+
+    // a cube of copies around the model, filled layer by layer
+    std::vector<s_Instance> instances(m_instanceCount);
+    for (unsigned int i = 0; i < m_instanceCount; ++i)
+    {
+        float x = (static_cast<float>(i % side) - half) * spacing;
+        float y = (static_cast<float>((i / side) % side) - half) * spacing;
+        float z = (static_cast<float>(i / (side * side)) - half) * spacing;
+
+        s_Instance& instance = instances[i];
+        instance.rows[0] = {1.f, 0.f, 0.f, x};
+        instance.rows[1] = {0.f, 1.f, 0.f, y};
+        instance.rows[2] = {0.f, 0.f, 1.f, z};
+
+        // cheap integer hash so neighbours get clearly different tints
+        std::uint32_t hash = i * 2654435761u;
+        instance.color = {
+            0.4f + 0.6f * static_cast<float>((hash >> 8) & 0xff) / 255.f,
+            0.4f + 0.6f * static_cast<float>((hash >> 16) & 0xff) / 255.f,
+            0.4f + 0.6f * static_cast<float>((hash >> 24) & 0xff) / 255.f,
+            1.f
+        };
+    }
+    return instances;
+}
+
+unsigned int Scop::instanceGridSide() const
+{
+    unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(m_instanceCount))));
+    while (side * side * side < m_instanceCount)
+        ++side;
+    return std::max(side, 1u);
+}
+
+float Scop::instanceSpacing() const
+{
+    // the model is scaled to a fixed size, half of it again keeps neighbours from touching while they rotate
+    return 1.5f * m_bbox.scale * std::max({m_bbox.size.x, m_bbox.size.y, m_bbox.size.z});
+}
+
+void Scop::setupSceneNodes()
+{
+    // the pivot rotates and scales around the bounding box center, the model node moves the center into the pivot
+    m_scene.clear();
+    m_pivotNode = m_scene.createNode();
+    m_modelNode = m_scene.createNode(m_pivotNode);
+    placeSceneNodes();
+}
+
+void Scop::placeSceneNodes()
+{
+    m_scene.setTranslation(m_pivotNode, m_bbox.center);
+    m_scene.setScale(m_pivotNode, m_bbox.scale);
+    m_scene.setTranslation(m_modelNode, {-m_bbox.center.x, -m_bbox.center.y, -m_bbox.center.z});
+}
+
 s_mat4 Scop::setupModelViewProjection(float fovRadian, float near, float far, float distance, const s_vec3& up)
 {
     int height;
@@ -229,23 +688,235 @@ s_mat4 Scop::setupModelViewProjection(float fovRadian, float near, float far, fl
     m_window.getFrameBuffer(&width, &height);
     if (height == 0)
         height = 1;
-    float aspect = static_cast<float>(width) / static_cast<float>(height);
 
-    s_vec3 eye = {m_bbox.center.x, m_bbox.center.y, m_bbox.center.z - (distance * m_displayInfo.transform.zoomFactor)};
+    // view and projection only change with the framebuffer size or the zoom
+    bool viewChanged = width != m_viewCache.width || height != m_viewCache.height || m_displayInfo.transform.zoomFactor != m_viewCache.zoom;
+    if (viewChanged)
+    {
+        float aspect = static_cast<float>(width) / static_cast<float>(height);
+        s_vec3 eye = {m_bbox.center.x, m_bbox.center.y, m_bbox.center.z - (distance * m_displayInfo.transform.zoomFactor)};
+
+        s_mat4 view = Utils::sMat4LookAt(eye, m_bbox.center, up);
+        s_mat4 proj = Utils::sMat4Perspective(fovRadian, aspect, near, far);
+        m_displayInfo.transform.viewProj = Utils::sMat4Multiply(proj, view);
+        m_viewCache = {width, height, m_displayInfo.transform.zoomFactor};
+    }
+
+    // the rotation is the only per frame input of the graph, setRotation ignores it when it didn't change
+    m_scene.setRotation(m_pivotNode, m_displayInfo.transform.orientation);
+    if (viewChanged || 0 < m_scene.update())
+    {
+        m_displayInfo.transform.model = m_scene.getWorld(m_modelNode);
+        m_displayInfo.transform.mvp = Utils::sMat4Multiply(m_displayInfo.transform.viewProj, m_displayInfo.transform.model);
+    }
+    return m_displayInfo.transform.mvp;
+}
+
+s_FrameUniforms Scop::setupFrameUniforms()
+{
+    s_FrameUniforms frame = {};
+    frame.mvp = m_displayInfo.transform.mvp;
+    frame.model = m_displayInfo.transform.model;
+
+    s_mat4 normalMatrix = Utils::sMat4NormalMatrix(m_displayInfo.transform.model);
+    for (int row = 0; row < 3; ++row)
+        frame.normalMatrix[row] = {normalMatrix.m[row][0], normalMatrix.m[row][1], normalMatrix.m[row][2], 0.f};
+
+    frame.lightDir = {sLightDir.x, sLightDir.y, sLightDir.z, 0.f};
+    frame.blend = m_displayInfo.render.blendValue;
+    m_textures.getRegion(m_material, frame.texRect, frame.texLayer);
+    frame.viewProj = m_displayInfo.transform.viewProj;
+    return frame;
+}
+
+std::uint32_t Scop::selectShaderVariant(bool depthOnly) const
+{
+    std::uint32_t instanced = (1 < m_instanceCount) ? static_cast<std::uint32_t>(e_ShaderFeature::Instanced) : 0;
+    if (depthOnly)
+        return static_cast<std::uint32_t>(e_ShaderFeature::DepthOnly) | instanced;
+
+    // only sample and mix while the blend animation is running, the end states get a specialized program
+    if (m_displayInfo.render.blendValue <= 0.f)
+        return static_cast<std::uint32_t>(e_ShaderFeature::None) | instanced;
+    if (m_displayInfo.render.blendValue >= 1.f)
+        return static_cast<std::uint32_t>(e_ShaderFeature::Textured) | instanced;
+    return static_cast<std::uint32_t>(e_ShaderFeature::Blend) | instanced;
+}
+
+void Scop::watchShaderFiles()
+{
+    for (const std::string& file : m_shaders.getSourceFiles())
+        m_watcher.watch(file);
+}
+
+void Scop::updateShaderReload(const std::vector<std::string>& changedFiles)
+{
+    for (const std::string& changed : changedFiles)
+    {
+        for (const std::string& file : m_shaders.getSourceFiles())
+        {
+            if (changed == GLFileWatcher::sNormalize(file))
+                m_shaderReloadQueued = true;
+        }
+    }
+
+    // reading the files and resolving includes happens on a worker, only compiling and linking needs the GL thread
+    if (m_shaderReloadQueued && !m_shaderReload.valid())
+    {
+        m_shaderReloadQueued = false;
+        std::string vertexPath = m_shaders.getVertexPath();
+        std::string fragmentPath = m_shaders.getFragmentPath();
+        m_shaderReload = std::async(std::launch::async, [vertexPath, fragmentPath]()
+        {
+            std::unique_ptr<s_ShaderSources> sources = std::make_unique<s_ShaderSources>();
+            if (!GLShaderVariants::sLoadSources(vertexPath, fragmentPath, *sources))
+                sources.reset();
+            return sources;
+        });
+    }
+
+    if (!m_shaderReload.valid() || std::future_status::ready != m_shaderReload.wait_for(std::chrono::seconds(0)))
+        return;
+
+    std::unique_ptr<s_ShaderSources> sources = m_shaderReload.get();
+    if (sources && m_shaders.reload(*sources))
+    {
+        std::cout << "shaders reloaded" << std::endl;
+        watchShaderFiles();
+    }
+}
+
+void Scop::updateModelReload(const std::vector<std::string>& changedFiles)
+{
+    for (const std::string& changed : changedFiles)
+    {
+        if (changed == GLFileWatcher::sNormalize(m_objectPath))
+            m_meshReloadQueued = true;
+    }
 
-    s_mat4 view = Utils::sMat4LookAt(eye, m_bbox.center, up);
-    s_mat4 proj = Utils::sMat4Perspective(fovRadian, aspect, near, far);
+    // parsing and interleaving happens on a worker, the GL thread only uploads what changed
+    if (m_meshReloadQueued && !m_meshReload.valid())
+    {
+        m_meshReloadQueued = false;
+        m_meshReloadStart = std::chrono::steady_clock::now();
+        // the worker gets its own copy of the current order, m_info is only replaced once it is done
+        MeshLoader::s_Order order = {m_fileFaces, m_info.objects, m_info.faces, m_info.chunks};
+        m_meshReload = std::async(std::launch::async, [this, path = m_objectPath, order = std::move(order)]()
+        {
+            std::unique_ptr<s_MeshData> mesh;
+            try
+            {
+                mesh = std::make_unique<s_MeshData>(MeshLoader::sLoad(path, m_jobs, nullptr, &order));
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "failed to reload " << path << ": " << e.what() << std::endl;
+            }
+            return mesh;
+        });
+    }
 
-    s_mat4 T1 = Utils::sMat4Translate(-m_bbox.center.x, -m_bbox.center.y, -m_bbox.center.z);
-    s_mat4 T2 = Utils::sMat4Translate(m_bbox.center.x, m_bbox.center.y, m_bbox.center.z);
-    s_mat4 scale = Utils::sMat4Scale(m_bbox.scale);
+    if (!m_meshReload.valid() || std::future_status::ready != m_meshReload.wait_for(std::chrono::seconds(0)))
+        return;
 
-    s_mat4 rotation = Utils::sQuatToMat4(m_displayInfo.transform.orientation);
+    std::unique_ptr<s_MeshData> mesh = m_meshReload.get();
+    if (!mesh)
+        return;
+    if (mesh->vertices.empty() || mesh->info.faces.empty())
+    {
+        std::cerr << "reloaded object has no faces, keeping the old mesh" << std::endl;
+        return;
+    }
 
-    m_displayInfo.transform.model = Utils::sMat4Multiply(T2, Utils::sMat4Multiply(rotation, Utils::sMat4Multiply(scale, T1)));
-    s_mat4 MVP = Utils::sMat4Multiply(proj, Utils::sMat4Multiply(view, m_displayInfo.transform.model));
+    // with the same faces the loader kept the old order, so only vertex data moved and the existing storage can be patched in place
+    bool sameTopology = mesh->info.faces == m_info.faces
+        && mesh->vertices.size() == m_vertices.size()
+        && mesh->verticesPerFace.size() == m_verticesPerFace.size();
+
+    std::size_t rangeCount = 0;
+    bool uploaded = false;
+    if (sameTopology)
+    {
+        uploaded = smUploadChangedRanges(m_buffers.vbo, m_vertices, mesh->vertices, rangeCount)
+            && smUploadChangedRanges(m_buffers.vboFace, m_verticesPerFace, mesh->verticesPerFace, rangeCount);
+    }
+    else
+        uploaded = rebuildMeshBuffers(*mesh);
 
-    return MVP;
+    if (!uploaded)
+    {
+        std::cerr << "failed to upload reloaded object" << std::endl;
+        return;
+    }
+
+    m_info = std::move(mesh->info);
+    m_fileFaces = std::move(mesh->fileFaces);
+    m_chunkBvh = std::move(mesh->chunkBvh);
+    m_bbox = mesh->bbox;
+    m_sphere = mesh->sphere;
+    m_vertices = std::move(mesh->vertices);
+    m_verticesPerFace = std::move(mesh->verticesPerFace);
+
+    if (!setupDrawCommands())
+        std::cerr << "failed to update draw commands" << std::endl;
+    if (1 == m_instanceCount && !m_occlusion.setChunks(m_info.chunks))
+        std::cerr << "failed to update occlusion boxes" << std::endl;
+    startPickBuild();
+    placeSceneNodes();
+    m_viewCache = {};
+
+    // the grid spacing follows the size of the model
+    if (1 < m_instanceCount && !uploadInstances())
+        std::cerr << "failed to update instance data" << std::endl;
+
+    double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_meshReloadStart).count();
+    if (sameTopology)
+        std::cout << "object reloaded in " << latency << " ms, " << rangeCount << " changed vertex ranges uploaded" << std::endl;
+    else
+        std::cout << "object reloaded in " << latency << " ms, topology changed so all buffers were respecified" << std::endl;
+}
+
+bool Scop::rebuildMeshBuffers(const s_MeshData& mesh)
+{
+    // the buffer names stay the same, so the vertex attribute setup of the vaos remains valid
+    if (!m_buffers.vbo.setData(mesh.vertices, GL_STATIC_DRAW)
+        || !m_buffers.ebo.setData(mesh.info.faces, GL_STATIC_DRAW)
+        || !m_buffers.vboFace.setData(mesh.verticesPerFace, GL_STATIC_DRAW)
+        || !m_buffers.eboFace.setData(mesh.info.facesPerFace, GL_STATIC_DRAW))
+        return false;
+
+    return m_buffers.vao.attachElementBuffer(m_buffers.ebo)
+        && m_buffers.vaoFace.attachElementBuffer(m_buffers.eboFace);
+}
+
+bool Scop::smUploadChangedRanges(GLBuffer& buffer, const std::vector<s_Vertex>& current, const std::vector<s_Vertex>& next, std::size_t& rangeCount)
+{
+    // changed vertices a few apart are sent as one range, one bigger copy is cheaper then many small calls
+    const std::size_t mergeGap = 8;
+
+    std::size_t i = 0;
+    while (i < next.size())
+    {
+        if (0 == std::memcmp(&current[i], &next[i], sizeof(s_Vertex)))
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t first = i;
+        std::size_t last = i;
+        for (++i; i < next.size() && i - last <= mergeGap; ++i)
+        {
+            if (0 != std::memcmp(&current[i], &next[i], sizeof(s_Vertex)))
+                last = i;
+        }
+
+        if (!buffer.setSubData(next.data() + first, first, last - first + 1))
+            return false;
+        ++rangeCount;
+        i = last + 1;
+    }
+    return true;
 }
 
 void Scop::smKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/)
@@ -257,38 +928,14 @@ void Scop::smKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int acti
     if (!dInfo)
         return;
 
-    s_vec3 axisX = {1.f, 0.f, 0.f};
-    s_vec3 axisY = {0.f, 1.f, 0.f};
-    s_vec3 axisZ = {0.f, 0.f, 1.f};
+    for (const auto& keyRotation : sKeyRotations)
+    {
+        if (keyRotation.key == key)
+            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, keyRotation.rotation);
+    }
 
-    const float angleStep = 0.01f;
-    s_quat q = {};
     switch (key)
     {
-        case GLFW_KEY_W: // up
-            q = Utils::sQuatFromAxisAngle(axisX, angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
-         case GLFW_KEY_S: //down
-            q = Utils::sQuatFromAxisAngle(axisX, -angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
-        case GLFW_KEY_D: // right
-            q = Utils::sQuatFromAxisAngle(axisY, angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
-        case GLFW_KEY_A: // left
-            q = Utils::sQuatFromAxisAngle(axisY, -angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
-        case GLFW_KEY_Q: // rotate left
-            q = Utils::sQuatFromAxisAngle(axisZ, -angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
-        case GLFW_KEY_E: //rotate right
-            q = Utils::sQuatFromAxisAngle(axisZ, angleStep);
-            dInfo->transform.orientation = Utils::sQuatMultiply(dInfo->transform.orientation, q);
-            break;
         case GLFW_KEY_R: // reset
             dInfo->transform.orientation = Utils::sQuatIdentify();
             break;
@@ -307,6 +954,43 @@ void Scop::smKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int acti
         case GLFW_KEY_F:
             dInfo->render.perFace = !dInfo->render.perFace;
             break;
+        case GLFW_KEY_P: // depth pre-pass auto/on/off
+            if (GLFW_PRESS != action)
+                break;
+            if (e_PrepassMode::Auto == dInfo->render.prepass)
+                dInfo->render.prepass = e_PrepassMode::On;
+            else if (e_PrepassMode::On == dInfo->render.prepass)
+                dInfo->render.prepass = e_PrepassMode::Off;
+            else
+                dInfo->render.prepass = e_PrepassMode::Auto;
+            break;
+        case GLFW_KEY_O: // occlusion culling on/off
+            if (GLFW_PRESS == action)
+                dInfo->render.occlusion = !dInfo->render.occlusion;
+            break;
     }
     dInfo->transform.orientation = Utils::sQuatNormalize(dInfo->transform.orientation);
+}
+
+void Scop::smCursorCallback(GLFWwindow* window, double x, double y)
+{
+    s_DisplayInfo* dInfo = static_cast<s_DisplayInfo*>(glfwGetWindowUserPointer(window));
+    if (!dInfo)
+        return;
+
+    dInfo->pick.cursorX = x;
+    dInfo->pick.cursorY = y;
+}
+
+void Scop::smMouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*/)
+{
+    if (GLFW_MOUSE_BUTTON_LEFT != button || GLFW_PRESS != action)
+        return;
+
+    s_DisplayInfo* dInfo = static_cast<s_DisplayInfo*>(glfwGetWindowUserPointer(window));
+    if (!dInfo)
+        return;
+
+    // picking needs the gl thread state, the render loop answers it before the next frame
+    dInfo->pick.requested = true;
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "TriangleBvh.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool TriangleBvh::build(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& faces)
+{
+    m_nodes.clear();
+    m_triangles.clear();
+    std::size_t triangleCount = faces.size() / 3;
+    if (0 == triangleCount)
+        return false;
+
+    std::vector<s_Aabb> bounds(triangleCount);
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        const s_vec3& a = vertices[faces[i * 3]];
+        const s_vec3& b = vertices[faces[i * 3 + 1]];
+        const s_vec3& c = vertices[faces[i * 3 + 2]];
+        bounds[i].min = {std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}), std::min({a.z, b.z, c.z})};
+        bounds[i].max = {std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}), std::max({a.z, b.z, c.z})};
+    }
+
+    Bvh binary;
+    binary.build(bounds, 4);
+    bounds.clear();
+    bounds.shrink_to_fit();
+
+    // leaves own contiguous runs of the index list, so the triangles are stored in that order
+    const std::vector<unsigned int>& order = binary.getIndices();
+    m_triangles.reserve(order.size());
+    for (unsigned int id : order)
+    {
+        const s_vec3& a = vertices[faces[id * 3]];
+        const s_vec3& b = vertices[faces[id * 3 + 1]];
+        const s_vec3& c = vertices[faces[id * 3 + 2]];
+        m_triangles.push_back({a, Utils::sVec3Subtract(b, a), Utils::sVec3Subtract(c, a), id});
+    }
+
+    m_nodes.reserve(binary.getNodes().size() / 2 + 1);
+    collapse(binary, 0);
+    return true;
+}
+
+bool TriangleBvh::intersect(const s_vec3& origin, const s_vec3& direction, s_Hit& hit) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    hit.t = std::numeric_limits<float>::max();
+    bool found = false;
+
+    // a huge finite value instead of inf, 0 * inf on a slab touching the origin would give nan
+    auto inverse = [](float d) { return (std::fabs(d) > 1e-30f) ? 1.f / d : std::copysign(1e30f, d); };
+    s_vec3 inv = {inverse(direction.x), inverse(direction.y), inverse(direction.z)};
+
+    Simd::t_Float4 ox = Simd::sSplat(origin.x);
+    Simd::t_Float4 oy = Simd::sSplat(origin.y);
+    Simd::t_Float4 oz = Simd::sSplat(origin.z);
+    Simd::t_Float4 ix = Simd::sSplat(inv.x);
+    Simd::t_Float4 iy = Simd::sSplat(inv.y);
+    Simd::t_Float4 iz = Simd::sSplat(inv.z);
+
+    std::vector<unsigned int> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const s_Node4& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        alignas(16) float entry[4];
+        // slab test of the ray against all four child boxes at once
+        Simd::t_Float4 x1 = Simd::sMul(Simd::sSub(Simd::sLoad(node.minX), ox), ix);
+        Simd::t_Float4 x2 = Simd::sMul(Simd::sSub(Simd::sLoad(node.maxX), ox), ix);
+        Simd::t_Float4 y1 = Simd::sMul(Simd::sSub(Simd::sLoad(node.minY), oy), iy);
+        Simd::t_Float4 y2 = Simd::sMul(Simd::sSub(Simd::sLoad(node.maxY), oy), iy);
+        Simd::t_Float4 z1 = Simd::sMul(Simd::sSub(Simd::sLoad(node.minZ), oz), iz);
+        Simd::t_Float4 z2 = Simd::sMul(Simd::sSub(Simd::sLoad(node.maxZ), oz), iz);
+
+        Simd::t_Float4 tNear = Simd::sMax(Simd::sMax(Simd::sMin(x1, x2), Simd::sMin(y1, y2)), Simd::sMax(Simd::sMin(z1, z2), Simd::sSplat(0.f)));
+        Simd::t_Float4 tFar = Simd::sMin(Simd::sMin(Simd::sMax(x1, x2), Simd::sMax(y1, y2)), Simd::sMin(Simd::sMax(z1, z2), Simd::sSplat(hit.t)));
+        int mask = Simd::sLessEqualMask(tNear, tFar);
+        Simd::sStore(entry, tNear);
+        if (0 == mask)
+            continue;
+
+        // leaves are tested right away, inner children are pushed far to near so the nearest one is visited first
+        int order[4];
+        int inner = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (!(mask & (1 << i)) || sEmpty == node.child[i])
+                continue;
+            if (0 == node.count[i])
+            {
+                order[inner++] = i;
+                continue;
+            }
+            for (unsigned int t = node.child[i]; t < node.child[i] + node.count[i]; ++t)
+            {
+                if (sIntersectTriangle(m_triangles[t], origin, direction, hit))
+                    found = true;
+            }
+        }
+        // at most four entries, an insertion sort is all it takes
+        for (int i = 1; i < inner; ++i)
+        {
+            int child = order[i];
+            int j = i;
+            for (; 0 < j && entry[order[j - 1]] < entry[child]; --j)
+                order[j] = order[j - 1];
+            order[j] = child;
+        }
+        for (int i = 0; i < inner; ++i)
+            stack.push_back(node.child[order[i]]);
+    }
+    return found;
+}
+
+std::size_t TriangleBvh::getTriangleCount() const
+{
+    return m_triangles.size();
+}
+
+std::size_t TriangleBvh::getNodeCount() const
+{
+    return m_nodes.size();
+}
+
+bool TriangleBvh::empty() const
+{
+    return m_nodes.empty();
+}
+
+unsigned int TriangleBvh::collapse(const Bvh& bvh, unsigned int binaryNode)
+{
+    const std::vector<Bvh::s_Node>& nodes = bvh.getNodes();
+
+    // open the inner child with the largest box until there are four children or only leaves are left
+    std::vector<unsigned int> children;
+    if (0 < nodes[binaryNode].count)
+        children.push_back(binaryNode);
+    else
+        children = {nodes[binaryNode].leftFirst, nodes[binaryNode].leftFirst + 1};
+    while (children.size() < 4)
+    {
+        int widest = -1;
+        float widestArea = -1.f;
+        for (std::size_t i = 0; i < children.size(); ++i)
+        {
+            const Bvh::s_Node& child = nodes[children[i]];
+            if (0 < child.count)
+                continue;
+            s_vec3 size = Utils::sVec3Subtract(child.max, child.min);
+            float area = size.x * size.y + size.y * size.z + size.z * size.x;
+            if (area > widestArea)
+            {
+                widestArea = area;
+                widest = static_cast<int>(i);
+            }
+        }
+        if (0 > widest)
+            break;
+        unsigned int opened = children[widest];
+        children[widest] = nodes[opened].leftFirst;
+        children.push_back(nodes[opened].leftFirst + 1);
+    }
+
+    unsigned int index = static_cast<unsigned int>(m_nodes.size());
+    m_nodes.push_back({});
+    s_Node4 node;
+    const float inf = std::numeric_limits<float>::max();
+    for (int i = 0; i < 4; ++i)
+    {
+        // unused slots are skipped through their sEmpty child before their box is looked at
+        node.minX[i] = inf;
+        node.minY[i] = inf;
+        node.minZ[i] = inf;
+        node.maxX[i] = -inf;
+        node.maxY[i] = -inf;
+        node.maxZ[i] = -inf;
+        node.child[i] = sEmpty;
+        node.count[i] = 0;
+    }
+
+    for (std::size_t i = 0; i < children.size(); ++i)
+    {
+        const Bvh::s_Node& child = nodes[children[i]];
+        node.minX[i] = child.min.x;
+        node.minY[i] = child.min.y;
+        node.minZ[i] = child.min.z;
+        node.maxX[i] = child.max.x;
+        node.maxY[i] = child.max.y;
+        node.maxZ[i] = child.max.z;
+        node.count[i] = child.count;
+        node.child[i] = (0 < child.count) ? child.leftFirst : collapse(bvh, children[i]);
+    }
+    m_nodes[index] = node;
+    return index;
+}
+
+bool TriangleBvh::sIntersectTriangle(const s_Triangle& triangle, const s_vec3& origin, const s_vec3& direction, s_Hit& hit)
+{
+    // Moeller-Trumbore, both sides of the triangle count as a hit
+    s_vec3 p = Utils::sVec3Cross(direction, triangle.edge2);
+    float det = Utils::sVec3Dot(triangle.edge1, p);
+    if (std::fabs(det) < 1e-12f)
+        return false;
+    float invDet = 1.f / det;
+
+    s_vec3 s = Utils::sVec3Subtract(origin, triangle.v0);
+    float u = Utils::sVec3Dot(s, p) * invDet;
+    if (u < 0.f || u > 1.f)
+        return false;
+
+    s_vec3 q = Utils::sVec3Cross(s, triangle.edge1);
+    float v = Utils::sVec3Dot(direction, q) * invDet;
+    if (v < 0.f || u + v > 1.f)
+        return false;
+
+    float t = Utils::sVec3Dot(triangle.edge2, q) * invDet;
+    if (t < 0.f || t >= hit.t)
+        return false;
+
+    hit = {t, triangle.id, u, v};
+    return true;
+}
\ No newline at end of file
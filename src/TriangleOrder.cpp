@@ -0,0 +1,305 @@
+#include "TriangleOrder.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+void TriangleOrder::sOptimize(s_InputFileLines& info, unsigned int cacheSize, float cacheThreshold, JobSystem* jobs)
+{
+    cacheSize = std::max(cacheSize, 3u);
+
+    // the sort keys of an object's clusters and chunks are measured from its center
+    std::vector<s_vec3> centers;
+    centers.reserve(info.objects.size());
+    for (const s_ObjectRange& object : info.objects)
+        centers.push_back(sCenter(info, &info.faces[object.firstIndex], object.indexCount / 3));
+
+    // chunks are small enough that their vertices get local ids, which keeps the adjacency arrays dense. Every chunk
+    // only rewrites its own index range, so they are ordered in parallel
+    JobSystem::sParallelFor(jobs, info.chunks.size(), sChunkGrain, [&](std::size_t begin, std::size_t end)
+    {
+        std::vector<unsigned int> local;
+        std::vector<unsigned int> vertices;
+        std::vector<unsigned int> order;
+        std::vector<unsigned int> boundaries;
+        std::vector<unsigned int> sorted;
+        for (std::size_t chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+        {
+            const s_Chunk& chunk = info.chunks[chunkIndex];
+            const s_vec3& center = centers[chunk.object];
+            unsigned int* indices = &info.faces[chunk.firstIndex];
+            float inputRatio = sCacheMissRatio(indices, chunk.indexCount, cacheSize);
+            vertices.assign(indices, indices + chunk.indexCount);
+            std::sort(vertices.begin(), vertices.end());
+            vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+            local.resize(chunk.indexCount);
+            for (unsigned int i = 0; i < chunk.indexCount; ++i)
+                local[i] = static_cast<unsigned int>(std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin());
+
+            sTipsify(local, static_cast<unsigned int>(vertices.size()), cacheSize, order, boundaries);
+
+            // a cut costs a cold cache, it is only made where the piece before it already reuses better than the chunk as a whole
+            std::vector<unsigned int> reordered;
+            reordered.reserve(chunk.indexCount);
+            for (unsigned int triangle : order)
+                reordered.insert(reordered.end(), &local[triangle * 3], &local[triangle * 3] + 3);
+            float missRatio = sCacheMissRatio(reordered.data(), reordered.size(), cacheSize);
+            sSplitClusters(local, order, cacheSize, missRatio * cacheThreshold, boundaries);
+
+            // clusters on the outside of the object that face outwards occlude the rest from most directions, they go first
+            std::vector<float> keys(boundaries.size() - 1);
+            for (std::size_t cluster = 0; cluster + 1 < boundaries.size(); ++cluster)
+            {
+                sorted.clear();
+                for (unsigned int i = boundaries[cluster]; i < boundaries[cluster + 1]; ++i)
+                    sorted.insert(sorted.end(), &indices[order[i] * 3], &indices[order[i] * 3] + 3);
+                keys[cluster] = sOverdrawKey(info, sorted.data(), sorted.size() / 3, center);
+            }
+            std::vector<unsigned int> clusters(keys.size());
+            std::iota(clusters.begin(), clusters.end(), 0u);
+            std::stable_sort(clusters.begin(), clusters.end(), [&keys](unsigned int l, unsigned int r) { return keys[l] > keys[r]; });
+
+            sorted.clear();
+            for (unsigned int cluster : clusters)
+            {
+                for (unsigned int i = boundaries[cluster]; i < boundaries[cluster + 1]; ++i)
+                    sorted.insert(sorted.end(), &indices[order[i] * 3], &indices[order[i] * 3] + 3);
+            }
+
+            // every cut the sort makes starts on a cold cache, when that undoes what Tipsify won the chunk keeps its input order
+            if (sCacheMissRatio(sorted.data(), sorted.size(), cacheSize) < inputRatio)
+                std::copy(sorted.begin(), sorted.end(), indices);
+        }
+    });
+
+    // the same order one level up: chunks stay whole ranges of their object, only their sequence changes
+    std::vector<float> chunkKeys(info.chunks.size());
+    JobSystem::sParallelFor(jobs, info.chunks.size(), sChunkGrain, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const s_Chunk& chunk = info.chunks[i];
+            chunkKeys[i] = sOverdrawKey(info, &info.faces[chunk.firstIndex], chunk.indexCount / 3, centers[chunk.object]);
+        }
+    });
+    std::vector<unsigned int> chunkOrder(info.chunks.size());
+    std::iota(chunkOrder.begin(), chunkOrder.end(), 0u);
+    std::stable_sort(chunkOrder.begin(), chunkOrder.end(), [&info, &chunkKeys](unsigned int l, unsigned int r)
+    {
+        if (info.chunks[l].object != info.chunks[r].object)
+            return info.chunks[l].object < info.chunks[r].object;
+        return chunkKeys[l] > chunkKeys[r];
+    });
+
+    std::vector<unsigned int> faces;
+    std::vector<s_Chunk> chunks;
+    faces.reserve(info.faces.size());
+    chunks.reserve(info.chunks.size());
+    for (unsigned int id : chunkOrder)
+    {
+        s_Chunk chunk = info.chunks[id];
+        faces.insert(faces.end(), info.faces.begin() + chunk.firstIndex, info.faces.begin() + chunk.firstIndex + chunk.indexCount);
+        chunk.firstIndex = static_cast<unsigned int>(faces.size() - chunk.indexCount);
+        chunks.push_back(chunk);
+    }
+    info.faces = std::move(faces);
+    info.chunks = std::move(chunks);
+
+}
+
+float TriangleOrder::sCacheMissRatio(const unsigned int* indices, std::size_t indexCount, unsigned int cacheSize)
+{
+    // average cache miss ratio: vertices transformed per triangle with a fifo cache, 3 is no reuse at all
+    if (3 > indexCount || 0 == cacheSize)
+        return 0.f;
+
+    std::vector<unsigned int> fifo(cacheSize, 0xffffffffu);
+    std::size_t next = 0;
+    std::size_t misses = 0;
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        if (fifo.end() != std::find(fifo.begin(), fifo.end(), indices[i]))
+            continue;
+        fifo[next] = indices[i];
+        next = (next + 1) % cacheSize;
+        ++misses;
+    }
+    return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+}
+
+void TriangleOrder::sTipsify(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize,
+    std::vector<unsigned int>& order, std::vector<unsigned int>& boundaries)
+{
+    unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    order.clear();
+    boundaries.assign(1, 0);
+    if (0 == triangleCount)
+        return;
+
+    // triangles around every vertex, as offsets into one array
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int vertex : indices)
+        ++offsets[vertex + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<int> live(vertexCount);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+        live[vertex] = static_cast<int>(offsets[vertex + 1] - offsets[vertex]);
+
+    // a vertex is in the fifo while time minus its stamp is at most the cache size
+    std::vector<int> stamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    int time = static_cast<int>(cacheSize) + 1;
+    int cache = static_cast<int>(cacheSize);
+    unsigned int cursor = 0;
+    int fanning = static_cast<int>(indices[0]);
+
+    while (0 <= fanning)
+    {
+        candidates.clear();
+        for (unsigned int i = offsets[fanning]; i < offsets[fanning + 1]; ++i)
+        {
+            unsigned int triangle = adjacency[i];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = true;
+            order.push_back(triangle);
+            for (unsigned int corner = 0; corner < 3; ++corner)
+            {
+                unsigned int vertex = indices[triangle * 3 + corner];
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - stamps[vertex] > cache)
+                    stamps[vertex] = time++;
+            }
+        }
+
+        // the next fan is around the candidate that stays in the cache the longest while its remaining triangles come in
+        fanning = -1;
+        int bestPriority = -1;
+        for (unsigned int vertex : candidates)
+        {
+            if (0 >= live[vertex])
+                continue;
+            int priority = 0;
+            if (time - stamps[vertex] + 2 * live[vertex] <= cache)
+                priority = time - stamps[vertex];
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanning = static_cast<int>(vertex);
+            }
+        }
+        if (0 <= fanning)
+            continue;
+
+        // dead end: recently used vertices are tried first, then the first vertex with triangles left
+        if (order.size() < triangleCount)
+            boundaries.push_back(static_cast<unsigned int>(order.size()));
+        while (!deadEnd.empty() && 0 > fanning)
+        {
+            unsigned int vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (0 < live[vertex])
+                fanning = static_cast<int>(vertex);
+        }
+        while (0 > fanning && cursor < vertexCount)
+        {
+            if (0 < live[cursor])
+                fanning = static_cast<int>(cursor);
+            ++cursor;
+        }
+    }
+}
+
+void TriangleOrder::sSplitClusters(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& order, unsigned int cacheSize,
+    float maxMissRatio, std::vector<unsigned int>& boundaries)
+{
+    // tipsify cuts where it ran into a dead end, inside those runs a cut goes where the run so far is already cheap enough
+    std::vector<unsigned int> hard = boundaries;
+    hard.push_back(static_cast<unsigned int>(order.size()));
+    boundaries.assign(1, 0);
+
+    std::vector<unsigned int> fifo(cacheSize);
+    for (std::size_t run = 0; run + 1 < hard.size(); ++run)
+    {
+        std::fill(fifo.begin(), fifo.end(), 0xffffffffu);
+        std::size_t next = 0;
+        std::size_t misses = 0;
+        unsigned int start = hard[run];
+        for (unsigned int i = hard[run]; i < hard[run + 1]; ++i)
+        {
+            for (unsigned int corner = 0; corner < 3; ++corner)
+            {
+                unsigned int vertex = indices[order[i] * 3 + corner];
+                if (fifo.end() != std::find(fifo.begin(), fifo.end(), vertex))
+                    continue;
+                fifo[next] = vertex;
+                next = (next + 1) % cacheSize;
+                ++misses;
+            }
+
+            unsigned int count = i + 1 - start;
+            if (sMinClusterTriangles <= count && i + 1 < hard[run + 1]
+                && static_cast<float>(misses) <= maxMissRatio * static_cast<float>(count))
+            {
+                boundaries.push_back(i + 1);
+                std::fill(fifo.begin(), fifo.end(), 0xffffffffu);
+                misses = 0;
+                start = i + 1;
+            }
+        }
+        if (hard[run + 1] < order.size())
+            boundaries.push_back(hard[run + 1]);
+    }
+    boundaries.push_back(static_cast<unsigned int>(order.size()));
+}
+
+float TriangleOrder::sOverdrawKey(const s_InputFileLines& info, const unsigned int* indices, std::size_t triangleCount, const s_vec3& center)
+{
+    // area weighted centroid and normal of the triangles, the key is how far the centroid lies in front of the center
+    // along that normal. It is the view independent sort key of Sander et al.
+    s_vec3 centroid = sCenter(info, indices, triangleCount);
+    s_vec3 normal = {0.f, 0.f, 0.f};
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        const s_vec3& a = info.vertices[indices[i * 3]];
+        const s_vec3& b = info.vertices[indices[i * 3 + 1]];
+        const s_vec3& c = info.vertices[indices[i * 3 + 2]];
+        normal = Utils::sVec3Add(normal, Utils::sVec3Cross(Utils::sVec3Subtract(b, a), Utils::sVec3Subtract(c, a)));
+    }
+    return Utils::sVec3Dot(Utils::sVec3Subtract(centroid, center), Utils::sVec3Normalize(normal));
+}
+
+s_vec3 TriangleOrder::sCenter(const s_InputFileLines& info, const unsigned int* indices, std::size_t triangleCount)
+{
+    // area weighted, degenerate triangles alone fall back to the plain average
+    s_vec3 weighted = {0.f, 0.f, 0.f};
+    s_vec3 plain = {0.f, 0.f, 0.f};
+    float area = 0.f;
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        const s_vec3& a = info.vertices[indices[i * 3]];
+        const s_vec3& b = info.vertices[indices[i * 3 + 1]];
+        const s_vec3& c = info.vertices[indices[i * 3 + 2]];
+        s_vec3 centroid = {(a.x + b.x + c.x) / 3.f, (a.y + b.y + c.y) / 3.f, (a.z + b.z + c.z) / 3.f};
+        s_vec3 cross = Utils::sVec3Cross(Utils::sVec3Subtract(b, a), Utils::sVec3Subtract(c, a));
+        float weight = std::sqrt(Utils::sVec3Dot(cross, cross));
+        weighted = {weighted.x + centroid.x * weight, weighted.y + centroid.y * weight, weighted.z + centroid.z * weight};
+        plain = Utils::sVec3Add(plain, centroid);
+        area += weight;
+    }
+    if (0 == triangleCount)
+        return plain;
+    if (0.f < area)
+        return {weighted.x / area, weighted.y / area, weighted.z / area};
+    float inverse = 1.f / static_cast<float>(triangleCount);
+    return {plain.x * inverse, plain.y * inverse, plain.z * inverse};
+}
\ No newline at end of file
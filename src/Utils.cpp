@@ -1,4 +1,5 @@
 #include "Utils.hpp"
+#include "TriangleOrder.hpp"
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
@@ -7,321 +8,220 @@
 #include <string>
 #include <sstream>
 
-s_vec3 Utils::sVec3Normalize(const s_vec3& v)
+// the constexpr math is checked while compiling, a wrong result stops the build
+static constexpr bool sNear(float a, float b, float epsilon = 1e-5f)
 {
-    float len = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
-    if (len < 1e-6f)
-        return {0.f, 0.f, 0.f};
-    return { v.x / len, v.y / len, v.z / len};
+    return Utils::sAbs(a - b) <= epsilon;
 }
 
-std::vector<s_vec3> Utils::sComputeVertexNormals
-(
-    const std::vector<s_vec3>& vertices,
-    const std::vector<unsigned int>& indices
-)
+static constexpr bool sNear(const s_mat4& a, const s_mat4& b, float epsilon = 1e-5f)
 {
-    std::vector<s_vec3> normal(vertices.size(), {0.f, 0.f, 0.f});
-
-    for (std::size_t i = 0; i < indices.size(); i += 3)
+    for (int row = 0; row < 4; ++row)
     {
-        unsigned int i0 = indices[i];
-        unsigned int i1 = indices[i + 1];
-        unsigned int i2 = indices[i + 2];
-
-        s_vec3 v0 = vertices[i0];
-        s_vec3 v1 = vertices[i1];
-        s_vec3 v2 = vertices[i2];
-
-        // Calulate the normal of the face
-        s_vec3 edge1 = sVec3Subtract(v1, v0);
-        s_vec3 edge2 = sVec3Subtract(v2, v0);
-
-        s_vec3 faceNormal = sVec3Normalize(sVec3Cross(edge1, edge2));
-
-        // Accumulate the face normal into each vertex normal
-        normal[i0] = sVec3Add(normal[i0], faceNormal);
-        normal[i1] = sVec3Add(normal[i1], faceNormal);
-        normal[i2] = sVec3Add(normal[i2], faceNormal);
+        for (int col = 0; col < 4; ++col)
+        {
+            if (!sNear(a.m[row][col], b.m[row][col], epsilon))
+                return false;
+        }
     }
-
-    // Normalize each normal
-    for (s_vec3& n : normal)
-        n = sVec3Normalize(n);
-    
-    return normal;
+    return true;
 }
 
-s_quat Utils::sQuatIdentify()
+static constexpr s_vec4 sTransform(const s_mat4& mat, const s_vec3& point)
 {
-    s_quat q = {};
-    q.w = 1.f;
-    q.x = 0.f;
-    q.y = 0.f;
-    q.z = 0.f;
-    return q;
+    s_vec4 out = {};
+    Utils::sMat4TransformPoints(mat, &point, 1, &out);
+    return out;
 }
 
-s_quat Utils::sQuatNormalize(const s_quat& q)
-{
-    float len = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
-    s_quat result = q;
-    if (len > 0.f)
-    {
-        result.w /= len;
-        result.x /= len;
-        result.y /= len;
-        result.z /= len;
-    }
-    return result;
-}
+static_assert(4.f == Utils::sSqrt(16.f) && 0.f == Utils::sSqrt(0.f) && sNear(Utils::sSqrt(2.f), 1.41421356f));
+static_assert(sNear(Utils::sSin(Utils::sPi<float> / 6.f), 0.5f) && sNear(Utils::sSin(-3.5f * Utils::sPi<float>), 1.f));
+static_assert(sNear(Utils::sCos(Utils::sPi<float> / 3.f), 0.5f) && sNear(Utils::sTan(Utils::sPi<float> / 4.f), 1.f));
+static_assert(static_cast<float>(Utils::sPi<double> / 6.0) == Utils::sRadiance());
+static_assert(sNear(Utils::sVec3Dot(Utils::sVec3Normalize({3.f, 0.f, 4.f}), {0.6f, 0.f, 0.8f}), 1.f));
+static_assert(sNear(Utils::sMat4Multiply(Utils::sMat4Translate(1.f, 2.f, 3.f), Utils::sMat4Translate(-1.f, -2.f, -3.f)), Utils::sMat4Identify()));
+
+// two turns of a quarter around x are half a turn, and the product of two quaternions rotates like the product of
+// their matrices
+static_assert(sNear(
+    Utils::sQuatToMat4(Utils::sQuatMultiply(Utils::sQuatFromAxisAngle({1.f, 0.f, 0.f}, 0.5f * Utils::sPi<float>), Utils::sQuatFromAxisAngle({1.f, 0.f, 0.f}, 0.5f * Utils::sPi<float>))),
+    Utils::sQuatToMat4(Utils::sQuatFromAxisAngle({1.f, 0.f, 0.f}, Utils::sPi<float>))));
+static_assert(sNear(
+    Utils::sQuatToMat4(Utils::sQuatMultiply(Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, 0.3f), Utils::sQuatFromAxisAngle({0.f, 0.f, 1.f}, 1.1f))),
+    Utils::sMat4Multiply(Utils::sQuatToMat4(Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, 0.3f)), Utils::sQuatToMat4(Utils::sQuatFromAxisAngle({0.f, 0.f, 1.f}, 1.1f)))));
+static_assert(sNear(Utils::sQuatNormalize({2.f, 0.f, 0.f, 0.f}).w, 1.f));
+
+static constexpr s_mat4 sTestModel = Utils::sMat4Multiply(Utils::sMat4Translate(1.f, -2.f, 0.5f),
+    Utils::sMat4Multiply(Utils::sQuatToMat4(Utils::sQuatFromAxisAngle(Utils::sVec3Normalize({1.f, 1.f, 0.f}), 0.7f)), Utils::sMat4Scale(2.f)));
+static_assert(sNear(Utils::sMat4Multiply(Utils::sMat4Inverse(sTestModel), sTestModel), Utils::sMat4Identify()));
+static_assert(sNear(Utils::sMat4NormalMatrix(Utils::sMat4Scale(2.f)).m[1][1], 0.5f));
+static_assert(sNear(sTransform(sTestModel, {0.f, 0.f, 0.f}).y, -2.f) && sNear(sTransform(sTestModel, {0.f, 0.f, 0.f}).w, 1.f));
+
+// the eye looks down -z in view space and a point on the near plane lands on ndc depth -1
+static_assert(sNear(sTransform(Utils::sMat4LookAt({0.f, 0.f, -3.f}, {0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}), {0.f, 0.f, 0.f}).z, -3.f));
+static_assert(sNear(sTransform(Utils::sMat4Perspective(1.f, 1.f, 0.5f, 10.f), {0.f, 0.f, -0.5f}).z / sTransform(Utils::sMat4Perspective(1.f, 1.f, 0.5f, 10.f), {0.f, 0.f, -0.5f}).w, -1.f));
+static_assert(0.5f == Utils::sComputeBoundingBoxAndScale({{-1.f, 0.f, 0.f}, {1.f, 1.f, 0.f}, {0.f, 0.5f, 0.5f}}).scale);
+static_assert(1.f == Utils::sComputeBoundingBoxAndScale({}).scale && 0.f == Utils::sComputeBoundingBoxAndScale({}).size.x);
+static_assert(1.f == Utils::sComputeBoundingBoxAndScale({{2.f, 3.f, 4.f}}).scale);
 
-s_BoundingBox Utils::sComputeBoundingBoxAndScale(const std::vector<s_vec3>& vertices)
+std::vector<s_vec3> Utils::sComputeVertexNormals
+(
+    const std::vector<s_vec3>& vertices,
+    const std::vector<unsigned int>& indices,
+    JobSystem* jobs
+)
 {
-    s_vec3 min = vertices[0];
-    s_vec3 max = vertices[0];
+    static const std::size_t sGrain = 1 << 14;
 
-    for (const s_vec3& v : vertices)
+    // the face normals are independent, only their sum into shared vertices has to stay in one thread and in order
+    std::size_t triangleCount = indices.size() / 3;
+    std::vector<s_vec3> faceNormals(triangleCount);
+    JobSystem::sParallelFor(jobs, triangleCount, sGrain, [&](std::size_t begin, std::size_t end)
     {
-        min.x = std::min(min.x, v.x);
-        min.y = std::min(min.y, v.y);
-        min.z = std::min(min.z, v.z);
+        for (std::size_t triangle = begin; triangle < end; ++triangle)
+        {
+            const s_vec3& v0 = vertices[indices[triangle * 3]];
+            const s_vec3& v1 = vertices[indices[triangle * 3 + 1]];
+            const s_vec3& v2 = vertices[indices[triangle * 3 + 2]];
+
+            // Calulate the normal of the face
+            s_vec3 edge1 = sVec3Subtract(v1, v0);
+            s_vec3 edge2 = sVec3Subtract(v2, v0);
+            faceNormals[triangle] = sVec3Normalize(sVec3Cross(edge1, edge2));
+        }
+    });
 
-        max.x = std::max(max.x, v.x);
-        max.y = std::max(max.y, v.y);
-        max.z = std::max(max.z, v.z);
+    // Accumulate the face normal into each vertex normal
+    std::vector<s_vec3> normal(vertices.size(), {0.f, 0.f, 0.f});
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        const s_vec3& faceNormal = faceNormals[i / 3];
+        normal[indices[i]] = sVec3Add(normal[indices[i]], faceNormal);
+        normal[indices[i + 1]] = sVec3Add(normal[indices[i + 1]], faceNormal);
+        normal[indices[i + 2]] = sVec3Add(normal[indices[i + 2]], faceNormal);
     }
 
-    s_vec3 center = {
-        (min.x + max.x) * 0.5f,
-        (min.y + max.y) * 0.5f,
-        (min.z + max.z) * 0.5f
-    };
-
-    s_vec3 size = {max.x - min.x, max.y - min.y, max.z - min.z};
-    float maxDim = std::max({size.x, size.y, size.z});
-
-    float desiredSize = 1.f;
-    float scale = desiredSize / maxDim;
-
-    return { min, max, center, size, scale };
-}
-
-float Utils::sBoundingBoxRadius(const s_BoundingBox& bbox)
-{
-    return 0.5f * bbox.scale * 
-        std::sqrt(bbox.size.x * bbox.size.x +
-            bbox.size.y * bbox.size.y +
-            bbox.size.z * bbox.size.z);
-}
-
-s_quat Utils::sQuatMultiply(const s_quat& a, const s_quat& b)
-{
-    return {
-        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
-        a.w * b.x + a.x * b.w + a.y * b.z + a.z * b.y,
-        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
-        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
-    };
-}
-
-s_quat Utils::sQuatFromAxisAngle(const s_vec3& axis, float angleRad)
-{
-    float halfAngle = angleRad * 0.5f;
-    float sinHalfAngle = std::sin(halfAngle);
-    return {
-        std::cos(halfAngle),
-        axis.x * sinHalfAngle,
-        axis.y * sinHalfAngle,
-        axis.z * sinHalfAngle
-    };
-}
-
-void Utils::sMat4ToArray(const s_mat4& mat, float* out)
-{
-    for (int col = 0; col < 4; ++col)
+    // Normalize each normal
+    JobSystem::sParallelFor(jobs, normal.size(), sGrain, [&normal](std::size_t begin, std::size_t end)
     {
-        for (int row = 0; row < 4; ++row)
-            out[col * 4 + row] = mat.m[row][col];
-    }
+        for (std::size_t i = begin; i < end; ++i)
+            normal[i] = sVec3Normalize(normal[i]);
+    });
+    return normal;
 }
 
-float Utils::sDistance(float boundingRadius, float fovRadius)
+std::string Utils::sResolveInputPath(const char* path)
 {
-    return boundingRadius / std::tan(fovRadius / 3.f);
-}
+    if (!path)
+        throw std::runtime_error("path cannot be empty");
 
-float Utils::sRadiance()
-{
-    return M_PI / 6.f;
+    // objects can be given relative to the resources folder as well
+    std::string filePath(path);
+    if (!std::filesystem::exists(filePath) && std::filesystem::exists("resources/" + filePath))
+        return "resources/" + filePath;
+    return filePath;
 }
 
-s_mat4 Utils::sMat4Multiply(const s_mat4& a, const s_mat4& b)
+void Utils::sBuildChunks(s_InputFileLines& info, unsigned int maxTriangles)
 {
-    s_mat4 result = {};
+    info.chunks.clear();
+    std::vector<unsigned int> reordered;
+    reordered.reserve(info.faces.size());
+    maxTriangles = std::max(maxTriangles, 1u);
 
-    for (int row = 0; row < 4; ++row)
+    // objects stay in order and keep their index ranges, only the triangles inside each one are regrouped
+    for (unsigned int objectIndex = 0; objectIndex < info.objects.size(); ++objectIndex)
     {
-        for (int col = 0; col < 4; ++col)
+        const s_ObjectRange& object = info.objects[objectIndex];
+        unsigned int firstTriangle = object.firstIndex / 3;
+        unsigned int triangleCount = object.indexCount / 3;
+
+        std::vector<unsigned int> triangles(triangleCount);
+        std::vector<s_vec3> centroids(triangleCount);
+        for (unsigned int i = 0; i < triangleCount; ++i)
         {
-            result.m[row][col] = 0.f;
-            for (int k = 0; k < 4; ++k)
-                result.m[row][col] += a.m[row][k] * b.m[k][col];
+            const unsigned int* face = &info.faces[(firstTriangle + i) * 3];
+            const s_vec3& a = info.vertices[face[0]];
+            const s_vec3& b = info.vertices[face[1]];
+            const s_vec3& c = info.vertices[face[2]];
+            triangles[i] = i;
+            centroids[i] = {(a.x + b.x + c.x) / 3.f, (a.y + b.y + c.y) / 3.f, (a.z + b.z + c.z) / 3.f};
         }
-    }
-    return result;
-}
-
-s_mat4 Utils::sMat4Perspective(float fovRadian, float aspact, float near, float far)
-{
-    s_mat4 result = {};
-    float localLength = 1.f / std::tan(fovRadian / 2.f);
-    result.m[0][0] = localLength / aspact;
-    result.m[1][1] = localLength;
-    result.m[2][2] = (far + near) / (near - far);
-    result.m[2][3] = (2.f * far * near) / (near - far);
-    result.m[3][2] = -1.f;
-    result.m[3][3] = 0.f;
-
-    return result;
-}
-
-s_mat4 Utils::sMat4LookAt(const s_vec3& eye, const s_vec3& center, const s_vec3& worldUp)
-{
-    s_vec3 forward = sVec3Normalize(sVec3Subtract(center, eye));
-    s_vec3 side = sVec3Normalize(sVec3Cross(forward, worldUp));
-    s_vec3 camUp = sVec3Normalize(sVec3Cross(side, forward));
-
-    s_mat4 result = sMat4Identify();
-    result.m[0][0] = side.x;
-    result.m[0][1] = side.y;
-    result.m[0][2] = side.z;
-
-    result.m[1][0] = camUp.x;
-    result.m[1][1] = camUp.y;
-    result.m[1][2] = camUp.z;
 
-    result.m[2][0] = -forward.x;
-    result.m[2][1] = -forward.y;
-    result.m[2][2] = -forward.z;
-
-    result.m[0][3] = -sVec3Dot(side, eye);
-    result.m[1][3] = -sVec3Dot(camUp, eye);
-    result.m[2][3] = sVec3Dot(forward, eye);
-
-    return result;
-}
-
-s_mat4 Utils::sMat4Scale(float s)
-{
-    s_mat4 result = {};
-
-    result.m[0][0] = s;
-    result.m[1][1] = s;
-    result.m[2][2] = s;
-    result.m[3][3] = 1.f;
-
-    return result;
-}
-
-s_mat4 Utils::sMat4Translate(float tx, float ty, float tz)
-{
-    s_mat4 mat = sMat4Identify();
-
-    mat.m[0][3] = tx;
-    mat.m[1][3] = ty;
-    mat.m[2][3] = tz;
-
-    return mat;
-}
-
-s_mat4 Utils::sQuatToMat4(const s_quat& q)
-{
-    s_mat4 mat = sMat4Identify();
-
-    mat.m[0][0] = 1.f - 2.f * q.y * q.y - 2.f * q.z * q.z; // 1 - 2*y^2 - 2*z^2
-    mat.m[0][1] = 2.f * q.x * q.y - 2.f * q.w * q.z; // 2*x*y - 2*w*z
-    mat.m[0][2] = 2.f * q.x * q.z + 2.f * q.w * q.y; // 2*x*z + 2*w*y
-    mat.m[0][3] = 0.f;
-
-    mat.m[1][0] = 2.f * q.x * q.y + 2.f * q.w *q.z; // 2*x*y + 2*w*z
-    mat.m[1][1] = 1.f - 2.f * q.x * q.x - 2.f * q.z * q.z; // 1 - 2*2^2 - 2*z^2
-    mat.m[1][2] = 2.f * q.y * q.z - 2.f * q.w * q.x; // 2*y*z - 2*w*x
-    mat.m[1][3] = 0.f;
-
-    mat.m[2][0] = 2.f * q.x * q.z - 2.f * q.w * q.y; // 2*x*z - 2*w*y
-    mat.m[2][1] = 2.f * q.y * q.z + 2.f * q.w * q.x; // 2*y*z + 2*w*x
-    mat.m[2][2] = 1.f - 2.f * q.x * q.x - 2.f * q.y * q.y; // 1 - 2*x^2 - 2*y^2
-    mat.m[2][3] = 0.f;
+        // median splits along the longest centroid axis until a run is small enough, the first half is finished first
+        std::vector<std::pair<unsigned int, unsigned int>> stack = {{0, triangleCount}};
+        while (!stack.empty())
+        {
+            auto [begin, end] = stack.back();
+            stack.pop_back();
 
-    mat.m[3][0] = 0.f;
-    mat.m[3][1] = 0.f;
-    mat.m[3][2] = 0.f;
-    mat.m[3][3] = 1.f;
+            if (end - begin > maxTriangles)
+            {
+                s_vec3 low = centroids[triangles[begin]];
+                s_vec3 high = low;
+                for (unsigned int i = begin + 1; i < end; ++i)
+                {
+                    const s_vec3& p = centroids[triangles[i]];
+                    low = {std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z)};
+                    high = {std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z)};
+                }
+                s_vec3 extent = sVec3Subtract(high, low);
+                int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+                unsigned int middle = begin + (end - begin) / 2;
+                std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                    [&centroids, axis](unsigned int l, unsigned int r)
+                    {
+                        return (&centroids[l].x)[axis] < (&centroids[r].x)[axis];
+                    });
+                stack.push_back({middle, end});
+                stack.push_back({begin, middle});
+                continue;
+            }
 
-    return mat;
+            // the split scrambles the triangles, inside a chunk they go back to file order and keep its vertex reuse
+            std::sort(triangles.begin() + begin, triangles.begin() + end);
+            s_Chunk chunk = {static_cast<unsigned int>(reordered.size()), (end - begin) * 3, objectIndex, {}};
+            chunk.bounds.min = info.vertices[info.faces[(firstTriangle + triangles[begin]) * 3]];
+            chunk.bounds.max = chunk.bounds.min;
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                for (unsigned int corner = 0; corner < 3; ++corner)
+                {
+                    unsigned int vertexIndex = info.faces[(firstTriangle + triangles[i]) * 3 + corner];
+                    const s_vec3& v = info.vertices[vertexIndex];
+                    chunk.bounds.min = {std::min(chunk.bounds.min.x, v.x), std::min(chunk.bounds.min.y, v.y), std::min(chunk.bounds.min.z, v.z)};
+                    chunk.bounds.max = {std::max(chunk.bounds.max.x, v.x), std::max(chunk.bounds.max.y, v.y), std::max(chunk.bounds.max.z, v.z)};
+                    reordered.push_back(vertexIndex);
+                }
+            }
+            info.chunks.push_back(chunk);
+        }
+    }
+    info.faces = std::move(reordered);
 }
 
-s_mat4 Utils::sMat4Identify()
+s_InputFileLines Utils::sParseInput(const char* path, JobSystem* jobs)
 {
-    s_mat4 result = {};
-
-    for (int i = 0; i < 4; ++ i)
-        result.m[i][i] = 1.f;
+    s_InputFileLines result = sReadObj(path, jobs);
+    // reorders the faces, so it has to happen before the per face vertices are laid out in face order
+    sBuildChunks(result);
+    TriangleOrder::sOptimize(result, 16, 0.75f, jobs);
+    sLayoutPerFace(result);
     return result;
 }
 
-s_vec3 Utils::sVec3Subtract(const s_vec3& a, const s_vec3& b)
+// parses the lines of one slice of the file, face indices are absolute so only the objects' first index depends on the slices before
+static void sReadObjLines(const char* begin, const char* end, s_InputFileLines& result)
 {
-    return {a.x - b.x, a.y - b.y, a.z - b.z};
-}
-
-s_vec3 Utils::sVec3Add(const s_vec3& a, const s_vec3& b)
-{
-    return {a.x + b.x, a.y + b.y, a.z + b.z};
-}
-
-s_vec3 Utils::sVec3Cross(const s_vec3& a, const s_vec3& b)
-{
-    return {
-        a.y * b.z - a.z * b.y,
-        a.z * b.x - a.x * b.z,
-        a.x * b.y - a.y * b.x
-    };
-}
-
-float Utils::sVec3Dot(const s_vec3& a, const s_vec3& b)
-{
-    return a.x * b.x + a.y * b.y + a.z * b.z;
-}
-
-s_InputFileLines Utils::sParseInput(const char* path)
-{
-    if (!path)
-        throw std::runtime_error("path cannot be empty");
-
-    std::filesystem::path filePath(path);
-    if (".obj" != filePath.extension())
-        throw std::runtime_error("file needs to be a .obj");
-
-    std::ifstream fstream(path);
-    if (!fstream)
-    {
-        std::string fileString = "resources/" + static_cast<std::string>(path);
-        fstream.open(fileString);
-        if (!fstream)
-            throw std::runtime_error("File not found");
-    }
-
-    s_InputFileLines result;
-
     std::string line;
-    result.faces.reserve(3000);
-    result.facesPerFace.reserve(3000);
-    result.vertices.reserve(3000);
-    result.verticesPerFace.reserve(3000);
-    while (std::getline(fstream, line))
+    std::vector<unsigned int> faceIndices;
+    while (begin < end)
     {
+        const char* lineEnd = std::find(begin, end, '\n');
+        line.assign(begin, lineEnd);
+        begin = (lineEnd == end) ? end : lineEnd + 1;
+
         if (0 == line.rfind("v ", 0))
         {
             float x, y, z;
@@ -334,8 +234,7 @@ s_InputFileLines Utils::sParseInput(const char* path)
         }
         else if (0 == line.rfind("f ", 0))
         {
-            std::vector<unsigned int> faceIndices;
-            faceIndices.reserve(3000);
+            faceIndices.clear();
             unsigned int id;
             std::stringstream ss(line);
             std::string token;
@@ -350,23 +249,99 @@ s_InputFileLines Utils::sParseInput(const char* path)
                 result.faces.emplace_back(faceIndices[i + 1]);
             }
         }
+        else if (0 == line.rfind("o ", 0) || 0 == line.rfind("g ", 0))
+        {
+            // every o or g line starts a new object, its faces run until the next one
+            result.objects.push_back({line.substr(2), static_cast<unsigned int>(result.faces.size()), 0});
+        }
+    }
+}
+
+s_InputFileLines Utils::sReadObj(const char* path, JobSystem* jobs)
+{
+    if (!path)
+        throw std::runtime_error("path cannot be empty");
+
+    std::filesystem::path filePath(path);
+    if (".obj" != filePath.extension())
+        throw std::runtime_error("file needs to be a .obj");
+
+    std::ifstream fstream(sResolveInputPath(path), std::ios::binary | std::ios::ate);
+    if (!fstream)
+        throw std::runtime_error("File not found");
+
+    std::string data(static_cast<std::size_t>(fstream.tellg()), '\0');
+    fstream.seekg(0);
+    if (!fstream.read(data.data(), static_cast<std::streamsize>(data.size())))
+        throw std::runtime_error("could not read file");
+
+    // the slices end on line breaks, so every line is parsed by exactly one of them
+    static const std::size_t sSliceBytes = 1 << 20;
+    std::vector<std::size_t> sliceStarts = {0};
+    for (std::size_t start = sSliceBytes; start < data.size(); start = sliceStarts.back() + sSliceBytes)
+    {
+        std::size_t lineStart = data.find('\n', start);
+        if (std::string::npos == lineStart)
+            break;
+        sliceStarts.push_back(lineStart + 1);
     }
+    sliceStarts.push_back(data.size());
 
-    for (std::size_t i = 0; i < result.faces.size(); i += 3)
+    std::vector<s_InputFileLines> slices(sliceStarts.size() - 1);
+    JobSystem::sParallelFor(jobs, slices.size(), 1, [&](std::size_t begin, std::size_t end)
     {
-        for (int j = 0; j < 3; ++j)
-        {
-            unsigned int vertexIndex = result.faces[i + j];
-            s_vec3 vertex = result.vertices[vertexIndex];
+        for (std::size_t i = begin; i < end; ++i)
+            sReadObjLines(data.data() + sliceStarts[i], data.data() + sliceStarts[i + 1], slices[i]);
+    });
 
-            result.verticesPerFace.emplace_back(vertex);
+    s_InputFileLines result;
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    for (const s_InputFileLines& slice : slices)
+    {
+        vertexCount += slice.vertices.size();
+        indexCount += slice.faces.size();
+    }
+    result.vertices.reserve(vertexCount);
+    result.faces.reserve(indexCount);
+    for (s_InputFileLines& slice : slices)
+    {
+        unsigned int first = static_cast<unsigned int>(result.faces.size());
+        for (s_ObjectRange& object : slice.objects)
+            result.objects.push_back({std::move(object.name), first + object.firstIndex, 0});
+        result.vertices.insert(result.vertices.end(), slice.vertices.begin(), slice.vertices.end());
+        result.faces.insert(result.faces.end(), slice.faces.begin(), slice.faces.end());
+    }
 
-            result.facesPerFace.emplace_back(static_cast<unsigned int>(result.facesPerFace.size()));
-        }
+    // an object's faces run until the next object starts, faces before the first o or g line, or a file without any, form one unnamed object
+    unsigned int faceCount = static_cast<unsigned int>(result.faces.size());
+    for (std::size_t i = 0; i < result.objects.size(); ++i)
+    {
+        unsigned int next = (i + 1 < result.objects.size()) ? result.objects[i + 1].firstIndex : faceCount;
+        result.objects[i].indexCount = next - result.objects[i].firstIndex;
     }
+    if (result.objects.empty() || 0 != result.objects.front().firstIndex)
+    {
+        unsigned int count = result.objects.empty() ? faceCount : result.objects.front().firstIndex;
+        result.objects.insert(result.objects.begin(), {"default", 0, count});
+    }
+    std::erase_if(result.objects, [](const s_ObjectRange& object) { return 0 == object.indexCount; });
 
     if (0 == result.vertices.size() || 0 == result.faces.size())
         throw std::runtime_error("no vertices or faces found in file");
 
     return result;
+}
+
+void Utils::sLayoutPerFace(s_InputFileLines& info)
+{
+    info.verticesPerFace.clear();
+    info.facesPerFace.clear();
+    info.verticesPerFace.reserve(info.faces.size());
+    info.facesPerFace.reserve(info.faces.size());
+    for (unsigned int vertexIndex : info.faces)
+    {
+        info.verticesPerFace.emplace_back(info.vertices[vertexIndex]);
+        info.facesPerFace.emplace_back(static_cast<unsigned int>(info.facesPerFace.size()));
+    }
 }
\ No newline at end of file
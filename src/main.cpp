@@ -1,18 +1,56 @@
 #include <glad/glad.h>
 #include "Scop.hpp"
+#include <cstdlib>
 #include <iostream>
+#include <string>
+
+// reads the count after an option, false when it is missing, not a number or outside [1, max]
+static bool sReadCount(const char* text, unsigned long max, unsigned long& count)
+{
+    char* end = nullptr;
+    count = std::strtoul(text, &end, 10);
+    return end != text && !*end && 0 < count && count <= max;
+}
 
 int main(int argc, char* argv[])
 {
-    if (2 != argc)
+    if (2 > argc || 0 != argc % 2)
     {
-        std::cout << "to start use program like this\n ./scop NAME.obj" << std::endl;
+        std::cout << "to start use program like this\n ./scop NAME.obj [--instances N] [--threads N]" << std::endl;
         return 1;
     }
 
+    unsigned long instances = 1;
+    unsigned long threads = 0;
+    for (int i = 2; i < argc; i += 2)
+    {
+        std::string option(argv[i]);
+        if ("--instances" == option)
+        {
+            if (!sReadCount(argv[i + 1], 1000000, instances))
+            {
+                std::cerr << "--instances expects a count between 1 and 1000000" << std::endl;
+                return 1;
+            }
+        }
+        else if ("--threads" == option)
+        {
+            if (!sReadCount(argv[i + 1], 256, threads))
+            {
+                std::cerr << "--threads expects a count between 1 and 256" << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "unknown option " << option << ", use --instances N or --threads N" << std::endl;
+            return 1;
+        }
+    }
+
     try
     {
-        Scop scop(argv[1]);
+        Scop scop(argv[1], static_cast<unsigned int>(instances), static_cast<unsigned int>(threads));
         scop.start();
         return 0;
     }
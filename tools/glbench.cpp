@@ -0,0 +1,918 @@
+#include <glad/glad.h>
+#include "GLBuffer.hpp"
+#include "GLContext.hpp"
+#include "GLMesh.hpp"
+#include "GLMultiDraw.hpp"
+#include "GLQuery.hpp"
+#include "GLShader.hpp"
+#include "GLShaderVariants.hpp"
+#include "GLState.hpp"
+#include "GLTexture.hpp"
+#include "GLTextureContainer.hpp"
+#include "GLUniformBlock.hpp"
+#include "GLUtils.hpp"
+#include "GLWindow.hpp"
+#include "Frustum.hpp"
+#include "DepthPrepass.hpp"
+#include "OcclusionCuller.hpp"
+#include "JobSystem.hpp"
+#include "MeshLoader.hpp"
+#include "Scop.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// the wrapper timings that need a context: every kernel is run a few times on a hidden window and the best run counts
+
+static const char* sVertexSource = R"(#version 410 core
+layout(location = 0) in vec3 aPos;
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+uniform vec4 uTint;
+uniform float uTime;
+uniform int uMode;
+out vec4 vColor;
+void main()
+{
+    vColor = uTint * (0 == uMode ? 1.0 : fract(uTime));
+    gl_Position = uViewProj * uModel * vec4(aPos, 1.0);
+}
+)";
+
+static const char* sFragmentSource = R"(#version 410 core
+in vec4 vColor;
+out vec4 fragColor;
+void main()
+{
+    fragColor = vColor;
+}
+)";
+
+// scop's own programs and FrameData block, so the scene sections draw exactly what scop draws
+struct s_Renderer
+{
+    GLShaderVariants shaders;
+    GLUniformBlock frameBlock;
+};
+
+// a model read by scop's loader and uploaded with its vertex layout
+struct s_Scene
+{
+    s_MeshData mesh;
+    GLBuffer vbo = GLBuffer(GLBuffer::e_Type::Array);
+    GLBuffer ebo = GLBuffer(GLBuffer::e_Type::Element);
+    GLMesh vao;
+};
+
+// best of a few runs in nanoseconds per item, the gl queue is drained before and after so every run pays for its own work
+static double timeGl(const std::function<void()>& kernel, std::size_t items)
+{
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run)
+    {
+        glFinish();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        kernel();
+        glFinish();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / static_cast<double>(items));
+    }
+    return best;
+}
+
+// best of a few runs of the cpu time spent issuing the calls, the gpu work is finished outside the timed part
+static double timeSubmit(const std::function<void()>& kernel, std::size_t items)
+{
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run)
+    {
+        glFinish();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        kernel();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        glFinish();
+        best = std::min(best, ns / static_cast<double>(items));
+    }
+    return best;
+}
+
+static void report(const char* name, double ns, const std::string& note)
+{
+    std::printf("%-22s %10.1f ns  %s\n", name, ns, note.c_str());
+}
+
+static std::string ratio(double before, double after)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "x%.2f", before / after);
+    return text;
+}
+
+// the five uniforms of one draw, set through the name lookup and through handles resolved once after linking
+static void benchUniforms()
+{
+    GLShader shader;
+    if (!shader.setupFromSource(sVertexSource, sFragmentSource))
+    {
+        std::cerr << "glbench: failed to build the uniform shader" << std::endl;
+        return;
+    }
+    shader.bind();
+
+    const std::size_t draws = 1 << 16;
+    s_mat4 model = {{{1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, 0.f}, {0.f, 0.f, 0.f, 1.f}}};
+    s_vec4 tint = {1.f, 0.5f, 0.25f, 1.f};
+    double byName = timeGl([&]()
+    {
+        for (std::size_t i = 0; i < draws; ++i)
+        {
+            model.m[0][3] = static_cast<float>(i);
+            shader.setUniform("uModel", model);
+            shader.setUniform("uViewProj", model);
+            shader.setUniform("uTint", tint);
+            shader.setUniform("uTime", static_cast<float>(i));
+            shader.setUniform("uMode", static_cast<int>(i & 1));
+        }
+    }, draws * 5);
+
+    GLUniform<s_mat4> modelUniform = shader.getUniform<s_mat4>("uModel");
+    GLUniform<s_mat4> viewProjUniform = shader.getUniform<s_mat4>("uViewProj");
+    GLUniform<s_vec4> tintUniform = shader.getUniform<s_vec4>("uTint");
+    GLUniform<float> timeUniform = shader.getUniform<float>("uTime");
+    GLUniform<int> modeUniform = shader.getUniform<int>("uMode");
+    double byHandle = timeGl([&]()
+    {
+        for (std::size_t i = 0; i < draws; ++i)
+        {
+            model.m[0][3] = static_cast<float>(i);
+            shader.setUniform(modelUniform, model);
+            shader.setUniform(viewProjUniform, model);
+            shader.setUniform(tintUniform, tint);
+            shader.setUniform(timeUniform, static_cast<float>(i));
+            shader.setUniform(modeUniform, static_cast<int>(i & 1));
+        }
+    }, draws * 5);
+
+    std::printf("uniforms, %zu draws of 5 uniforms\n", draws);
+    report("setUniform by name", byName, "per uniform");
+    report("setUniform by handle", byHandle, "per uniform, " + ratio(byName, byHandle));
+    shader.unbind();
+}
+
+static bool setupRenderer(s_Renderer& renderer)
+{
+    renderer.shaders.setBinaryCacheDir(".cache/shaders");
+    renderer.shaders.addUniformBlock("FrameData", renderer.frameBlock.getBindingPoint());
+    renderer.shaders.addSampler("uTextures", 0);
+    std::uint32_t instanced = static_cast<std::uint32_t>(e_ShaderFeature::Instanced);
+    return renderer.frameBlock.setup(sizeof(s_FrameUniforms))
+        && renderer.shaders.setup("shaders/vertex/source.vert", "shaders/fragment/source.frag", {"FEATURE_TEXTURED", "FEATURE_BLEND", "FEATURE_INSTANCED", "FEATURE_DEPTH_ONLY"})
+        && renderer.shaders.prebuild({static_cast<std::uint32_t>(e_ShaderFeature::None), instanced});
+}
+
+static bool loadScene(const std::string& path, JobSystem& jobs, s_Scene& scene)
+{
+    try
+    {
+        scene.mesh = MeshLoader::sLoad(path, jobs);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "glbench: " << e.what() << std::endl;
+        return false;
+    }
+
+    std::vector<s_VertexAttribute> attributes = {
+        {0, 3, GL_FLOAT, GL_FALSE, sizeof(s_Vertex), offsetof(s_Vertex, position)},
+        {1, 2, GL_FLOAT, GL_FALSE, sizeof(s_Vertex), offsetof(s_Vertex, texCoord)},
+        {2, 3, GL_FLOAT, GL_FALSE, sizeof(s_Vertex), offsetof(s_Vertex, normal)}
+    };
+    return scene.vbo.setup() && scene.ebo.setup() && scene.vao.setup()
+        && scene.vbo.setData(scene.mesh.vertices) && scene.ebo.setData(scene.mesh.info.faces)
+        && scene.vao.attachVertexBuffer(scene.vbo, attributes) && scene.vao.attachElementBuffer(scene.ebo);
+}
+
+// the uniforms of a camera at eye looking at center on the square bench window, the model stays where it was loaded
+static s_FrameUniforms frameUniforms(const s_vec3& eye, const s_vec3& center, float far)
+{
+    s_FrameUniforms frame = {};
+    frame.viewProj = Utils::sMat4Multiply(Utils::sMat4Perspective(Utils::sRadiance(), 1.f, 0.1f, far), Utils::sMat4LookAt(eye, center, {0.f, 1.f, 0.f}));
+    frame.model = Utils::sMat4Identify();
+    frame.mvp = frame.viewProj;
+    for (int row = 0; row < 3; ++row)
+        frame.normalMatrix[row] = {row == 0 ? 1.f : 0.f, row == 1 ? 1.f : 0.f, row == 2 ? 1.f : 0.f, 0.f};
+    frame.lightDir = {0.f, 0.f, 1.f, 0.f};
+    frame.texRect = {0.f, 0.f, 1.f, 1.f};
+    return frame;
+}
+
+// scop's program built with no cache, into an empty binary cache and from that cache like every start after the first.
+// Its includes are resolved once up front, so only the compile, link and cache work is timed
+static void benchProgramCache()
+{
+    const std::string vertexPath = "shaders/vertex/source.vert";
+    s_ShaderSources sources;
+    if (!GLShaderVariants::sLoadSources(vertexPath, "shaders/fragment/source.frag", sources))
+    {
+        std::cerr << "glbench: failed to read " << vertexPath << ", run from the repository root" << std::endl;
+        return;
+    }
+
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "glbench_shaders";
+    std::filesystem::remove_all(cacheDir);
+    bool built = true;
+    // the driver keeps its own cache of compiled sources, across runs too, a comment that changes every build keeps it from answering
+    std::size_t tag = static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    auto build = [&](bool cached, std::size_t source)
+    {
+        std::string comment = "\n// glbench " + std::to_string(source) + "\n";
+        GLShader shader;
+        if (cached)
+            shader.setBinaryCacheDir(cacheDir.string());
+        built = built && shader.setupFromSource(sources.vertex + comment, sources.fragment + comment);
+    };
+
+    double plain = timeGl([&]() { build(false, ++tag); }, 1);
+    double cold = timeGl([&]()
+    {
+        std::filesystem::remove_all(cacheDir);
+        build(true, ++tag);
+    }, 1);
+    bool written = std::filesystem::exists(cacheDir) && !std::filesystem::is_empty(cacheDir);
+    double warm = timeGl([&]() { build(true, tag); }, 1);
+    std::filesystem::remove_all(cacheDir);
+    if (!built)
+    {
+        std::cerr << "glbench: failed to build " << vertexPath << std::endl;
+        return;
+    }
+
+    std::printf("program cache, %s\n", vertexPath.c_str());
+    std::printf("%-22s %10.3f ms  compile and link\n", "no cache", plain * 1e-6);
+    std::printf("%-22s %10.3f ms  compile, link and write the binary\n", "cold cache", cold * 1e-6);
+    std::printf("%-22s %10.3f ms  %s\n", "warm cache", warm * 1e-6, written ? ("restored from the binary, " + ratio(plain, warm)).c_str() : "the driver has no binary formats, compiled again");
+}
+
+// one draw per object of a material sorted scene: every draw asks for its program, vertex array, texture and depth state,
+// which only change every 64 draws. The same calls go straight to gl for the comparison, the shadow state is reset after
+static void benchStateCache()
+{
+    GLShader shaders[2];
+    for (GLShader& shader : shaders)
+    {
+        if (!shader.setupFromSource(sVertexSource, sFragmentSource))
+        {
+            std::cerr << "glbench: failed to build the state cache shaders" << std::endl;
+            return;
+        }
+    }
+
+    const s_vec3 corners[8] = {{-1.f, -1.f, -1.f}, {1.f, -1.f, -1.f}, {-1.f, 1.f, -1.f}, {1.f, 1.f, -1.f},
+        {-1.f, -1.f, 1.f}, {1.f, -1.f, 1.f}, {-1.f, 1.f, 1.f}, {1.f, 1.f, 1.f}};
+    std::vector<s_vec3> vertices(corners, corners + 8);
+    std::vector<unsigned int> indices = {0, 4, 6, 0, 6, 2, 5, 1, 3, 5, 3, 7, 0, 1, 5, 0, 5, 4, 6, 7, 3, 6, 3, 2, 1, 0, 2, 1, 2, 3, 4, 5, 7, 4, 7, 6};
+    GLBuffer vbo(GLBuffer::e_Type::Array);
+    GLBuffer ebo(GLBuffer::e_Type::Element);
+    GLMesh meshes[2];
+    std::vector<s_VertexAttribute> attributes = {{0, 3, GL_FLOAT, GL_FALSE, sizeof(s_vec3), 0}};
+    if (!vbo.setup() || !ebo.setup() || !vbo.setData(vertices) || !ebo.setData(indices))
+        return;
+    for (GLMesh& mesh : meshes)
+    {
+        if (!mesh.setup() || !mesh.attachVertexBuffer(vbo, attributes) || !mesh.attachElementBuffer(ebo))
+            return;
+    }
+
+    GLTexture::s_Image white;
+    white.width = 4;
+    white.height = 4;
+    white.channels = 4;
+    white.pixels.assign(4 * 4 * 4, 255);
+    GLTexture textures[2];
+    for (GLTexture& texture : textures)
+        texture.loadFromImage(white);
+
+    const std::size_t draws = 1 << 14;
+    GLState::sInvalidate();
+    GLState::sEndFrame();
+    double cached = timeGl([&]()
+    {
+        for (std::size_t i = 0; i < draws; ++i)
+        {
+            std::size_t material = (i >> 6) & 1;
+            shaders[material].bind();
+            GLState::sEnable(GL_DEPTH_TEST);
+            GLState::sDepthFunc(GL_LESS);
+            textures[material].bind(0);
+            meshes[(i >> 7) & 1].draw();
+        }
+    }, draws);
+    GLState::s_CallStats calls = GLState::sEndFrame();
+
+    double direct = timeGl([&]()
+    {
+        for (std::size_t i = 0; i < draws; ++i)
+        {
+            std::size_t material = (i >> 6) & 1;
+            glUseProgram(shaders[material].getProgramId());
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LESS);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, textures[material].getTextureId());
+            glBindVertexArray(meshes[(i >> 7) & 1].getVertextArrayObject());
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+        }
+    }, draws);
+    GLState::sInvalidate();
+
+    std::printf("state cache, %zu draws switching material every 64 and mesh every 128\n", draws);
+    // the counters ran over all 5 timed runs
+    char note[96];
+    std::snprintf(note, sizeof(note), "per draw, %.2f of %.2f calls issued, ", calls.issued / (5.0 * draws), calls.requested / (5.0 * draws));
+    report("gl calls direct", direct, "per draw, every call issued");
+    report("gl calls through GLState", cached, note + ratio(direct, cached));
+}
+
+// the bmp scop shipped with, decoded with its mips built at load time, against the same image baked by texbake into an RGBA8
+// and a BC1 container whose levels are uploaded as they are
+static void benchTextureLoads()
+{
+    const std::string path = "textures/nyan.bmp";
+    GLTexture::s_Image image;
+    if (!GLTexture::sDecode(path, image))
+    {
+        std::cerr << "glbench: failed to decode " << path << ", run from the repository root" << std::endl;
+        return;
+    }
+
+    std::size_t mipBytes = 0;
+    for (int width = image.width, height = image.height; ; width = std::max(1, width / 2), height = std::max(1, height / 2))
+    {
+        mipBytes += static_cast<std::size_t>(width) * height * 4;
+        if (1 == width && 1 == height)
+            break;
+    }
+    GLTexture texture;
+    double decoded = timeGl([&]() { texture.loadFromFile(path); }, 1);
+    std::printf("texture loads, %s %dx%d\n", path.c_str(), image.width, image.height);
+    std::printf("%-22s %10.3f ms  %zu KiB in video memory\n", "bmp decoded", decoded * 1e-6, mipBytes / 1024);
+
+    for (bool compress : {false, true})
+    {
+        std::string baked = (std::filesystem::temp_directory_path() / (compress ? "glbench_bc1.stex" : "glbench_rgba8.stex")).string();
+        std::vector<unsigned char> bytes;
+        GLTextureContainer container;
+        if (!GLTextureContainer::sBake(image.pixels.data(), image.width, image.height, image.channels, compress, bytes)
+            || !GLUtils::sWriteFile(baked.c_str(), bytes) || !container.open(baked))
+        {
+            std::cerr << "glbench: failed to bake " << path << std::endl;
+            return;
+        }
+
+        bool loaded = true;
+        double ns = timeGl([&]() { loaded = texture.loadFromContainer(baked) && loaded; }, 1);
+        std::filesystem::remove(baked);
+        const char* name = compress ? "BC1 container" : "RGBA8 container";
+        if (loaded)
+            std::printf("%-22s %10.3f ms  %zu KiB in video memory, %s\n", name, ns * 1e-6, container.getDataSize() / 1024, ratio(decoded, ns).c_str());
+        else
+            std::printf("%-22s %10s     not supported by this driver\n", name, "-");
+    }
+}
+
+// RGBA8 textures from 64 to 4096 texels a side, uploaded straight from client memory and through the pixel unpack buffer.
+// Both include the mip generation and count the base level bytes, the unpack buffer path is timed until update() swaps the texture in
+static void benchTextureUploads()
+{
+    std::printf("texture uploads, RGBA8 with mips, best of 5\n");
+    for (int size = 64; size <= 4096; size *= 4)
+    {
+        GLTexture::s_Image image;
+        image.width = size;
+        image.height = size;
+        image.channels = 4;
+        image.pixels.resize(static_cast<std::size_t>(size) * size * 4);
+        for (std::size_t i = 0; i < image.pixels.size(); ++i)
+            image.pixels[i] = static_cast<unsigned char>(i * 2654435761u >> 24);
+
+        // enough uploads per run that the small sizes aren't just call overhead
+        std::size_t uploads = std::max<std::size_t>(1, std::min<std::size_t>(64, (1024 * 1024) / (static_cast<std::size_t>(size) * size)));
+        double bytes = static_cast<double>(image.pixels.size()) * uploads;
+
+        GLTexture texture;
+        double direct = timeGl([&]()
+        {
+            for (std::size_t i = 0; i < uploads; ++i)
+                texture.loadFromImage(image);
+        }, 1);
+
+        double unpack = 1e30;
+        for (int run = 0; run < 5; ++run)
+        {
+            std::vector<std::unique_ptr<GLTexture::s_Image>> copies;
+            for (std::size_t i = 0; i < uploads; ++i)
+                copies.push_back(std::make_unique<GLTexture::s_Image>(image));
+
+            glFinish();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (std::unique_ptr<GLTexture::s_Image>& copy : copies)
+            {
+                texture.setupAsync(std::move(copy));
+                while (!texture.update())
+                    ;
+            }
+            unpack = std::min(unpack, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%dx%d", size, size);
+        std::printf("%-22s %10.1f MiB/s direct  %10.1f MiB/s unpack buffer\n", name,
+            bytes / (direct * 1e-9) / (1024.0 * 1024.0), bytes / (unpack * 1e-9) / (1024.0 * 1024.0));
+    }
+}
+
+// copies of the model in a cube like scop --instances N places them, drawn with one instanced call per frame.
+// The rate at 60 fps is how many copies a frame can hold before it misses the refresh
+static void benchInstancing(s_Renderer& renderer, JobSystem& jobs)
+{
+    s_Scene scene;
+    GLBuffer instanceBuffer(GLBuffer::e_Type::Array);
+    GLShader* shader = renderer.shaders.get(static_cast<std::uint32_t>(e_ShaderFeature::Instanced));
+    if (!shader || !loadScene("resources/42.obj", jobs, scene) || !instanceBuffer.setup())
+    {
+        std::cerr << "glbench: failed to set up the instancing scene" << std::endl;
+        return;
+    }
+
+    const s_BoundingBox& box = scene.mesh.bbox;
+    float spacing = 1.5f * std::max({box.size.x, box.size.y, box.size.z});
+    std::printf("instancing, %zu triangles per copy\n", scene.mesh.info.faces.size() / 3);
+    for (unsigned int count : {1000u, 10000u, 100000u})
+    {
+        unsigned int side = 1;
+        while (side * side * side < count)
+            ++side;
+        float half = 0.5f * static_cast<float>(side - 1);
+        std::vector<s_Instance> instances(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float x = (static_cast<float>(i % side) - half) * spacing;
+            float y = (static_cast<float>((i / side) % side) - half) * spacing;
+            float z = (static_cast<float>(i / (side * side)) - half) * spacing;
+            instances[i].rows[0] = {1.f, 0.f, 0.f, x - box.center.x};
+            instances[i].rows[1] = {0.f, 1.f, 0.f, y - box.center.y};
+            instances[i].rows[2] = {0.f, 0.f, 1.f, z - box.center.z};
+            instances[i].color = {1.f, 1.f, 1.f, 1.f};
+        }
+
+        std::vector<s_VertexAttribute> attributes;
+        for (GLuint row = 0; row < 3; ++row)
+            attributes.push_back({3 + row, 4, GL_FLOAT, GL_FALSE, sizeof(s_Instance), offsetof(s_Instance, rows) + row * sizeof(s_vec4), 1});
+        attributes.push_back({6, 4, GL_FLOAT, GL_FALSE, sizeof(s_Instance), offsetof(s_Instance, color), 1});
+        if (!instanceBuffer.setData(instances, GL_DYNAMIC_DRAW) || !scene.vao.attachVertexBuffer(instanceBuffer, attributes))
+            return;
+
+        float extent = spacing * static_cast<float>(side);
+        s_FrameUniforms frame = frameUniforms({0.f, 0.f, 1.5f * extent}, {0.f, 0.f, 0.f}, 4.f * extent);
+        // a software renderer needs seconds for the largest grid, so fewer frames keep the section short there
+        const std::size_t frames = std::max<std::size_t>(1, 8000 / count);
+        double ns = timeGl([&]()
+        {
+            for (std::size_t i = 0; i < frames; ++i)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderer.frameBlock.update(frame);
+                shader->bind();
+                scene.vao.drawInstanced(static_cast<GLsizei>(count));
+                renderer.frameBlock.finishFrame();
+            }
+        }, frames);
+
+        double fps = 1e9 / ns;
+        char name[32];
+        std::snprintf(name, sizeof(name), "%u copies", count);
+        std::printf("%-22s %10.2f ms  %8.1f fps, %.3g instances/s, %.0f fit in a 60 fps frame\n", name, ns * 1e-6, fps, count * fps, count * fps / 60.0);
+    }
+}
+
+// a side x side grid of unit cubes, each its own object so the loader gives it its own index range
+static bool writeCubeGrid(const std::string& path, unsigned int side)
+{
+    std::ofstream file(path);
+    for (unsigned int i = 0; i < side * side && file; ++i)
+    {
+        float x = 2.f * static_cast<float>(i % side);
+        float y = 2.f * static_cast<float>(i / side);
+        file << "o cube" << i << '\n';
+        for (int corner = 0; corner < 8; ++corner)
+            file << "v " << x + (corner & 1) << ' ' << y + ((corner >> 1) & 1) << ' ' << ((corner >> 2) & 1) << '\n';
+        unsigned int base = i * 8 + 1;
+        static const unsigned int sFaces[12][3] = {
+            {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+            {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+        };
+        for (const unsigned int* face : sFaces)
+            file << "f " << base + face[0] << ' ' << base + face[1] << ' ' << base + face[2] << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+// 10000 objects as scop draws them, one multi draw call against one glDrawElements per object.
+// Only the cpu side is timed since that is what the single call saves, the gpu draws the same triangles either way
+static void benchMultiDraw(s_Renderer& renderer, JobSystem& jobs)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "glbench_cubes.obj").string();
+    s_Scene scene;
+    GLMultiDraw multiDraw;
+    GLShader* shader = renderer.shaders.get(static_cast<std::uint32_t>(e_ShaderFeature::None));
+    bool ready = shader && writeCubeGrid(path, 100) && loadScene(path, jobs, scene) && multiDraw.setup();
+    std::filesystem::remove(path);
+    if (!ready)
+    {
+        std::cerr << "glbench: failed to set up the multi draw scene" << std::endl;
+        return;
+    }
+
+    std::vector<GLMultiDraw::s_Command> commands;
+    for (const s_ObjectRange& object : scene.mesh.info.objects)
+        commands.push_back({object.indexCount, 1, object.firstIndex, 0, 0});
+    if (!multiDraw.setCommands(commands, GL_UNSIGNED_INT))
+        return;
+
+    s_FrameUniforms frame = frameUniforms({100.f, 100.f, 150.f}, {100.f, 100.f, 0.f}, 400.f);
+    renderer.frameBlock.update(frame);
+    shader->bind();
+    scene.vao.bind();
+    double separate = timeSubmit([&]()
+    {
+        for (const s_ObjectRange& object : scene.mesh.info.objects)
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(object.indexCount), GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(static_cast<std::size_t>(object.firstIndex) * sizeof(unsigned int)));
+    }, 1);
+    double combined = timeSubmit([&]() { multiDraw.draw(scene.vao); }, 1);
+    renderer.frameBlock.finishFrame();
+
+    std::printf("multi draw, %zu objects, %s\n", commands.size(), multiDraw.isIndirect() ? "indirect buffer" : "client arrays");
+    std::printf("%-22s %10.1f us  cpu submit per frame\n", "one call per object", separate * 1e-3);
+    std::printf("%-22s %10.1f us  cpu submit per frame, %s\n", "one multi draw", combined * 1e-3, ratio(separate, combined).c_str());
+}
+
+// what a hot reload of the teapot costs from the changed file to the finished upload. Moved vertices keep the faces, so the
+// loader keeps the old order and only the changed ranges are written: once for the lid pushed in as a whole and once for
+// every 16th vertex of the file. The moves stay inside the bounds, which the texture coordinates of every vertex follow.
+// Dropping a face changes the topology and every buffer is respecified like scop does then
+static bool benchReload(s_Scene& scene, JobSystem& jobs)
+{
+    std::ifstream source("resources/teapot.obj");
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(source, line);)
+        lines.push_back(line);
+    std::vector<std::string>::reverse_iterator lastFace = std::find_if(lines.rbegin(), lines.rend(), [](const std::string& line) { return 0 == line.rfind("f ", 0); });
+    std::string path = (std::filesystem::temp_directory_path() / "glbench_reload.obj").string();
+    auto writeLines = [&](const std::vector<std::string>& content)
+    {
+        std::ofstream file(path);
+        for (const std::string& line : content)
+            file << line << '\n';
+    };
+    if (lines.rend() == lastFace)
+    {
+        std::cerr << "glbench: resources/teapot.obj has no faces" << std::endl;
+        return false;
+    }
+
+    writeLines(lines);
+    if (!loadScene(path, jobs, scene))
+        return false;
+    const s_BoundingBox& box = scene.mesh.bbox;
+    float lidHeight = box.min.y + 0.8f * (box.max.y - box.min.y);
+
+    // moves the picked vertex lines a twentieth of the way to the center, the ones on the bounds are left where they are
+    auto moveVertices = [&](const std::function<bool(std::size_t, const s_vec3&)>& pick, std::size_t& count)
+    {
+        std::vector<std::string> edited = lines;
+        std::size_t index = 0;
+        count = 0;
+        for (std::string& line : edited)
+        {
+            if (0 != line.rfind("v ", 0))
+                continue;
+            s_vec3 v = {0.f, 0.f, 0.f};
+            std::sscanf(line.c_str(), "v %f %f %f", &v.x, &v.y, &v.z);
+            bool onBounds = v.x == box.min.x || v.y == box.min.y || v.z == box.min.z || v.x == box.max.x || v.y == box.max.y || v.z == box.max.z;
+            if (!pick(index++, v) || onBounds)
+                continue;
+            s_vec3 toCenter = Utils::sVec3Subtract(box.center, v);
+            v = Utils::sVec3Add(v, {0.05f * toCenter.x, 0.05f * toCenter.y, 0.05f * toCenter.z});
+            line = "v " + std::to_string(v.x) + ' ' + std::to_string(v.y) + ' ' + std::to_string(v.z);
+            ++count;
+        }
+        return edited;
+    };
+    std::size_t lidCount = 0;
+    std::size_t spreadCount = 0;
+    std::vector<std::string> lid = moveVertices([lidHeight](std::size_t, const s_vec3& v) { return v.y > lidHeight; }, lidCount);
+    std::vector<std::string> spread = moveVertices([](std::size_t index, const s_vec3&) { return 0 == index % 16; }, spreadCount);
+    std::vector<std::string> reshaped = lines;
+    reshaped.erase(reshaped.begin() + (lines.rend() - lastFace - 1));
+
+    std::printf("reload, %zu vertices and %zu triangles of resources/teapot.obj\n", scene.mesh.vertices.size(), scene.mesh.info.faces.size() / 3);
+    MeshLoader::s_Order order = {scene.mesh.fileFaces, scene.mesh.info.objects, scene.mesh.info.faces, scene.mesh.info.chunks};
+    s_MeshData next;
+    auto respecify = [&]()
+    {
+        scene.vbo.setData(next.vertices);
+        scene.ebo.setData(next.info.faces);
+    };
+
+    // the same check as scop, a move that misses the incremental path is a failure of the reload and not a number
+    auto benchMove = [&](const char* name, const std::vector<std::string>& edited, std::size_t moved)
+    {
+        writeLines(edited);
+        double parseNs = timeGl([&]() { next = MeshLoader::sLoad(path, jobs, nullptr, &order); }, 1);
+        bool sameTopology = next.info.faces == scene.mesh.info.faces && next.vertices.size() == scene.mesh.vertices.size();
+        if (!sameTopology)
+        {
+            std::fprintf(stderr, "glbench: %s changed the triangle order, the reload would respecify every buffer\n", name);
+            return false;
+        }
+        std::size_t rangeCount = 0;
+        double rangesNs = timeGl([&]()
+        {
+            rangeCount = 0;
+            Scop::smUploadChangedRanges(scene.vbo, scene.mesh.vertices, next.vertices, rangeCount);
+        }, 1);
+        double fullNs = timeGl(respecify, 1);
+        std::printf("%-22s %10.3f ms  parse of %zu moved vertices, triangle order kept\n", name, parseNs * 1e-6, moved);
+        std::printf("%-22s %10.3f ms  upload of %zu changed vertex ranges\n", "", rangesNs * 1e-6, rangeCount);
+        std::printf("%-22s %10.3f ms  upload with every buffer respecified, %s\n", "", fullNs * 1e-6, ratio(fullNs, rangesNs).c_str());
+        return true;
+    };
+    bool kept = benchMove("moved lid", lid, lidCount) && benchMove("moved every 16th", spread, spreadCount);
+
+    writeLines(reshaped);
+    double reshapedParseNs = timeGl([&]() { next = MeshLoader::sLoad(path, jobs, nullptr, &order); }, 1);
+    double reshapedNs = timeGl(respecify, 1);
+    std::filesystem::remove(path);
+    if (kept)
+    {
+        std::printf("%-22s %10.3f ms  parse with the triangles ordered again\n", "dropped face", reshapedParseNs * 1e-6);
+        std::printf("%-22s %10.3f ms  upload with every buffer respecified\n", "", reshapedNs * 1e-6);
+    }
+    return kept;
+}
+
+// rows of wall panels one behind the other, each panel a tessellated quad and its own object. Seen head on the first row
+// hides all the others, which is the case the occlusion queries are for
+static bool writeWallGrid(const std::string& path, unsigned int columns, unsigned int rows, unsigned int cells)
+{
+    std::ofstream file(path);
+    unsigned int base = 1;
+    for (unsigned int row = 0; row < rows && file; ++row)
+    {
+        for (unsigned int column = 0; column < columns; ++column)
+        {
+            file << "o wall" << row << '_' << column << '\n';
+            for (unsigned int y = 0; y <= cells; ++y)
+            {
+                for (unsigned int x = 0; x <= cells; ++x)
+                    file << "v " << 2.f * column + 2.f * x / cells - columns << ' ' << 2.f * y / cells - 1.f << ' ' << -2.f * row << '\n';
+            }
+            for (unsigned int y = 0; y < cells; ++y)
+            {
+                for (unsigned int x = 0; x < cells; ++x)
+                {
+                    unsigned int corner = base + y * (cells + 1) + x;
+                    file << "f " << corner << ' ' << corner + 1 << ' ' << corner + cells + 1 << '\n';
+                    file << "f " << corner + 1 << ' ' << corner + cells + 2 << ' ' << corner + cells + 1 << '\n';
+                }
+            }
+            base += (cells + 1) * (cells + 1);
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+static bool loadWalls(JobSystem& jobs, s_Scene& scene)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "glbench_walls.obj").string();
+    bool loaded = writeWallGrid(path, 4, 8, 32) && loadScene(path, jobs, scene);
+    std::filesystem::remove(path);
+    return loaded;
+}
+
+// scop's culling on the wall grid: frustum culled chunks merged into one multi draw, then with occlusion on the chunks
+// hidden in the last results are left to their box queries. A few frames run first so the queries have results to use
+static void benchOcclusion(s_Renderer& renderer, JobSystem& jobs)
+{
+    s_Scene scene;
+    GLMultiDraw multiDraw;
+    OcclusionCuller culler;
+    GLQuery primitives;
+    GLShader* shader = renderer.shaders.get(static_cast<std::uint32_t>(e_ShaderFeature::None));
+    if (!shader || !loadWalls(jobs, scene) || !multiDraw.setup() || !culler.setup(renderer.frameBlock.getBindingPoint())
+        || !culler.setChunks(scene.mesh.info.chunks) || !primitives.setup(1, GL_PRIMITIVES_GENERATED))
+    {
+        std::cerr << "glbench: failed to set up the wall scene" << std::endl;
+        return;
+    }
+
+    const std::vector<s_Chunk>& chunks = scene.mesh.info.chunks;
+    s_FrameUniforms frame = frameUniforms({0.f, 0.f, 3.f}, {0.f, 0.f, 0.f}, 40.f);
+    Frustum frustum;
+    std::vector<unsigned int> inFrustum;
+    std::vector<unsigned int> drawn;
+    std::vector<unsigned int> occluded;
+    std::size_t frustumTriangles = 0;
+    std::size_t submittedTriangles = 0;
+    auto drawFrame = [&](bool occlusion)
+    {
+        frustum.setup(frame.mvp);
+        frustum.cull(scene.mesh.chunkBvh, inFrustum);
+        std::sort(inFrustum.begin(), inFrustum.end());
+        culler.collect();
+        if (occlusion)
+            culler.split(inFrustum, drawn, occluded);
+        else
+        {
+            drawn = inFrustum;
+            occluded.clear();
+        }
+
+        frustumTriangles = 0;
+        for (unsigned int id : inFrustum)
+            frustumTriangles += chunks[id].indexCount / 3;
+        submittedTriangles = 0;
+        std::vector<GLMultiDraw::s_Command> commands;
+        for (unsigned int id : drawn)
+        {
+            submittedTriangles += chunks[id].indexCount / 3;
+            if (!commands.empty() && commands.back().firstIndex + commands.back().count == chunks[id].firstIndex)
+                commands.back().count += chunks[id].indexCount;
+            else
+                commands.push_back({chunks[id].indexCount, 1, chunks[id].firstIndex, 0, 0});
+        }
+        multiDraw.setCommands(commands, GL_UNSIGNED_INT);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.frameBlock.update(frame);
+        primitives.begin(0);
+        shader->bind();
+        multiDraw.draw(scene.vao);
+        if (occlusion)
+        {
+            culler.test(frame.mvp, inFrustum);
+            shader->bind();
+            culler.drawOccluded(scene.vao, chunks, occluded);
+        }
+        primitives.end();
+        renderer.frameBlock.finishFrame();
+    };
+
+    std::printf("occlusion, %zu triangles in %zu chunks of 4x8 wall panels\n", scene.mesh.info.faces.size() / 3, chunks.size());
+    double offNs = 0.0;
+    for (bool occlusion : {false, true})
+    {
+        culler.reset();
+        for (int warmup = 0; warmup < 8; ++warmup)
+        {
+            drawFrame(occlusion);
+            glFinish();
+        }
+        GLuint generated = 0;
+        primitives.poll(0, generated);
+        double ns = timeGl([&]() { drawFrame(occlusion); }, 1);
+        std::string note = std::to_string(submittedTriangles) + " of " + std::to_string(frustumTriangles) + " frustum triangles submitted, "
+            + std::to_string(generated) + " rasterized";
+        if (occlusion)
+            note += ", " + ratio(offNs, ns);
+        else
+            offNs = ns;
+        std::printf("%-22s %10.3f ms  %s\n", occlusion ? "occlusion on" : "occlusion off", ns * 1e-6, note.c_str());
+    }
+}
+
+// the wall grid drawn back to front with scop's blending shader, every panel row lands on the pixels of the one before.
+// Both modes are forced for a few frames each, DepthPrepass reads their fragment counts and gpu times like it does in scop
+static void benchDepthPrepass(s_Renderer& renderer, JobSystem& jobs)
+{
+    s_Scene scene;
+    DepthPrepass prepass;
+    GLShader* shader = renderer.shaders.get(static_cast<std::uint32_t>(e_ShaderFeature::Blend));
+    GLShader* depthShader = renderer.shaders.get(static_cast<std::uint32_t>(e_ShaderFeature::DepthOnly));
+    if (!shader || !depthShader || !loadWalls(jobs, scene) || !prepass.setup())
+    {
+        std::cerr << "glbench: failed to set up the depth pre-pass scene" << std::endl;
+        return;
+    }
+
+    s_FrameUniforms frame = frameUniforms({0.f, 0.f, 3.f}, {0.f, 0.f, 0.f}, 40.f);
+    frame.blend = 0.5f;
+    const std::vector<s_ObjectRange>& objects = scene.mesh.info.objects;
+    auto drawBackToFront = [&]()
+    {
+        for (std::vector<s_ObjectRange>::const_reverse_iterator object = objects.rbegin(); object != objects.rend(); ++object)
+            scene.vao.drawRange(object->firstIndex, static_cast<GLsizei>(object->indexCount));
+    };
+    auto drawFrame = [&](e_PrepassMode mode)
+    {
+        bool depthFirst = prepass.beginFrame(mode);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.frameBlock.update(frame);
+        (depthFirst ? depthShader : shader)->bind();
+        GLState::sColorMask(!depthFirst);
+        prepass.begin(depthFirst ? DepthPrepass::e_Pass::Depth : DepthPrepass::e_Pass::Shade);
+        drawBackToFront();
+        prepass.end();
+        if (depthFirst)
+        {
+            shader->bind();
+            GLState::sColorMask(true);
+            GLState::sDepthMask(false);
+            GLState::sDepthFunc(GL_EQUAL);
+            prepass.begin(DepthPrepass::e_Pass::Shade);
+            drawBackToFront();
+            prepass.end();
+            GLState::sDepthFunc(GL_LESS);
+            GLState::sDepthMask(true);
+        }
+        prepass.endFrame();
+        renderer.frameBlock.finishFrame();
+    };
+
+    std::string counted = prepass.countsInvocations() ? "fragment shader invocations" : "samples passed";
+    std::printf("depth pre-pass, %zu triangles drawn back to front, %s\n", scene.mesh.info.faces.size() / 3, counted.c_str());
+    double plainNs = 0.0;
+    for (e_PrepassMode mode : {e_PrepassMode::Off, e_PrepassMode::On})
+    {
+        bool on = e_PrepassMode::On == mode;
+        for (int warmup = 0; warmup < 8; ++warmup)
+        {
+            drawFrame(mode);
+            glFinish();
+        }
+        double ns = timeGl([&]() { drawFrame(mode); }, 1);
+        // one more frame reads the queries of the timed ones
+        drawFrame(mode);
+        glFinish();
+        const DepthPrepass::s_ModeStats& stats = prepass.getStats(on);
+        char note[160];
+        if (on)
+            std::snprintf(note, sizeof(note), "%.0f depth and %.0f shaded, %.3f ms gpu, %s", stats.depthFragments, stats.shadeFragments, stats.gpuMs, ratio(plainNs, ns).c_str());
+        else
+            std::snprintf(note, sizeof(note), "%.0f shaded, %.3f ms gpu", stats.shadeFragments, stats.gpuMs);
+        if (!on)
+            plainNs = ns;
+        std::printf("%-22s %10.3f ms  %s\n", on ? "pre-pass on" : "pre-pass off", ns * 1e-6, note);
+    }
+    std::printf("%-22s %10.2f     the auto mode turns the pre-pass on above 1.5\n", "overdraw", prepass.getOverdraw());
+}
+
+int main()
+{
+    try
+    {
+        GLContext context(4, 1);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLWindow window(256, 256, "glbench");
+        if (!GLContext::sInitGlad())
+            throw std::runtime_error("failed to initialize glad");
+
+        std::printf("%s, %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        benchUniforms();
+        benchProgramCache();
+        benchStateCache();
+        benchTextureLoads();
+        benchTextureUploads();
+
+        // the scene sections use scop's shaders, loader and fixtures, so they run from the repository root like scop
+        JobSystem jobs;
+        s_Renderer renderer;
+        if (!setupRenderer(renderer))
+            throw std::runtime_error("failed to build scop's shaders, run from the repository root");
+        GLState::sEnable(GL_DEPTH_TEST);
+        benchInstancing(renderer, jobs);
+        benchMultiDraw(renderer, jobs);
+        s_Scene teapot;
+        bool reloaded = benchReload(teapot, jobs);
+        benchOcclusion(renderer, jobs);
+        benchDepthPrepass(renderer, jobs);
+        if (!reloaded)
+            return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "glbench needs a window and a GL 4.1 context: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
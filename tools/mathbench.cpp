@@ -0,0 +1,677 @@
+#include "Bounds.hpp"
+#include "Bvh.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+#include "MeshLoader.hpp"
+#include "SceneGraph.hpp"
+#include "TriangleBvh.hpp"
+#include "TriangleOrder.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// the plain float kernels Utils used before the Simd backend, kept here as the reference every timing is compared to
+
+static s_mat4 scalarMat4Multiply(const s_mat4& a, const s_mat4& b)
+{
+    s_mat4 result = {};
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            result.m[row][col] = 0.f;
+            for (int k = 0; k < 4; ++k)
+                result.m[row][col] += a.m[row][k] * b.m[k][col];
+        }
+    }
+    return result;
+}
+
+static s_quat scalarQuatMultiply(const s_quat& a, const s_quat& b)
+{
+    return {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+    };
+}
+
+static s_quat scalarQuatNormalize(const s_quat& q)
+{
+    float len = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    s_quat result = q;
+    if (len > 0.f)
+    {
+        result.w /= len;
+        result.x /= len;
+        result.y /= len;
+        result.z /= len;
+    }
+    return result;
+}
+
+static void scalarBoundingBox(const std::vector<s_vec3>& vertices, s_vec3& min, s_vec3& max)
+{
+    min = vertices[0];
+    max = vertices[0];
+    for (const s_vec3& v : vertices)
+    {
+        min.x = std::min(min.x, v.x);
+        min.y = std::min(min.y, v.y);
+        min.z = std::min(min.z, v.z);
+        max.x = std::max(max.x, v.x);
+        max.y = std::max(max.y, v.y);
+        max.z = std::max(max.z, v.z);
+    }
+}
+
+static void scalarTransformPoints(const s_mat4& mat, const s_vec3* points, std::size_t count, s_vec4* out)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float in[4] = {points[i].x, points[i].y, points[i].z, 1.f};
+        float result[4] = {0.f, 0.f, 0.f, 0.f};
+        for (int row = 0; row < 4; ++row)
+            for (int col = 0; col < 4; ++col)
+                result[row] += mat.m[row][col] * in[col];
+        out[i] = {result[0], result[1], result[2], result[3]};
+    }
+}
+
+// the box of the eight transformed corners, what a box through a matrix costs without Arvo's method
+static s_Aabb scalarTransformBox(const s_mat4& mat, const s_Aabb& box)
+{
+    s_vec3 corners[8];
+    for (int i = 0; i < 8; ++i)
+        corners[i] = {(i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z};
+    s_vec4 transformed[8];
+    scalarTransformPoints(mat, corners, 8, transformed);
+
+    s_Aabb result = {{transformed[0].x, transformed[0].y, transformed[0].z}, {transformed[0].x, transformed[0].y, transformed[0].z}};
+    for (const s_vec4& p : transformed)
+    {
+        result.min = {std::min(result.min.x, p.x), std::min(result.min.y, p.y), std::min(result.min.z, p.z)};
+        result.max = {std::max(result.max.x, p.x), std::max(result.max.y, p.y), std::max(result.max.z, p.z)};
+    }
+    return result;
+}
+
+// draws the triangles in index order into a depth buffer from views spread evenly over a sphere, orthographic and fitted
+// to the mesh. The fragments that pass the depth test over the pixels covered is the overdraw early depth testing leaves
+// to the fragment shader, averaged over the views
+static double overdraw(const std::vector<s_vec3>& vertices, const std::vector<unsigned int>& faces, bool cullBackFaces)
+{
+    const unsigned int views = 32;
+    const int size = 256;
+    s_vec3 low = vertices[0];
+    s_vec3 high = vertices[0];
+    for (const s_vec3& v : vertices)
+    {
+        low = {std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z)};
+        high = {std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z)};
+    }
+    s_vec3 center = {0.5f * (low.x + high.x), 0.5f * (low.y + high.y), 0.5f * (low.z + high.z)};
+    float radius = 0.f;
+    for (const s_vec3& v : vertices)
+    {
+        s_vec3 offset = Utils::sVec3Subtract(v, center);
+        radius = std::max(radius, std::sqrt(Utils::sVec3Dot(offset, offset)));
+    }
+    float scale = 0.5f * size / std::max(radius, 1e-6f);
+
+    std::vector<float> depth(size * size);
+    std::vector<s_vec3> projected(vertices.size());
+    double total = 0.0;
+    for (unsigned int view = 0; view < views; ++view)
+    {
+        // a fibonacci spiral, the golden angle between views keeps them apart
+        float z = 1.f - 2.f * (view + 0.5f) / views;
+        float ring = std::sqrt(1.f - z * z);
+        float angle = 2.39996323f * view;
+        s_vec3 forward = {ring * std::cos(angle), ring * std::sin(angle), z};
+        s_vec3 right = Utils::sVec3Normalize(Utils::sVec3Cross(std::fabs(forward.y) < 0.9f ? s_vec3{0.f, 1.f, 0.f} : s_vec3{1.f, 0.f, 0.f}, forward));
+        s_vec3 up = Utils::sVec3Cross(forward, right);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            s_vec3 p = Utils::sVec3Subtract(vertices[i], center);
+            projected[i] = {Utils::sVec3Dot(p, right) * scale + 0.5f * size, Utils::sVec3Dot(p, up) * scale + 0.5f * size, Utils::sVec3Dot(p, forward)};
+        }
+
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+        std::size_t passed = 0;
+        std::size_t covered = 0;
+        for (std::size_t t = 0; t + 2 < faces.size(); t += 3)
+        {
+            const s_vec3& a = projected[faces[t]];
+            const s_vec3& b = projected[faces[t + 1]];
+            const s_vec3& c = projected[faces[t + 2]];
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (0.f == area || (cullBackFaces && 0.f < area))
+                continue;
+            int x0 = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+            int x1 = std::min(size - 1, static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))));
+            int y0 = std::max(0, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+            int y1 = std::min(size - 1, static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))));
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    float px = x + 0.5f;
+                    float py = y + 0.5f;
+                    float wa = ((c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x)) / area;
+                    float wb = ((a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x)) / area;
+                    float wc = 1.f - wa - wb;
+                    if (0.f > wa || 0.f > wb || 0.f > wc)
+                        continue;
+                    float fragment = wa * a.z + wb * b.z + wc * c.z;
+                    float& stored = depth[y * size + x];
+                    if (fragment >= stored)
+                        continue;
+                    if (std::numeric_limits<float>::max() == stored)
+                        ++covered;
+                    stored = fragment;
+                    ++passed;
+                }
+            }
+        }
+        total += covered ? static_cast<double>(passed) / static_cast<double>(covered) : 1.0;
+    }
+    return total / views;
+}
+
+// the order TriangleOrder would reach without chunks: every triangle of the object sorted by the same outward facing key
+static std::vector<unsigned int> objectSortedFaces(const s_InputFileLines& info)
+{
+    std::size_t count = info.faces.size() / 3;
+    std::vector<s_vec3> normals(count);
+    std::vector<s_vec3> centroids(count);
+    s_vec3 center = {0.f, 0.f, 0.f};
+    float totalArea = 0.f;
+    for (std::size_t t = 0; t < count; ++t)
+    {
+        const s_vec3& a = info.vertices[info.faces[t * 3]];
+        const s_vec3& b = info.vertices[info.faces[t * 3 + 1]];
+        const s_vec3& c = info.vertices[info.faces[t * 3 + 2]];
+        normals[t] = Utils::sVec3Cross(Utils::sVec3Subtract(b, a), Utils::sVec3Subtract(c, a));
+        centroids[t] = {(a.x + b.x + c.x) / 3.f, (a.y + b.y + c.y) / 3.f, (a.z + b.z + c.z) / 3.f};
+        float area = std::sqrt(Utils::sVec3Dot(normals[t], normals[t]));
+        center = {center.x + centroids[t].x * area, center.y + centroids[t].y * area, center.z + centroids[t].z * area};
+        totalArea += area;
+    }
+    if (0.f < totalArea)
+        center = {center.x / totalArea, center.y / totalArea, center.z / totalArea};
+
+    std::vector<float> keys(count);
+    for (std::size_t t = 0; t < count; ++t)
+        keys[t] = 0.f < Utils::sVec3Dot(normals[t], normals[t]) ? Utils::sVec3Dot(Utils::sVec3Subtract(centroids[t], center), Utils::sVec3Normalize(normals[t])) : 0.f;
+    std::vector<unsigned int> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&keys](unsigned int l, unsigned int r) { return keys[l] > keys[r]; });
+    std::vector<unsigned int> faces;
+    faces.reserve(info.faces.size());
+    for (unsigned int t : order)
+        faces.insert(faces.end(), &info.faces[t * 3], &info.faces[t * 3] + 3);
+    return faces;
+}
+
+// overdraw plain and with back faces culled, and the vertex cache miss ratio of one order
+struct s_OrderCost
+{
+    double overdraw;
+    double culled;
+    float acmr;
+};
+
+static s_OrderCost reportOverdraw(const char* name, const s_InputFileLines& info, const std::vector<unsigned int>& faces, const s_OrderCost* file, const char* note)
+{
+    s_OrderCost cost = {overdraw(info.vertices, faces, false), overdraw(info.vertices, faces, true), TriangleOrder::sCacheMissRatio(faces.data(), faces.size())};
+    std::printf("%-22s %9.3f  %9.3f culled  acmr %.3f", name, cost.overdraw, cost.culled, cost.acmr);
+    if (file)
+        std::printf("  x%.2f x%.2f x%.2f of file order", cost.overdraw / file->overdraw, cost.culled / file->culled, cost.acmr / file->acmr);
+    std::printf("%s\n", note);
+    return cost;
+}
+
+// the triangle orders the loader goes through, every one against the order of the file. Sorting the whole object is the
+// bound a cross chunk order could reach, at the cost of contiguous chunks
+static void benchOrders(s_InputFileLines info, JobSystem& jobs)
+{
+    s_OrderCost file = reportOverdraw("file order", info, info.faces, nullptr, "");
+    reportOverdraw("object sorted", info, objectSortedFaces(info), &file, ", chunks no longer contiguous");
+    Utils::sBuildChunks(info);
+    reportOverdraw("chunked", info, info.faces, &file, "");
+    TriangleOrder::sOptimize(info, 16, 0.75f, &jobs);
+    reportOverdraw("TriangleOrder", info, info.faces, &file, "");
+}
+
+// best of a few runs, in nanoseconds per item
+static double timeKernel(const std::function<void()>& kernel, std::size_t items)
+{
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        kernel();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / static_cast<double>(items));
+    }
+    return best;
+}
+
+static void report(const char* name, double scalarNs, double simdNs, float maxError)
+{
+    std::printf("%-22s scalar %8.2f ns  simd %8.2f ns  x%5.2f  max error %g\n", name, scalarNs, simdNs, scalarNs / simdNs, maxError);
+}
+
+static void reportRate(const char* name, double ns, const std::string& note)
+{
+    std::printf("%-22s %9.1f M/s  %s\n", name, 1e3 / ns, note.c_str());
+}
+
+static float matrixError(const s_mat4& a, const s_mat4& b)
+{
+    float error = 0.f;
+    for (int row = 0; row < 4; ++row)
+        for (int col = 0; col < 4; ++col)
+            error = std::max(error, std::fabs(a.m[row][col] - b.m[row][col]));
+    return error;
+}
+
+static float quatError(const s_quat& a, const s_quat& b)
+{
+    return std::max({std::fabs(a.w - b.w), std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z)});
+}
+
+int main(int argc, char* argv[])
+{
+    if (2 < argc)
+    {
+        std::cout << "to benchmark the math kernels use program like this\n ./mathbench [model.obj]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> range(-1.f, 1.f);
+
+    std::vector<s_vec3> vertices;
+    std::vector<s_vec3> meshVertices;
+    std::vector<unsigned int> meshFaces;
+    s_InputFileLines parsed; // in file order, before the loader reorders its faces
+    std::string source = "random points";
+    if (2 == argc)
+    {
+        try
+        {
+            parsed = Utils::sReadObj(argv[1]);
+            vertices = parsed.vertices;
+            meshVertices = parsed.vertices;
+            meshFaces = parsed.faces;
+            source = argv[1];
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (vertices.empty())
+    {
+        vertices.resize(1 << 20);
+        for (s_vec3& v : vertices)
+            v = {range(random), range(random), range(random)};
+    }
+    // enough points that one pass takes a measurable time
+    while (vertices.size() < (1u << 20))
+        vertices.insert(vertices.end(), vertices.begin(), vertices.end());
+
+    std::printf("backend %s, %zu vertices from %s\n", Simd::sBackend(), vertices.size(), source.c_str());
+
+    // mat4 multiply, chained so every product depends on the last one like the scene graph does
+    const std::size_t matrixCount = 1 << 20;
+    s_mat4 step = Utils::sMat4Multiply(Utils::sQuatToMat4(Utils::sQuatNormalize({0.9f, 0.1f, 0.2f, 0.3f})), Utils::sMat4Scale(1.f));
+    s_mat4 scalarChain = Utils::sMat4Identify();
+    s_mat4 simdChain = Utils::sMat4Identify();
+    double scalarNs = timeKernel([&]() { for (std::size_t i = 0; i < matrixCount; ++i) scalarChain = scalarMat4Multiply(scalarChain, step); }, matrixCount);
+    double simdNs = timeKernel([&]() { for (std::size_t i = 0; i < matrixCount; ++i) simdChain = Utils::sMat4Multiply(simdChain, step); }, matrixCount);
+    report("sMat4Multiply", scalarNs, simdNs, matrixError(scalarMat4Multiply(step, step), Utils::sMat4Multiply(step, step)));
+
+    // the key driven update: multiply the orientation by a small rotation and normalize
+    const std::size_t quatCount = 1 << 22;
+    s_quat spin = Utils::sQuatFromAxisAngle(Utils::sVec3Normalize({0.3f, 1.f, 0.2f}), 0.01f);
+    s_quat scalarOrientation = Utils::sQuatIdentify();
+    s_quat simdOrientation = Utils::sQuatIdentify();
+    scalarNs = timeKernel([&]() { for (std::size_t i = 0; i < quatCount; ++i) scalarOrientation = scalarQuatNormalize(scalarQuatMultiply(scalarOrientation, spin)); }, quatCount);
+    simdNs = timeKernel([&]() { for (std::size_t i = 0; i < quatCount; ++i) simdOrientation = Utils::sQuatNormalize(Utils::sQuatMultiply(simdOrientation, spin)); }, quatCount);
+    s_quat probe = {0.5f, -0.3f, 0.7f, 0.1f};
+    report("sQuatMultiply+Normalize", scalarNs, simdNs, quatError(scalarQuatNormalize(scalarQuatMultiply(probe, spin)), Utils::sQuatNormalize(Utils::sQuatMultiply(probe, spin))));
+
+    // bounding box, per vertex
+    s_vec3 scalarMin;
+    s_vec3 scalarMax;
+    s_BoundingBox box = {};
+    scalarNs = timeKernel([&]() { scalarBoundingBox(vertices, scalarMin, scalarMax); }, vertices.size());
+    simdNs = timeKernel([&]() { box = Utils::sComputeBoundingBoxAndScale(vertices); }, vertices.size());
+    float boxError = std::max({std::fabs(box.min.x - scalarMin.x), std::fabs(box.min.y - scalarMin.y), std::fabs(box.min.z - scalarMin.z),
+        std::fabs(box.max.x - scalarMax.x), std::fabs(box.max.y - scalarMax.y), std::fabs(box.max.z - scalarMax.z)});
+    report("sComputeBoundingBox", scalarNs, simdNs, boxError);
+
+    // batched transform, per point
+    std::vector<s_vec4> scalarOut(vertices.size());
+    std::vector<s_vec4> simdOut(vertices.size());
+    scalarNs = timeKernel([&]() { scalarTransformPoints(step, vertices.data(), vertices.size(), scalarOut.data()); }, vertices.size());
+    simdNs = timeKernel([&]() { Utils::sMat4TransformPoints(step, vertices.data(), vertices.size(), simdOut.data()); }, vertices.size());
+    float transformError = 0.f;
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        transformError = std::max({transformError, std::fabs(scalarOut[i].x - simdOut[i].x), std::fabs(scalarOut[i].y - simdOut[i].y),
+            std::fabs(scalarOut[i].z - simdOut[i].z), std::fabs(scalarOut[i].w - simdOut[i].w)});
+    }
+    report("sMat4TransformPoints", scalarNs, simdNs, transformError);
+
+    // bounds engine, in points or boxes per second since that is what the loader and the instance culling pay for
+    JobSystem jobs;
+    std::printf("bounds, %u threads\n", jobs.getThreadCount());
+    s_Aabb points;
+    double scalarPointsNs = timeKernel([&]() { scalarBoundingBox(vertices, scalarMin, scalarMax); }, vertices.size());
+    reportRate("box scalar", scalarPointsNs, "points");
+    double singleNs = timeKernel([&]() { Bounds::sPoints(vertices.data(), vertices.size(), points); }, vertices.size());
+    reportRate("Bounds::sPoints 1", singleNs, "points, x" + std::to_string(scalarPointsNs / singleNs));
+    double threadedNs = timeKernel([&]() { Bounds::sPoints(vertices.data(), vertices.size(), points, &jobs); }, vertices.size());
+    reportRate("Bounds::sPoints all", threadedNs, "points, x" + std::to_string(scalarPointsNs / threadedNs));
+
+    // one box through many matrices, the per instance case
+    std::vector<s_mat4> instanceMatrices(1 << 18);
+    for (std::size_t i = 0; i < instanceMatrices.size(); ++i)
+    {
+        instanceMatrices[i] = Utils::sMat4Multiply(Utils::sMat4Translate(range(random), range(random), range(random)),
+            Utils::sQuatToMat4(Utils::sQuatNormalize({range(random), range(random), range(random), range(random)})));
+    }
+    s_Aabb unitBox = {{-1.f, -0.5f, -0.25f}, {1.f, 0.5f, 0.25f}};
+    std::vector<s_Aabb> scalarBoxes(instanceMatrices.size());
+    std::vector<s_Aabb> boxes(instanceMatrices.size());
+    double cornersNs = timeKernel([&]() { for (std::size_t i = 0; i < instanceMatrices.size(); ++i) scalarBoxes[i] = scalarTransformBox(instanceMatrices[i], unitBox); },
+        instanceMatrices.size());
+    reportRate("box corners scalar", cornersNs, "boxes");
+    double arvoNs = timeKernel([&]() { Bounds::sTransform(instanceMatrices.data(), instanceMatrices.size(), unitBox, boxes.data(), &jobs); }, instanceMatrices.size());
+    float arvoError = 0.f;
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        arvoError = std::max({arvoError, std::fabs(boxes[i].min.x - scalarBoxes[i].min.x), std::fabs(boxes[i].min.y - scalarBoxes[i].min.y),
+            std::fabs(boxes[i].min.z - scalarBoxes[i].min.z), std::fabs(boxes[i].max.x - scalarBoxes[i].max.x),
+            std::fabs(boxes[i].max.y - scalarBoxes[i].max.y), std::fabs(boxes[i].max.z - scalarBoxes[i].max.z)});
+    }
+    reportRate("Bounds::sTransform", arvoNs, "boxes, x" + std::to_string(cornersNs / arvoNs) + " max error " + std::to_string(arvoError));
+
+    // spheres, a smaller radius culls more and the ratio to the box half diagonal shows how much
+    float halfDiagonal = 0.5f * std::sqrt((points.max.x - points.min.x) * (points.max.x - points.min.x)
+        + (points.max.y - points.min.y) * (points.max.y - points.min.y) + (points.max.z - points.min.z) * (points.max.z - points.min.z));
+    s_Sphere sphere = {};
+    double ritterNs = timeKernel([&]() { Bounds::sRitterSphere(vertices.data(), vertices.size(), sphere); }, vertices.size());
+    reportRate("Ritter sphere", ritterNs, "points, radius " + std::to_string(sphere.radius / halfDiagonal) + " of the box half diagonal");
+    for (unsigned int normals : {3u, 7u, 13u})
+    {
+        double eposNs = timeKernel([&]() { Bounds::sEposSphere(vertices.data(), vertices.size(), sphere, normals, &jobs); }, vertices.size());
+        std::string name = "EPOS-" + std::to_string(2 * normals) + " sphere";
+        reportRate(name.c_str(), eposNs, "points, radius " + std::to_string(sphere.radius / halfDiagonal) + " of the box half diagonal");
+    }
+
+    // 100K nodes in an 8-ary tree with 1% of them turned each frame, the dirty pass only revisits their subtrees.
+    // Turning the root dirties every node, which is what rebuilding every world matrix each frame costs
+    const int nodeCount = 100000;
+    const std::size_t frames = 100;
+    SceneGraph scene;
+    scene.reserve(nodeCount);
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        scene.createNode(0 == node ? SceneGraph::sNoParent : (node - 1) / 8);
+        scene.setTranslation(node, {range(random), range(random), range(random)});
+    }
+    scene.update();
+    std::uniform_int_distribution<int> pick(0, nodeCount - 1);
+    std::vector<int> changed(frames * nodeCount / 100);
+    for (int& node : changed)
+        node = pick(random);
+    float angle = 0.f;
+    std::size_t recomputed = 0;
+    double dirtyNs = timeKernel([&]()
+    {
+        recomputed = 0;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            angle += 0.01f;
+            for (std::size_t i = frame * nodeCount / 100; i < (frame + 1) * nodeCount / 100; ++i)
+                scene.setRotation(changed[i], Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, angle));
+            recomputed += scene.update();
+        }
+    }, frames);
+    double fullNs = timeKernel([&]()
+    {
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            angle += 0.01f;
+            scene.setRotation(0, Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, angle));
+            scene.update();
+        }
+    }, frames);
+    std::printf("%-22s %9.1f us  per frame, every node\n", "SceneGraph all dirty", fullNs * 1e-3);
+    std::printf("%-22s %9.1f us  per frame, %zu of %d nodes recomputed, x%.2f\n", "SceneGraph 1% dirty", dirtyNs * 1e-3,
+        recomputed / frames, nodeCount, fullNs / dirtyNs);
+
+    // 16K chunk boxes on a 128 x 128 field seen from its middle at 8 headings, about what a 4M triangle model splits into.
+    // The BVH drops whole subtrees outside the view and takes inside ones untested, the linear pass tests every box
+    const int field = 128;
+    std::vector<s_Aabb> chunks;
+    chunks.reserve(field * field);
+    for (int cell = 0; cell < field * field; ++cell)
+    {
+        s_vec3 min = {static_cast<float>(cell % field) * 4.f - 256.f, range(random) - 1.f, static_cast<float>(cell / field) * 4.f - 256.f};
+        chunks.push_back({min, {min.x + 4.f, min.y + 2.f, min.z + 4.f}});
+    }
+    Bvh bvh;
+    double buildNs = timeKernel([&]() { bvh.build(chunks); }, 1);
+    Frustum frustums[8];
+    for (int heading = 0; heading < 8; ++heading)
+    {
+        float angle = static_cast<float>(heading) * 0.785398f;
+        s_mat4 view = Utils::sMat4LookAt({0.f, 8.f, 0.f}, {std::sin(angle), 8.f, std::cos(angle)}, {0.f, 1.f, 0.f});
+        frustums[heading].setup(Utils::sMat4Multiply(Utils::sMat4Perspective(Utils::sRadiance(), 16.f / 9.f, 0.1f, 200.f), view));
+    }
+    std::vector<unsigned int> visible;
+    std::size_t bvhVisible = 0;
+    double bvhNs = timeKernel([&]()
+    {
+        bvhVisible = 0;
+        for (const Frustum& frustum : frustums)
+        {
+            frustum.cull(bvh, visible);
+            bvhVisible += visible.size();
+        }
+    }, 8);
+    std::size_t linearVisible = 0;
+    double linearNs = timeKernel([&]()
+    {
+        linearVisible = 0;
+        for (const Frustum& frustum : frustums)
+        {
+            visible.clear();
+            for (unsigned int id = 0; id < chunks.size(); ++id)
+                if (Frustum::e_Result::Outside != frustum.test(chunks[id].min, chunks[id].max))
+                    visible.push_back(id);
+            linearVisible += visible.size();
+        }
+    }, 8);
+    std::printf("%-22s %9.1f us  %zu chunk boxes\n", "Bvh build", buildNs * 1e-3, chunks.size());
+    std::printf("%-22s %9.1f us  per view, %zu of %zu chunks visible\n", "cull every box", linearNs * 1e-3, linearVisible / 8, chunks.size());
+    std::printf("%-22s %9.1f us  per view, %zu of %zu chunks visible, x%.2f\n", "cull through the Bvh", bvhNs * 1e-3, bvhVisible / 8, chunks.size(),
+        linearNs / bvhNs);
+
+    // picking, the tree is built once per loaded model and queried once per click. Without a model a wavy height field of
+    // 512K triangles stands in, every ray starts outside the bounds and aims at a random point inside them
+    std::string meshSource = source;
+    if (meshFaces.empty())
+    {
+        const unsigned int cells = 512;
+        meshVertices.clear();
+        for (unsigned int row = 0; row <= cells; ++row)
+        {
+            for (unsigned int column = 0; column <= cells; ++column)
+            {
+                float u = static_cast<float>(column) / cells;
+                float v = static_cast<float>(row) / cells;
+                meshVertices.push_back({u, 0.05f * std::sin(40.f * u) * std::cos(30.f * v), v});
+            }
+        }
+        for (unsigned int row = 0; row < cells; ++row)
+        {
+            for (unsigned int column = 0; column < cells; ++column)
+            {
+                unsigned int corner = row * (cells + 1) + column;
+                meshFaces.insert(meshFaces.end(), {corner, corner + cells + 1, corner + 1, corner + 1, corner + cells + 1, corner + cells + 2});
+            }
+        }
+        meshSource = "a height field";
+    }
+    TriangleBvh pickBvh;
+    double pickBuildNs = timeKernel([&]() { pickBvh.build(meshVertices, meshFaces); }, 1);
+    s_BoundingBox meshBox = Utils::sComputeBoundingBoxAndScale(meshVertices);
+    s_vec3 meshHalf = {0.5f * meshBox.size.x, 0.5f * meshBox.size.y, 0.5f * meshBox.size.z};
+    float meshRadius = std::sqrt(meshHalf.x * meshHalf.x + meshHalf.y * meshHalf.y + meshHalf.z * meshHalf.z);
+    const std::size_t rayCount = 1 << 16;
+    std::vector<s_vec3> rayOrigins(rayCount);
+    std::vector<s_vec3> rayDirections(rayCount);
+    for (std::size_t i = 0; i < rayCount; ++i)
+    {
+        s_vec3 away = Utils::sVec3Normalize({range(random), range(random), range(random)});
+        rayOrigins[i] = {meshBox.center.x + 2.f * meshRadius * away.x, meshBox.center.y + 2.f * meshRadius * away.y, meshBox.center.z + 2.f * meshRadius * away.z};
+        s_vec3 target = {meshBox.center.x + meshHalf.x * range(random), meshBox.center.y + meshHalf.y * range(random), meshBox.center.z + meshHalf.z * range(random)};
+        rayDirections[i] = Utils::sVec3Subtract(target, rayOrigins[i]);
+    }
+    std::size_t hits = 0;
+    double queryNs = timeKernel([&]()
+    {
+        hits = 0;
+        TriangleBvh::s_Hit hit;
+        for (std::size_t i = 0; i < rayCount; ++i)
+            hits += pickBvh.intersect(rayOrigins[i], rayDirections[i], hit) ? 1 : 0;
+    }, rayCount);
+    std::printf("%-22s %9.1f ms  %zu triangles of %s, %zu nodes\n", "TriangleBvh build", pickBuildNs * 1e-6, pickBvh.getTriangleCount(),
+        meshSource.c_str(), pickBvh.getNodeCount());
+    std::printf("%-22s %9.2f us  per ray, %.0f%% of them hit\n", "TriangleBvh query", queryNs * 1e-3, 100.0 * static_cast<double>(hits) / rayCount);
+
+    // scop's per frame math while a key turns the model. Rebuilt is every matrix from its inputs each frame, like before the
+    // scene graph and the view cache, with the key rotation and light direction computed at run time. Cached is what scop does
+    // now: a folded key rotation, a two node graph update and one multiply against the cached view projection
+    volatile float keyStep = 0.01f;
+    constexpr s_quat keyRotation = Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, 0.01f);
+    constexpr s_vec3 lightDir = Utils::sVec3Normalize({0.5f, 1.f, 0.3f});
+    const s_vec3 center = {0.2f, -0.1f, 0.3f};
+    s_quat orientation = Utils::sQuatIdentify();
+    s_mat4 frameSink = Utils::sMat4Identify();
+    s_vec3 lightSink = {};
+    double rebuiltNs = timeKernel([&]()
+    {
+        for (std::size_t frame = 0; frame < matrixCount; ++frame)
+        {
+            orientation = Utils::sQuatMultiply(orientation, Utils::sQuatFromAxisAngle({0.f, 1.f, 0.f}, keyStep));
+            s_mat4 view = Utils::sMat4LookAt({0.f, 0.f, 3.f}, center, {0.f, 1.f, 0.f});
+            s_mat4 proj = Utils::sMat4Perspective(Utils::sRadiance(), 1.f, 0.01f, 100.f);
+            s_mat4 model = Utils::sMat4Multiply(Utils::sMat4Translate(center.x, center.y, center.z), Utils::sMat4Multiply(Utils::sQuatToMat4(orientation),
+                Utils::sMat4Multiply(Utils::sMat4Scale(0.5f), Utils::sMat4Translate(-center.x, -center.y, -center.z))));
+            s_mat4 mvp = Utils::sMat4Multiply(proj, Utils::sMat4Multiply(view, model));
+            frameSink = Utils::sMat4Multiply(mvp, Utils::sMat4NormalMatrix(model));
+            lightSink = Utils::sVec3Normalize({0.5f, 1.f, keyStep * 30.f});
+        }
+    }, matrixCount);
+    SceneGraph frameScene;
+    int pivot = frameScene.createNode();
+    int model = frameScene.createNode(pivot);
+    frameScene.setTranslation(pivot, center);
+    frameScene.setScale(pivot, 0.5f);
+    frameScene.setTranslation(model, {-center.x, -center.y, -center.z});
+    s_mat4 viewProj = Utils::sMat4Multiply(Utils::sMat4Perspective(Utils::sRadiance(), 1.f, 0.01f, 100.f), Utils::sMat4LookAt({0.f, 0.f, 3.f}, center, {0.f, 1.f, 0.f}));
+    double cachedNs = timeKernel([&]()
+    {
+        for (std::size_t frame = 0; frame < matrixCount; ++frame)
+        {
+            orientation = Utils::sQuatMultiply(orientation, keyRotation);
+            frameScene.setRotation(pivot, orientation);
+            frameScene.update();
+            const s_mat4& world = frameScene.getWorld(model);
+            frameSink = Utils::sMat4Multiply(Utils::sMat4Multiply(viewProj, world), Utils::sMat4NormalMatrix(world));
+            lightSink = lightDir;
+        }
+    }, matrixCount);
+    std::printf("%-22s %9.1f ns  per frame\n", "frame math rebuilt", rebuiltNs);
+    std::printf("%-22s %9.1f ns  per frame, x%.2f\n", "frame math cached", cachedNs, rebuiltNs / cachedNs);
+
+    // the triangle orders on 64 overlapping spheres drawn one after the other, then on the model
+    s_InputFileLines ordered;
+    const unsigned int rings = 16;
+    const unsigned int segments = 32;
+    for (unsigned int sphere = 0; sphere < 64; ++sphere)
+    {
+        s_vec3 center = {range(random), range(random), range(random)};
+        unsigned int base = static_cast<unsigned int>(ordered.vertices.size());
+        for (unsigned int ring = 0; ring <= rings; ++ring)
+        {
+            float polar = 3.14159265f * ring / rings;
+            for (unsigned int segment = 0; segment <= segments; ++segment)
+            {
+                float azimuth = 2.f * 3.14159265f * segment / segments;
+                ordered.vertices.push_back({center.x + 0.4f * std::sin(polar) * std::cos(azimuth), center.y + 0.4f * std::cos(polar),
+                    center.z + 0.4f * std::sin(polar) * std::sin(azimuth)});
+            }
+        }
+        for (unsigned int ring = 0; ring < rings; ++ring)
+        {
+            for (unsigned int segment = 0; segment < segments; ++segment)
+            {
+                unsigned int corner = base + ring * (segments + 1) + segment;
+                ordered.faces.insert(ordered.faces.end(), {corner, corner + 1, corner + segments + 1, corner + 1, corner + segments + 2, corner + segments + 1});
+            }
+        }
+    }
+    ordered.objects.push_back({"spheres", 0, static_cast<unsigned int>(ordered.faces.size())});
+    std::printf("overdraw, %zu triangles of 64 overlapping spheres, 32 views, plain and with back faces culled\n", ordered.faces.size() / 3);
+    benchOrders(std::move(ordered), jobs);
+    if (2 == argc)
+    {
+        std::printf("overdraw, %zu triangles of %s\n", parsed.faces.size() / 3, source.c_str());
+        benchOrders(std::move(parsed), jobs);
+    }
+
+    // the whole load pipeline on growing pools, each stage prints its own wall time and the total is compared to 1 thread
+    if (2 == argc)
+    {
+        // one untimed load first, so the file is in the page cache for every run
+        JobSystem warmJobs(1);
+        MeshLoader::sLoad(argv[1], warmJobs);
+        double serialMs = 0.0;
+        for (unsigned int threads : {1u, 4u, 8u, 16u})
+        {
+            JobSystem loadJobs(threads);
+            MeshLoader::s_Times times;
+            MeshLoader::sLoad(argv[1], loadJobs, &times);
+            MeshLoader::sPrintTimes(times, threads);
+            if (1 == threads)
+                serialMs = times.total;
+            std::printf("%-22s x%.2f against 1 thread\n", "load speedup", serialMs / times.total);
+        }
+    }
+
+    // keeps the chained results alive so the loops above are not dropped
+    std::printf("checksum %g %g %g %g\n", matrixError(scalarChain, simdChain), quatError(scalarOrientation, simdOrientation),
+        frameSink.m[0][0], lightSink.y);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "GLTextureContainer.hpp"
+#include "GLUtils.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    if (3 != argc && 4 != argc)
+    {
+        std::cout << "to bake a texture use program like this\n ./texbake IMAGE.bmp OUT.stex [--bc1]" << std::endl;
+        return 1;
+    }
+
+    bool compress = 4 == argc && std::string(argv[3]) == "--bc1";
+    if (4 == argc && !compress)
+    {
+        std::cerr << "unknown option: " << argv[3] << std::endl;
+        return 1;
+    }
+
+    std::vector<unsigned char> file;
+    if (!GLUtils::sReadTexture(argv[1], file))
+        return 1;
+
+    // same orientation as GLTexture::sDecode so baked and decoded textures line up
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 0);
+    if (!pixels)
+    {
+        std::cerr << "failed to decode image: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<unsigned char> container;
+    bool baked = GLTextureContainer::sBake(pixels, width, height, channels, compress, container);
+    stbi_image_free(pixels);
+    if (!baked || !GLUtils::sWriteFile(argv[2], container))
+    {
+        std::cerr << "failed to bake " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[1] << " -> " << argv[2] << " (" << width << "x" << height << ", "
+        << (compress ? "BC1" : "RGBA8") << ", " << container.size() << " bytes)" << std::endl;
+    return 0;
+}
\ No newline at end of file